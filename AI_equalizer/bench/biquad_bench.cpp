@@ -0,0 +1,215 @@
+// Times BiquadBank against the per-sample, per-band BiquadFilter it
+// replaced, on the layouts the engine runs, and checks that both agree.
+//
+//   biquad_bench [seconds per case]
+//
+// Prints ns per frame for each and the speedup. Exits non-zero if the
+// outputs differ by more than float rounding.
+
+#include "biquadkernel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+constexpr double SAMPLE_RATE = 48000.0;
+constexpr int BUFFER_FRAMES = 1024;
+// The reference rounds every section's output to float
+constexpr double MAX_DIFFERENCE = 1e-3;
+
+// The filter processBuffer() ran before BiquadBank, unchanged: direct form I,
+// float I/O, per-sample denormal checks and clamp
+class ReferenceFilter {
+public:
+    void setCoefficients(const BiquadCoefficients& c)
+    {
+        b0 = c.b0; b1 = c.b1; b2 = c.b2; a1 = c.a1; a2 = c.a2;
+    }
+
+    float process(float input)
+    {
+        if (std::abs(input) < 1e-15f) input = 0.0f;
+        float output = b0 * input + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        if (std::abs(output) < 1e-15f) output = 0.0f;
+        output = std::max(-10.0f, std::min(10.0f, output));
+        x2 = x1;
+        x1 = input;
+        y2 = y1;
+        y1 = output;
+        return output;
+    }
+
+private:
+    double b0{1.0}, b1{0.0}, b2{0.0}, a1{0.0}, a2{0.0};
+    double x1{0.0}, x2{0.0}, y1{0.0}, y2{0.0};
+};
+
+struct Case {
+    const char* name;
+    int bands;
+    int channels;
+    double firstFrequency;
+    double ratio;  // Between neighbouring band centres
+};
+
+const Case CASES[] = {
+    {"graphic10 stereo", 10, 2, 31.25, 2.0},
+    {"graphic31 stereo", 31, 2, 20.0, std::pow(2.0, 1.0 / 3.0)},
+    {"graphic10 mono", 10, 1, 31.25, 2.0},
+    {"graphic10 5.1", 10, 6, 31.25, 2.0},
+    {"graphic10 7.1", 10, 8, 31.25, 2.0},
+};
+
+std::vector<BiquadCoefficients> design(const Case& c)
+{
+    std::vector<BiquadCoefficients> coefficients;
+    double frequency = c.firstFrequency;
+    for (int band = 0; band < c.bands; ++band) {
+        // Every band active, alternating boost and cut
+        const double gain = (band % 2 ? -1.0 : 1.0) * (2.0 + band % 5);
+        coefficients.push_back(BiquadCoefficients::peakingEQ(frequency, SAMPLE_RATE, gain, 1.41));
+        frequency *= c.ratio;
+    }
+    return coefficients;
+}
+
+void fillSignal(std::vector<float>& buffer, int channels, int offset)
+{
+    const int frames = static_cast<int>(buffer.size()) / channels;
+    for (int frame = 0; frame < frames; ++frame) {
+        const double t = (offset + frame) / SAMPLE_RATE;
+        for (int ch = 0; ch < channels; ++ch) {
+            buffer[frame * channels + ch] = static_cast<float>(
+                0.3 * std::sin(2.0 * M_PI * (110.0 + 40.0 * ch) * t) + 0.1 * std::sin(2.0 * M_PI * 5000.0 * t));
+        }
+    }
+}
+
+// The old processBuffer() loop: per frame, every band on every channel.
+// The channel count is a constant there, as in its stereo and mono loops.
+template <int Channels>
+void runReference(ReferenceFilter* filters, int bandCount, float* buffer)
+{
+    for (int frame = 0; frame < BUFFER_FRAMES; ++frame) {
+        float samples[Channels];
+        std::copy(buffer + frame * Channels, buffer + (frame + 1) * Channels, samples);
+        for (int band = 0; band < bandCount; ++band) {
+            for (int ch = 0; ch < Channels; ++ch) {
+                samples[ch] = filters[band * Channels + ch].process(samples[ch]);
+            }
+        }
+        std::copy(samples, samples + Channels, buffer + frame * Channels);
+    }
+}
+
+void runReference(std::vector<ReferenceFilter>& filters, const Case& c, float* buffer)
+{
+    switch (c.channels) {
+    case 1:
+        runReference<1>(filters.data(), c.bands, buffer);
+        break;
+    case 2:
+        runReference<2>(filters.data(), c.bands, buffer);
+        break;
+    case 6:
+        runReference<6>(filters.data(), c.bands, buffer);
+        break;
+    default:
+        runReference<8>(filters.data(), c.bands, buffer);
+        break;
+    }
+}
+
+// Runs `process` over fresh buffers for about `seconds`; returns ns per frame
+template <class Process>
+double timePerFrame(int channels, double seconds, Process process)
+{
+    using Clock = std::chrono::steady_clock;
+    std::vector<float> buffer(BUFFER_FRAMES * channels);
+    fillSignal(buffer, channels, 0);
+    long long frames = 0;
+    double elapsed = 0.0;
+    while (elapsed < seconds) {
+        const auto start = Clock::now();
+        for (int i = 0; i < 64; ++i) {
+            process(buffer.data());
+        }
+        elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        frames += 64LL * BUFFER_FRAMES;
+    }
+    return elapsed * 1e9 / frames;
+}
+
+double maxDifference(const Case& c, const std::vector<BiquadCoefficients>& coefficients)
+{
+    std::vector<ReferenceFilter> filters(c.bands * c.channels);
+    BiquadBank bank;
+    std::vector<int> bands(c.bands);
+    for (int band = 0; band < c.bands; ++band) {
+        bands[band] = band;
+        bank.setCoefficients(band, coefficients[band]);
+        for (int ch = 0; ch < c.channels; ++ch) {
+            filters[band * c.channels + ch].setCoefficients(coefficients[band]);
+        }
+    }
+
+    double worst = 0.0;
+    std::vector<float> reference(BUFFER_FRAMES * c.channels);
+    std::vector<float> output(reference.size());
+    for (int buffer = 0; buffer < 16; ++buffer) {
+        fillSignal(reference, c.channels, buffer * BUFFER_FRAMES);
+        output = reference;
+        bank.process(bands.data(), c.bands, output.data(), BUFFER_FRAMES, c.channels);
+        runReference(filters, c, reference.data());
+        for (size_t i = 0; i < reference.size(); ++i) {
+            worst = std::max(worst, static_cast<double>(std::abs(reference[i] - output[i])));
+        }
+    }
+    return worst;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const double seconds = argc > 1 ? std::atof(argv[1]) : 0.5;
+    bool agree = true;
+
+    std::printf("%-18s %14s %14s %9s %12s\n", "case", "reference ns", "bank ns", "speedup", "max diff");
+    for (const Case& c : CASES) {
+        const std::vector<BiquadCoefficients> coefficients = design(c);
+
+        std::vector<ReferenceFilter> filters(c.bands * c.channels);
+        for (int band = 0; band < c.bands; ++band) {
+            for (int ch = 0; ch < c.channels; ++ch) {
+                filters[band * c.channels + ch].setCoefficients(coefficients[band]);
+            }
+        }
+        const double reference = timePerFrame(c.channels, seconds, [&](float* buffer) {
+            runReference(filters, c, buffer);
+        });
+
+        BiquadBank bank;
+        std::vector<int> bands(c.bands);
+        for (int band = 0; band < c.bands; ++band) {
+            bands[band] = band;
+            bank.setCoefficients(band, coefficients[band]);
+        }
+        const double optimized = timePerFrame(c.channels, seconds, [&](float* buffer) {
+            bank.process(bands.data(), c.bands, buffer, BUFFER_FRAMES, c.channels);
+        });
+
+        const double difference = maxDifference(c, coefficients);
+        agree = agree && difference <= MAX_DIFFERENCE;
+        std::printf("%-18s %14.2f %14.2f %8.2fx %12.2g\n", c.name, reference, optimized,
+                    reference / optimized, difference);
+    }
+
+    if (!agree) {
+        std::fprintf(stderr, "BiquadBank output differs from the reference filter\n");
+        return 1;
+    }
+    return 0;
+}
@@ -49,7 +49,6 @@ create_virtual_sink() {
     pactl load-module module-null-sink \
         sink_name=Equalizer_Input \
         sink_properties=device.description="Equalizer_Input" \
-        rate=44100 \
         channels=2
     
     echo "✓ Virtual sink 'Equalizer_Input' created"
@@ -0,0 +1,323 @@
+#include "AudioController.h"
+#include <QDebug>
+#include <algorithm>
+
+AudioController::AudioController(EqualizerViewModel* model, QObject *parent)
+        : QObject(parent), m_model(model), m_equalizer(nullptr), m_audioProcessor(nullptr)
+{
+    // Connect to model changes; each becomes a command for the audio thread
+    connect(m_model, &EqualizerViewModel::bandGainChanged,
+            this, &AudioController::onModelBandGainChanged);
+    connect(m_model, &EqualizerViewModel::allGainsChanged,
+            this, &AudioController::onModelAllGainsChanged);
+    connect(m_model, &EqualizerViewModel::bypassChanged,
+            this, &AudioController::onModelBypassChanged);
+    connect(m_model, &EqualizerViewModel::linearPhaseChanged,
+            this, &AudioController::onModelLinearPhaseChanged);
+    connect(m_model, &EqualizerViewModel::multirateChanged,
+            this, &AudioController::onModelMultirateChanged);
+    connect(m_model, &EqualizerViewModel::smoothGainsChanged,
+            this, &AudioController::onModelSmoothGainsChanged);
+    connect(m_model, &EqualizerViewModel::layoutChanged,
+            this, &AudioController::onModelLayoutChanged);
+    connect(m_model, &EqualizerViewModel::bandConfigChanged,
+            this, &AudioController::onModelBandConfigChanged);
+    connect(m_model, &EqualizerViewModel::latencyTargetChanged,
+            this, &AudioController::onModelLatencyTargetChanged);
+    
+    m_gainFlushTimer.setSingleShot(true);
+    m_gainFlushTimer.setInterval(GAIN_FLUSH_MS);
+    connect(&m_gainFlushTimer, &QTimer::timeout, this, &AudioController::onGainFlushTimeout);
+    
+    // The audio thread only publishes atomics; nothing is signalled from it
+    m_statsTimer.setInterval(AudioProcessor::LATENCY_REPORT_MS);
+    connect(&m_statsTimer, &QTimer::timeout, this, &AudioController::onStatsTimeout);
+}
+
+AudioController::~AudioController()
+{
+    stopAudio();
+}
+
+void AudioController::startAudio()
+{
+    if (m_audioProcessor) {
+        // Warm restart
+        if (m_audioProcessor->isRunning()) {
+            return;
+        }
+        if (!m_audioProcessor->start()) {
+            emit errorOccurred("Failed to restart audio processor: " + m_audioProcessor->getLastError());
+            return;
+        }
+        setActive(true);
+        emit audioStarted();
+        return;
+    }
+
+    m_equalizer = new EqualizerEngine();
+    m_audioProcessor = new AudioProcessor(m_equalizer);
+    m_audioProcessor->setLevelMeter(&m_levelMeter);
+    configureFromEnvironment();
+
+    // Initialize with current model state. post() folds these into the
+    // engine control thread's pending slots; start() flushes them before the
+    // audio thread runs, so the first block already has them
+    m_audioProcessor->post(EqualizerEngine::Command::setLayout(m_model->layout(), m_model->getBandGains()));
+    m_audioProcessor->post(EqualizerEngine::Command::setBypass(m_model->isBypassed()));
+    applyMode();
+    m_audioProcessor->setLatencyTargetMs(m_model->latencyTargetMs());
+    // Emitted on the audio thread, handled here
+    connect(m_audioProcessor, &AudioProcessor::streamEnded,
+            this, &AudioController::onStreamEnded, Qt::QueuedConnection);
+
+    // Connecting to the sound server blocks briefly; the audio thread starts
+    // once the streams are open
+    if (!m_audioProcessor->start()) {
+        emit errorOccurred("Failed to start audio processor");
+        delete m_audioProcessor;
+        delete m_equalizer;
+        m_audioProcessor = nullptr;
+        m_equalizer = nullptr;
+        return;
+    }
+
+    setActive(true);
+    emit audioStarted();
+    qDebug() << "Audio started";
+}
+
+void AudioController::suspendAudio()
+{
+    if (!m_audioProcessor || !m_audioProcessor->isRunning()) {
+        return;
+    }
+    m_audioProcessor->suspend();
+    setActive(false);
+    emit audioStopped();
+}
+
+void AudioController::stopAudio()
+{
+    if (!m_audioProcessor) {
+        return;
+    }
+    setActive(false);
+    m_audioProcessor->stop();
+    delete m_audioProcessor;
+    delete m_equalizer;
+    m_audioProcessor = nullptr;
+    m_equalizer = nullptr;
+
+    emit audioStopped();
+    qDebug() << "Audio stopped";
+}
+
+void AudioController::setActive(bool active)
+{
+    m_active = active;
+    if (active) {
+        m_statsTimer.start();
+    } else {
+        m_statsTimer.stop();
+    }
+    // For status queries
+    m_model->setAudioRunning(active);
+}
+
+void AudioController::configureFromEnvironment()
+{
+    // Surround deployments: AI_EQ_CHANNELS=6 (5.1) or 8 (7.1)
+    const int channels = qEnvironmentVariableIntValue("AI_EQ_CHANNELS");
+    if (channels > 0) {
+        m_audioProcessor->setChannelCount(channels);
+    }
+
+    // AI_EQ_RATE=48000 overrides the devices' own rate
+    const int rate = qEnvironmentVariableIntValue("AI_EQ_RATE");
+    if (rate > 0) {
+        m_audioProcessor->setSampleRate(rate);
+    }
+
+    // Backend specs, e.g. AI_EQ_CAPTURE=parec or file:in.wav, AI_EQ_SINK=null
+    const QString captureSpec = qEnvironmentVariable("AI_EQ_CAPTURE");
+    if (!captureSpec.isEmpty()) {
+        m_audioProcessor->setCaptureBackend(captureSpec);
+    }
+    const QString sinkSpec = qEnvironmentVariable("AI_EQ_SINK");
+    if (!sinkSpec.isEmpty()) {
+        m_audioProcessor->setSinkBackend(sinkSpec);
+    }
+
+    // Real-time audio thread: AI_EQ_REALTIME=<SCHED_FIFO priority>, and
+    // optionally AI_EQ_CPU=<core> to pin it
+    const int priority = qEnvironmentVariableIntValue("AI_EQ_REALTIME");
+    if (priority > 0) {
+        RealtimeConfig config;
+        config.enabled = true;
+        config.priority = std::min(priority, 99);
+        bool ok = false;
+        const int cpu = qEnvironmentVariableIntValue("AI_EQ_CPU", &ok);
+        config.cpu = ok ? cpu : -1;
+        m_audioProcessor->setRealtimeConfig(config);
+    }
+}
+
+void AudioController::onStreamEnded()
+{
+    // A finite input was played out, or a device went away
+    if (!m_audioProcessor) {
+        return;
+    }
+    if (!m_audioProcessor->getLastError().isEmpty()) {
+        emit errorOccurred(m_audioProcessor->getLastError());
+    }
+    stopAudio();
+}
+
+void AudioController::onStatsTimeout()
+{
+    if (!m_audioProcessor) {
+        return;
+    }
+    AudioStats stats;
+    stats.driftPpm = m_audioProcessor->driftPpm();
+    stats.underruns = m_audioProcessor->underruns();
+    if (stats.underruns > m_loggedUnderruns) {
+        qDebug() << "Underrun:" << stats.underruns - m_loggedUnderruns << "new,"
+                 << stats.underruns << "since start";
+    }
+    m_loggedUnderruns = stats.underruns;
+    const RingBuffer::Stats queue = m_audioProcessor->queueStats();
+    stats.droppedFrames = queue.droppedOldest + queue.droppedNewest;
+    m_model->setAudioStats(stats);
+    m_model->setMeasuredLatencyMs(m_audioProcessor->measuredLatencyMs());
+}
+
+void AudioController::onModelBandGainChanged(int band, double gain)
+{
+    Q_UNUSED(band);
+    Q_UNUSED(gain);
+    scheduleGainFlush();
+}
+
+void AudioController::onModelAllGainsChanged(const QVector<double>& gains)
+{
+    Q_UNUSED(gains);
+    scheduleGainFlush();
+}
+
+void AudioController::scheduleGainFlush()
+{
+    if (!m_audioProcessor) {
+        return;
+    }
+    if (m_gainFlushTimer.isActive()) {
+        m_gainsPending = true;
+        return;
+    }
+    flushGains();
+    m_gainFlushTimer.start();
+}
+
+void AudioController::onGainFlushTimeout()
+{
+    if (m_gainsPending) {
+        flushGains();
+        m_gainFlushTimer.start();
+    }
+}
+
+void AudioController::flushGains()
+{
+    // The model holds the latest value of every band; the engine only
+    // redesigns the bands that differ
+    m_gainsPending = false;
+    if (m_audioProcessor) {
+        m_audioProcessor->post(EqualizerEngine::Command::setAllGains(m_model->getBandGains()));
+    }
+}
+
+void AudioController::onModelBypassChanged(bool enabled)
+{
+    if (m_audioProcessor) {
+        m_audioProcessor->post(EqualizerEngine::Command::setBypass(enabled));
+        qDebug() << "EQ bypass:" << (enabled ? "on" : "off");
+    }
+}
+
+void AudioController::onModelLinearPhaseChanged(bool enabled)
+{
+    Q_UNUSED(enabled);
+    applyMode();
+}
+
+void AudioController::onModelMultirateChanged(bool enabled)
+{
+    Q_UNUSED(enabled);
+    applyMode();
+}
+
+void AudioController::onModelSmoothGainsChanged(bool enabled)
+{
+    Q_UNUSED(enabled);
+    applyMode();
+}
+
+void AudioController::applyMode()
+{
+    if (!m_audioProcessor) {
+        return;
+    }
+    // Linear phase takes precedence over multirate, both over smooth gains
+    EqualizerEngine::Mode mode = EqualizerEngine::Mode::MinimumPhase;
+    const char* name = "minimum phase";
+    if (m_model->isLinearPhase()) {
+        mode = EqualizerEngine::Mode::LinearPhase;
+        name = "linear phase";
+    } else if (m_model->isMultirate()) {
+        mode = EqualizerEngine::Mode::Multirate;
+        name = "multirate";
+    } else if (m_model->isSmoothGains()) {
+        mode = EqualizerEngine::Mode::StateVariable;
+        name = "state variable";
+    }
+    m_audioProcessor->post(EqualizerEngine::Command::setMode(mode));
+    qDebug() << "EQ mode:" << name;
+}
+
+void AudioController::onModelLayoutChanged(const EqLayout& layout)
+{
+    // The layout command carries the gains; pending ones were for the old layout
+    m_gainsPending = false;
+    if (m_audioProcessor) {
+        m_audioProcessor->post(EqualizerEngine::Command::setLayout(layout, m_model->getBandGains()));
+        qDebug() << "EQ layout:" << EqLayout::kindName(layout.kind())
+                 << "|" << layout.bandCount() << "bands";
+    }
+}
+
+void AudioController::onModelBandConfigChanged(int band, const BandConfig& config)
+{
+    if (m_audioProcessor) {
+        m_audioProcessor->post(EqualizerEngine::Command::setBandConfig(band, config));
+    }
+}
+
+void AudioController::onModelLatencyTargetChanged(int ms)
+{
+    if (!m_audioProcessor) {
+        return;
+    }
+    // Buffer sizes are fixed per stream, so the streams are reopened with the
+    // new target
+    const bool wasRunning = m_audioProcessor->isRunning();
+    if (wasRunning) {
+        m_audioProcessor->stop();
+    }
+    m_audioProcessor->setLatencyTargetMs(ms);
+    if (wasRunning && !m_audioProcessor->start()) {
+        setActive(false);
+        emit errorOccurred("Failed to restart audio processor: " + m_audioProcessor->getLastError());
+    }
+}
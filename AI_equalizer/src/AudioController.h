@@ -0,0 +1,87 @@
+#ifndef AUDIOCONTROLLER_H
+#define AUDIOCONTROLLER_H
+
+#include <QObject>
+#include <QTimer>
+#include "equalizerengine.h"
+#include "audioprocessor.h"
+#include "levelmeter.h"
+#include "EqualizerViewModel.h"
+
+/**
+ * @class AudioController
+ * @brief Runs the audio pipeline and feeds it the model's changes
+ *
+ * Lives on the thread of the model (the GUI thread). Gain, preset, layout,
+ * mode and bypass changes become EqualizerEngine commands posted to the
+ * AudioProcessor, whose engine control thread designs them off the audio
+ * thread; no Qt event loop sits between the model and the audio.
+ *
+ * Gain changes are rate-limited: the first goes out at once, and any that
+ * follow within GAIN_FLUSH_MS are folded into one command with the model's
+ * latest gains, so a slider drag or an agent's burst costs about one
+ * redesign per audio block.
+ */
+class AudioController : public QObject
+{
+    Q_OBJECT
+
+public:
+    // About one audio block
+    static constexpr int GAIN_FLUSH_MS = 5;
+
+    explicit AudioController(EqualizerViewModel* model, QObject *parent = nullptr);
+    ~AudioController() override;
+
+    // Starts the pipeline, or resumes a suspended one (warm restart)
+    void startAudio();
+    // Pauses processing, keeping the streams and EQ state
+    void suspendAudio();
+    // Tears everything down
+    void stopAudio();
+    // Started, whether processing or suspended
+    bool isRunning() const { return m_audioProcessor != nullptr; }
+    // Processing, as opposed to suspended or stopped
+    bool isAudioActive() const { return m_active; }
+    // Output levels while processing, readable from any thread
+    const LevelMeter* levelMeter() const { return &m_levelMeter; }
+
+signals:
+    void audioStarted();
+    void audioStopped();
+    void errorOccurred(const QString& error);
+
+private slots:
+    void onModelBandGainChanged(int band, double gain);
+    void onModelAllGainsChanged(const QVector<double>& gains);
+    void onModelBypassChanged(bool enabled);
+    void onModelLinearPhaseChanged(bool enabled);
+    void onModelMultirateChanged(bool enabled);
+    void onModelSmoothGainsChanged(bool enabled);
+    void onModelLayoutChanged(const EqLayout& layout);
+    void onModelBandConfigChanged(int band, const BandConfig& config);
+    void onModelLatencyTargetChanged(int ms);
+    void onStreamEnded();
+    void onStatsTimeout();
+    void onGainFlushTimeout();
+
+private:
+    EqualizerViewModel* m_model;
+    EqualizerEngine* m_equalizer;
+    AudioProcessor* m_audioProcessor;
+    bool m_active{false};
+    LevelMeter m_levelMeter;
+    QTimer m_gainFlushTimer;
+    bool m_gainsPending{false};
+    // Polls the audio thread's latency and counters while processing
+    QTimer m_statsTimer;
+    int m_loggedUnderruns{0};
+
+    void configureFromEnvironment();
+    void setActive(bool active);
+    void applyMode();
+    void scheduleGainFlush();
+    void flushGains();
+};
+
+#endif // AUDIOCONTROLLER_H
@@ -0,0 +1,175 @@
+#include "ChatClient.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTcpSocket>
+#include <algorithm>
+
+ChatClient::ChatClient(QObject *parent)
+    : QObject(parent), m_socket(new QTcpSocket(this))
+{
+    m_retryTimer.setSingleShot(true);
+    m_connectTimer.setSingleShot(true);
+    m_connectTimer.setInterval(CONNECT_TIMEOUT_MS);
+    connect(&m_retryTimer, &QTimer::timeout, this, &ChatClient::connectToAgent);
+    connect(&m_connectTimer, &QTimer::timeout, this, &ChatClient::onConnectTimeout);
+
+    connect(m_socket, &QTcpSocket::connected, this, &ChatClient::onConnected);
+    connect(m_socket, &QTcpSocket::disconnected, this, &ChatClient::onDisconnected);
+    connect(m_socket, &QTcpSocket::readyRead, this, &ChatClient::onReadyRead);
+    connect(m_socket, &QTcpSocket::errorOccurred, this, &ChatClient::onSocketError);
+}
+
+void ChatClient::start(const QString& host, quint16 port)
+{
+    m_host = host;
+    m_port = port;
+    m_running = true;
+    m_retryDelayMs = RECONNECT_MIN_MS;
+    connectToAgent();
+}
+
+void ChatClient::stop()
+{
+    m_running = false;
+    m_retryTimer.stop();
+    m_connectTimer.stop();
+    m_socket->abort();
+}
+
+bool ChatClient::isConnected() const
+{
+    return m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+bool ChatClient::send(const QString& message)
+{
+    if (isConnected()) {
+        write(message);
+        return true;
+    }
+    if (m_pending.size() >= MAX_PENDING) {
+        return false;
+    }
+    m_pending.append(message);
+    // Don't make a waiting message sit out the backoff
+    if (m_running && m_retryTimer.isActive()) {
+        m_retryTimer.stop();
+        connectToAgent();
+    }
+    return true;
+}
+
+void ChatClient::connectToAgent()
+{
+    if (!m_running || m_socket->state() != QAbstractSocket::UnconnectedState) {
+        return;
+    }
+    m_input.clear();
+    m_socket->connectToHost(m_host, m_port);
+    m_connectTimer.start();
+}
+
+void ChatClient::scheduleReconnect()
+{
+    if (!m_running || m_retryTimer.isActive()) {
+        return;
+    }
+    m_retryTimer.start(m_retryDelayMs);
+    m_retryDelayMs = std::min(m_retryDelayMs * 2, RECONNECT_MAX_MS);
+}
+
+void ChatClient::reportConnection(bool connected)
+{
+    if (m_reportedOnce && connected == m_reportedConnected) {
+        return;
+    }
+    m_reportedOnce = true;
+    m_reportedConnected = connected;
+    emit connectionChanged(connected);
+}
+
+void ChatClient::onConnected()
+{
+    m_connectTimer.stop();
+    m_retryDelayMs = RECONNECT_MIN_MS;
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    qDebug() << "Connected to chat agent at" << m_host << m_port;
+    reportConnection(true);
+    const QStringList pending = m_pending;
+    m_pending.clear();
+    for (const QString& message : pending) {
+        write(message);
+    }
+}
+
+void ChatClient::onDisconnected()
+{
+    if (m_responding) {
+        m_responding = false;
+        emit responseAborted();
+    }
+    reportConnection(false);
+    scheduleReconnect();
+}
+
+void ChatClient::onSocketError()
+{
+    m_connectTimer.stop();
+    // A failed attempt ends here; a dropped connection also gets disconnected()
+    if (m_socket->state() != QAbstractSocket::ConnectedState) {
+        m_socket->abort();
+        reportConnection(false);
+        scheduleReconnect();
+    }
+}
+
+void ChatClient::onConnectTimeout()
+{
+    qDebug() << "Chat agent connect timed out";
+    m_socket->abort();
+    reportConnection(false);
+    scheduleReconnect();
+}
+
+void ChatClient::write(const QString& message)
+{
+    QJsonObject request;
+    request["message"] = message;
+    m_socket->write(QJsonDocument(request).toJson(QJsonDocument::Compact) + '\n');
+}
+
+void ChatClient::onReadyRead()
+{
+    m_input.append(m_socket->readAll());
+    int pos = 0;
+    int newline;
+    while ((newline = m_input.indexOf('\n', pos)) >= 0) {
+        const QByteArray line = m_input.mid(pos, newline - pos).trimmed();
+        pos = newline + 1;
+        if (!line.isEmpty()) {
+            handleLine(line);
+        }
+    }
+    m_input.remove(0, pos);
+    if (m_input.size() > MAX_LINE_BYTES) {
+        qWarning() << "Chat agent sent an oversized message, reconnecting";
+        m_socket->abort();
+    }
+}
+
+void ChatClient::handleLine(const QByteArray& line)
+{
+    const QJsonDocument doc = QJsonDocument::fromJson(line);
+    const QJsonObject message = doc.object();
+    if (!m_responding) {
+        m_responding = true;
+        emit responseStarted();
+    }
+    if (message.contains("delta")) {
+        emit responseDelta(message.value("delta").toString());
+        return;
+    }
+    m_responding = false;
+    emit responseFinished(doc.isObject() ? message.value("response").toString() : QString::fromUtf8(line));
+}
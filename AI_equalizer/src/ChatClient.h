@@ -0,0 +1,87 @@
+#ifndef CHATCLIENT_H
+#define CHATCLIENT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QStringList>
+#include <QTimer>
+
+class QTcpSocket;
+
+/**
+ * @class ChatClient
+ * @brief Non-blocking connection to the chat agent (agent/chat_agent.py)
+ *
+ * Everything runs on the event loop of the owner's thread: connecting never
+ * waits, and a connection that fails or drops is retried after a delay
+ * that doubles from RECONNECT_MIN_MS up to RECONNECT_MAX_MS and starts over
+ * once connected. Messages sent while disconnected are held (up to
+ * MAX_PENDING) and go out on the next connection.
+ *
+ * Messages are one JSON object per line both ways:
+ *   → {"message": "more bass"}
+ *   ← {"delta": "Boosting"}                  zero or more, as generated
+ *   ← {"response": "Boosting the lows..."}   the whole reply, ends it
+ * A line that is not JSON counts as a whole reply. Responses arrive in the
+ * order the messages were sent.
+ */
+class ChatClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int RECONNECT_MIN_MS = 500;
+    static constexpr int RECONNECT_MAX_MS = 30000;
+    static constexpr int CONNECT_TIMEOUT_MS = 2000;
+    static constexpr int MAX_PENDING = 8;
+    static constexpr int MAX_LINE_BYTES = 1024 * 1024;
+
+    explicit ChatClient(QObject *parent = nullptr);
+
+    // Starts connecting in the background; reconnects until stopped
+    void start(const QString& host, quint16 port);
+    void stop();
+    bool isConnected() const;
+
+    // Sends now or once connected; false if too many are waiting
+    bool send(const QString& message);
+
+signals:
+    // On every change, and once when the first attempt fails
+    void connectionChanged(bool connected);
+    // The first text of a reply, then the rest as it is generated
+    void responseStarted();
+    void responseDelta(const QString& text);
+    void responseFinished(const QString& response);
+    // The connection dropped while a reply was coming in
+    void responseAborted();
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onSocketError();
+    void onReadyRead();
+    void onConnectTimeout();
+
+private:
+    QTcpSocket* m_socket;
+    QString m_host;
+    quint16 m_port{0};
+    bool m_running{false};
+    bool m_reportedConnected{false};
+    bool m_reportedOnce{false};
+    int m_retryDelayMs{RECONNECT_MIN_MS};
+    QTimer m_retryTimer;
+    QTimer m_connectTimer;
+    QByteArray m_input;
+    QStringList m_pending;
+    bool m_responding{false};
+
+    void connectToAgent();
+    void scheduleReconnect();
+    void reportConnection(bool connected);
+    void write(const QString& message);
+    void handleLine(const QByteArray& line);
+};
+
+#endif // CHATCLIENT_H
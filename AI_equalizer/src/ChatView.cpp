@@ -57,6 +57,55 @@ void ChatView::addUserMessage(const QString& message)
 }
 
 void ChatView::addAIMessage(const QString& message)
+{
+    appendMessage("AI", displayText(message), "#4CAF50");
+}
+
+void ChatView::beginAIMessage()
+{
+    if (m_streaming) {
+        endAIMessage(m_streamText);
+    }
+    // A placeholder body until the first text arrives
+    appendMessage("AI", QStringLiteral("…"), "#4CAF50");
+    m_streamCursor = QTextCursor(m_chatDisplay->document());
+    m_streamCursor.movePosition(QTextCursor::End);
+    m_streamCursor.movePosition(QTextCursor::Left, QTextCursor::KeepAnchor);
+    m_streamText.clear();
+    m_streaming = true;
+}
+
+void ChatView::appendAIMessage(const QString& text)
+{
+    if (!m_streaming) {
+        beginAIMessage();
+    }
+    m_streamText += text;
+    setStreamBody(displayText(m_streamText));
+}
+
+void ChatView::endAIMessage(const QString& message)
+{
+    if (!m_streaming) {
+        addAIMessage(message);
+        return;
+    }
+    setStreamBody(displayText(message.isEmpty() ? m_streamText : message));
+    m_streaming = false;
+    m_streamText.clear();
+    m_streamCursor = QTextCursor();
+}
+
+void ChatView::setStreamBody(const QString& text)
+{
+    // Replaces the body in place; messages added after it are not touched
+    const int start = m_streamCursor.selectionStart();
+    m_streamCursor.insertText(text.isEmpty() ? QStringLiteral("…") : text);
+    m_streamCursor.setPosition(start, QTextCursor::KeepAnchor);
+    scrollToBottom();
+}
+
+QString ChatView::displayText(const QString& message)
 {
     // Remove the EQ_ADJUSTMENT line from display
     QString displayMessage = message;
@@ -70,7 +119,7 @@ void ChatView::addAIMessage(const QString& message)
         }
     }
     
-    appendMessage("AI", displayMessage.trimmed(), "#4CAF50");
+    return displayMessage.trimmed();
 }
 
 void ChatView::addSystemMessage(const QString& message)
@@ -90,8 +139,11 @@ void ChatView::appendMessage(const QString& sender, const QString& message, cons
                        .arg(color, sender, timestamp, message.toHtmlEscaped());
     
     m_chatDisplay->append(html);
-    
-    // Auto-scroll to bottom
+    scrollToBottom();
+}
+
+void ChatView::scrollToBottom()
+{
     QScrollBar* scrollBar = m_chatDisplay->verticalScrollBar();
     scrollBar->setValue(scrollBar->maximum());
 }
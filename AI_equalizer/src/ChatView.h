@@ -6,6 +6,7 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QVBoxLayout>
+#include <QTextCursor>
 
 class ChatView : public QWidget
 {
@@ -18,6 +19,13 @@ public:
     void addAIMessage(const QString& message);
     void addSystemMessage(const QString& message);
     
+    // An AI reply shown as it streams in: begin, append text, end with the
+    // whole reply (which replaces the streamed text; empty keeps it)
+    void beginAIMessage();
+    void appendAIMessage(const QString& text);
+    void endAIMessage(const QString& message);
+    bool isStreaming() const { return m_streaming; }
+    
 signals:
     void messageSent(const QString& message);
     
@@ -29,8 +37,16 @@ private:
     QLineEdit* m_inputField;
     QPushButton* m_sendButton;
     
+    // Selects the body of the reply being streamed
+    QTextCursor m_streamCursor;
+    QString m_streamText;
+    bool m_streaming{false};
+    
     void setupUI();
     void appendMessage(const QString& sender, const QString& message, const QString& color);
+    void setStreamBody(const QString& text);
+    void scrollToBottom();
+    static QString displayText(const QString& message);
 };
 
 #endif // CHATVIEW_H
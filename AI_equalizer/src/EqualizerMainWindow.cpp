@@ -5,11 +5,8 @@
 #include <QGroupBox>
 #include <QSplitter>
 #include <QMessageBox>
+#include <QCheckBox>
 #include <QDebug>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QTcpServer>
-#include <QTcpSocket>
 
 EqualizerMainWindow::EqualizerMainWindow(QWidget *parent)
     : QMainWindow(parent), ui(std::make_unique<Ui::EqualizerMainWindow>())
@@ -19,7 +16,7 @@ EqualizerMainWindow::EqualizerMainWindow(QWidget *parent)
     
     // Initialize MVVM components
     m_model = new EqualizerViewModel(this);
-    m_audioThread = new AudioProcessingThread(m_model, this);
+    m_audioController = new AudioController(m_model, this);
     m_presetManager = new PresetModel(this);
     
     // Connect model signals to view updates
@@ -27,35 +24,59 @@ EqualizerMainWindow::EqualizerMainWindow(QWidget *parent)
             this, &EqualizerMainWindow::onModelBandGainChanged);
     connect(m_model, &EqualizerViewModel::allGainsChanged,
             this, &EqualizerMainWindow::onModelAllGainsChanged);
+    connect(m_model, &EqualizerViewModel::layoutChanged,
+            this, &EqualizerMainWindow::onModelLayoutChanged);
+    connect(m_model, &EqualizerViewModel::bypassChanged,
+            this, &EqualizerMainWindow::onModelBypassChanged);
+    connect(m_model, &EqualizerViewModel::smoothGainsChanged,
+            this, &EqualizerMainWindow::onModelSmoothGainsChanged);
+    connect(m_model, &EqualizerViewModel::latencyTargetChanged,
+            this, &EqualizerMainWindow::onModelLatencyTargetChanged);
+    connect(m_model, &EqualizerViewModel::measuredLatencyChanged,
+            this, &EqualizerMainWindow::onModelMeasuredLatencyChanged);
     
-    // Connect audio thread signals
-    connect(m_audioThread, &AudioProcessingThread::audioStarted,
+    // Startup latency mode: AI_EQ_LATENCY_MS=20 (0 or unset = stable)
+    const int latencyMs = qEnvironmentVariableIntValue("AI_EQ_LATENCY_MS");
+    if (latencyMs > 0 && !m_model->setLatencyTargetMs(latencyMs)) {
+        qWarning() << "Ignoring AI_EQ_LATENCY_MS=" << latencyMs;
+    }
+    
+    // Connect audio controller signals
+    connect(m_audioController, &AudioController::audioStarted,
             this, &EqualizerMainWindow::onAudioStarted);
-    connect(m_audioThread, &AudioProcessingThread::audioStopped,
+    connect(m_audioController, &AudioController::audioStopped,
             this, &EqualizerMainWindow::onAudioStopped);
-    connect(m_audioThread, &AudioProcessingThread::errorOccurred,
+    connect(m_audioController, &AudioController::errorOccurred,
             this, &EqualizerMainWindow::onAudioError);
     
-    // Setup chat socket
-    m_chatSocket = new QTcpSocket(this);
-    connect(m_chatSocket, &QTcpSocket::readyRead, this, &EqualizerMainWindow::onChatResponse);
-    connect(m_chatSocket, static_cast<void(QTcpSocket::*)(QAbstractSocket::SocketError)>(&QTcpSocket::errorOccurred),
-            this, &EqualizerMainWindow::onChatError);
+    // Chat agent: replies stream into the chat view as they are generated
+    m_chatClient = new ChatClient(this);
+    connect(m_chatClient, &ChatClient::connectionChanged,
+            this, &EqualizerMainWindow::onChatConnectionChanged);
+    connect(m_chatClient, &ChatClient::responseStarted,
+            ui->chatWidget, &ChatView::beginAIMessage);
+    connect(m_chatClient, &ChatClient::responseDelta,
+            ui->chatWidget, &ChatView::appendAIMessage);
+    connect(m_chatClient, &ChatClient::responseFinished,
+            ui->chatWidget, &ChatView::endAIMessage);
+    connect(m_chatClient, &ChatClient::responseAborted,
+            this, &EqualizerMainWindow::onChatResponseAborted);
     
     // Setup additional UI elements (programmatically create sliders)
     setupUI();
     
-    // Connect to chat agent
-    connectChatAgent();
+    // Connect to chat agent in the background
+    m_chatClient->start("localhost", 5555);
 
-    // Start IPC server for JSON gains
-    startIpcServer(5560);
+    // Control protocol for agents and scripts
+    m_ipcServer = std::make_unique<IpcServer>(m_model, m_audioController->levelMeter());
+    m_ipcServer->start();
 }
 
 EqualizerMainWindow::~EqualizerMainWindow()
 {
-    if (m_audioThread->isRunning()) {
-        m_audioThread->stopAudio();
+    if (m_audioController->isRunning()) {
+        m_audioController->stopAudio();
     }
 }
 
@@ -68,6 +89,20 @@ void EqualizerMainWindow::setupUI()
             this, &EqualizerMainWindow::onResetClicked);
     connect(ui->presetCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
             this, &EqualizerMainWindow::onPresetChanged);
+    connect(ui->layoutCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            this, &EqualizerMainWindow::onLayoutSelected);
+    connect(ui->bypassCheck, &QCheckBox::toggled,
+            m_model, &EqualizerViewModel::setBypass);
+    connect(ui->linearPhaseCheck, &QCheckBox::toggled,
+            m_model, &EqualizerViewModel::setLinearPhase);
+    connect(ui->multirateCheck, &QCheckBox::toggled,
+            m_model, &EqualizerViewModel::setMultirate);
+    connect(ui->smoothGainsCheck, &QCheckBox::toggled,
+            m_model, &EqualizerViewModel::setSmoothGains);
+    ui->lowLatencyCheck->setChecked(m_model->latencyTargetMs() > 0);
+    connect(ui->lowLatencyCheck, &QCheckBox::toggled, this, [this](bool checked) {
+        m_model->setLatencyTargetMs(checked ? EqualizerViewModel::DEFAULT_LOW_LATENCY_MS : 0);
+    });
     
     // Connect chat view
     connect(ui->chatWidget, &ChatView::messageSent,
@@ -76,42 +111,96 @@ void EqualizerMainWindow::setupUI()
     // Populate preset combo box
     ui->presetCombo->addItems(m_presetManager->getPresetNames());
     
-    // Create the 10 EQ sliders programmatically
+    // Create the EQ sliders for the current layout programmatically
     createEqualizerControls(ui->eqGroup);
 }
 
 void EqualizerMainWindow::createEqualizerControls(QWidget* container)
 {
-    // Delete existing layout if present
+    // Delete existing controls and layout if present
+    qDeleteAll(container->findChildren<QWidget*>(QString(), Qt::FindDirectChildrenOnly));
     if (container->layout()) {
         delete container->layout();
     }
+    m_bandSliders.clear();
+    m_bandLabels.clear();
+    m_bandValueLabels.clear();
+    m_bandTypeCombos.clear();
+    m_bandFreqSpins.clear();
+    m_bandQSpins.clear();
     
-    QHBoxLayout* mainLayout = new QHBoxLayout(container);
-    mainLayout->setSpacing(10);
+    const EqLayout layout = m_model->layout();
+    const QVector<double> gains = m_model->getBandGains();
+    const bool parametric = !layout.isGraphic();
     
-    const QStringList bandNames = {
-        "31Hz", "62Hz", "125Hz", "250Hz", "500Hz",
-        "1kHz", "2kHz", "4kHz", "8kHz", "16kHz"
-    };
+    switch (layout.kind()) {
+    case EqLayout::Kind::Graphic10:
+        ui->eqGroup->setTitle("10-Band Equalizer");
+        break;
+    case EqLayout::Kind::Graphic31:
+        ui->eqGroup->setTitle("31-Band Equalizer");
+        break;
+    case EqLayout::Kind::Parametric:
+        ui->eqGroup->setTitle(QString("Parametric Equalizer (%1 bands)").arg(layout.bandCount()));
+        break;
+    }
     
-    for (int i = 0; i < 10; i++) {
+    QHBoxLayout* mainLayout = new QHBoxLayout(container);
+    mainLayout->setSpacing(layout.bandCount() > 16 ? 2 : 10);
+    
+    for (int i = 0; i < layout.bandCount(); i++) {
+        const BandConfig& config = layout.band(i);
+        
         QWidget* bandWidget = new QWidget();
         QVBoxLayout* bandLayout = new QVBoxLayout(bandWidget);
         bandLayout->setSpacing(2);
         bandLayout->setContentsMargins(0, 0, 0, 0);
         
         // Frequency label
-        QLabel* freqLabel = new QLabel(bandNames[i]);
+        QLabel* freqLabel = new QLabel(layout.bandLabel(i) + (layout.bandCount() > 16 ? "" : "Hz"));
         freqLabel->setAlignment(Qt::AlignCenter);
         m_bandLabels.append(freqLabel);
         bandLayout->addWidget(freqLabel, 0, Qt::AlignCenter);
         
+        if (parametric) {
+            // Type, frequency and Q editors above the gain slider
+            QComboBox* typeCombo = new QComboBox();
+            for (FilterType type : {FilterType::Peaking, FilterType::LowShelf, FilterType::HighShelf,
+                                    FilterType::HighPass, FilterType::LowPass}) {
+                typeCombo->addItem(EqLayout::typeName(type), static_cast<int>(type));
+            }
+            typeCombo->setCurrentIndex(typeCombo->findData(static_cast<int>(config.type)));
+            m_bandTypeCombos.append(typeCombo);
+            bandLayout->addWidget(typeCombo);
+            
+            QSpinBox* freqSpin = new QSpinBox();
+            freqSpin->setRange(20, 20000);
+            freqSpin->setSuffix(" Hz");
+            freqSpin->setValue(static_cast<int>(config.frequency));
+            m_bandFreqSpins.append(freqSpin);
+            bandLayout->addWidget(freqSpin);
+            
+            QDoubleSpinBox* qSpin = new QDoubleSpinBox();
+            qSpin->setRange(0.1, 10.0);
+            qSpin->setSingleStep(0.1);
+            qSpin->setPrefix("Q ");
+            qSpin->setValue(config.q);
+            m_bandQSpins.append(qSpin);
+            bandLayout->addWidget(qSpin);
+            
+            connect(typeCombo, QOverload<int>::of(&QComboBox::currentIndexChanged),
+                    this, [this, i]() { applyBandConfig(i); });
+            connect(freqSpin, QOverload<int>::of(&QSpinBox::valueChanged),
+                    this, [this, i]() { applyBandConfig(i); });
+            connect(qSpin, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+                    this, [this, i]() { applyBandConfig(i); });
+        }
+        
         // Slider
         QSlider* slider = new QSlider(Qt::Vertical);
         slider->setMinimum(-30);
         slider->setMaximum(30);
-        slider->setValue(0);
+        slider->setValue(i < gains.size() ? static_cast<int>(gains[i]) : 0);
         slider->setTickPosition(QSlider::TicksLeft);
         slider->setTickInterval(6);
         slider->setMinimumHeight(200);
@@ -125,12 +214,28 @@ void EqualizerMainWindow::createEqualizerControls(QWidget* container)
         bandLayout->addWidget(valueLabel, 0, Qt::AlignCenter);
         
         mainLayout->addWidget(bandWidget);
+        updateBandLabel(i);
         
         connect(slider, &QSlider::valueChanged,
                 this, &EqualizerMainWindow::onBandSliderChanged);
     }
 }
 
+void EqualizerMainWindow::applyBandConfig(int band)
+{
+    if (band < 0 || band >= m_bandTypeCombos.size()) {
+        return;
+    }
+    BandConfig config;
+    config.type = static_cast<FilterType>(m_bandTypeCombos[band]->currentData().toInt());
+    config.frequency = m_bandFreqSpins[band]->value();
+    config.q = m_bandQSpins[band]->value();
+    m_model->setBandConfig(band, config);
+    
+    EqLayout layout = m_model->layout();
+    m_bandLabels[band]->setText(layout.bandLabel(band) + "Hz");
+}
+
 void EqualizerMainWindow::onBandSliderChanged(int value)
 {
     QSlider* slider = qobject_cast<QSlider*>(sender());
@@ -154,9 +259,26 @@ void EqualizerMainWindow::updateBandLabel(int band)
 void EqualizerMainWindow::onPresetChanged(int index)
 {
     if (index >= 0 && index < m_presetManager->getPresetNames().size()) {
-        QVector<double> gains = m_presetManager->getPresetGains(index);
-        m_model->setAllBandGains(gains);
-        updateSliders(gains);
+        // Presets are defined on the 10-band grid
+        m_model->setGraphic10Gains(m_presetManager->getPresetGains(index));
+        updateSliders(m_model->getBandGains());
+    }
+}
+
+void EqualizerMainWindow::onLayoutSelected(int index)
+{
+    switch (index) {
+    case 0:
+        m_model->setLayout(EqLayout::graphic10());
+        break;
+    case 1:
+        m_model->setLayout(EqLayout::graphic31());
+        break;
+    case 2:
+        m_model->setLayout(EqLayout::defaultParametric());
+        break;
+    default:
+        break;
     }
 }
 
@@ -172,77 +294,51 @@ void EqualizerMainWindow::updateSliders(const QVector<double>& gains)
 
 void EqualizerMainWindow::onStartStopClicked()
 {
-    if (m_audioThread->isRunning()) {
-        m_audioThread->stopAudio();
+    // Stopping only suspends the pipeline, so starting again is a warm restart
+    if (m_audioController->isAudioActive()) {
+        m_audioController->suspendAudio();
         ui->startStopButton->setText("Start Audio");
     } else {
-        m_audioThread->startAudio();
+        m_audioController->startAudio();
         ui->startStopButton->setText("Stop Audio");
     }
 }
 
 void EqualizerMainWindow::onResetClicked()
 {
-    QVector<double> flatGains(10, 0.0);
+    QVector<double> flatGains(m_model->layout().bandCount(), 0.0);
     m_model->setAllBandGains(flatGains);
     ui->presetCombo->setCurrentIndex(0);  // Set to "Flat" preset
 }
 
-void EqualizerMainWindow::connectChatAgent()
-{
-    m_chatSocket->connectToHost("localhost", 5555);
-    if (m_chatSocket->waitForConnected(2000)) {
-        qDebug() << "✓ Connected to Chat Agent";
-        ui->chatWidget->addSystemMessage("Connected to chat agent");
-    } else {
-        qDebug() << "✗ Failed to connect to Chat Agent (is it running?)";
-        ui->chatWidget->addSystemMessage("Chat agent not available. Start it with: python3 agent/chat_agent.py");
-    }
-}
-
 void EqualizerMainWindow::onChatMessage(const QString& message)
 {
-    // Check connection state and attempt to reconnect if needed
-    if (m_chatSocket->state() != QTcpSocket::ConnectedState) {
-        ui->chatWidget->addSystemMessage("Reconnecting to chat agent...");
-        
-        // Attempt to reconnect
-        m_chatSocket->abort(); // Close any existing connection
-        m_chatSocket->connectToHost("localhost", 5555);
-        
-        if (!m_chatSocket->waitForConnected(2000)) {
-            ui->chatWidget->addSystemMessage("Failed to reconnect. Is the chat agent running?");
-            return;
-        }
-        
-        ui->chatWidget->addSystemMessage("Reconnected!");
+    const bool connected = m_chatClient->isConnected();
+    if (!m_chatClient->send(message)) {
+        ui->chatWidget->addSystemMessage("Chat agent not available; message not sent.");
+        return;
+    }
+    if (!connected) {
+        ui->chatWidget->addSystemMessage("Waiting for chat agent, will send when connected...");
     }
-    
-    m_currentChatMessage = message;
-    m_chatSocket->write(message.toUtf8());
     qDebug() << "Sent to agent:" << message;
 }
 
-void EqualizerMainWindow::onChatResponse()
+void EqualizerMainWindow::onChatConnectionChanged(bool connected)
 {
-    QByteArray data = m_chatSocket->readAll();
-    qDebug() << "Response:" << data;
-    
-    // Parse JSON response
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (doc.isObject()) {
-        QJsonObject obj = doc.object();
-        QString response = obj["response"].toString();
-        ui->chatWidget->addAIMessage(response);
+    if (connected) {
+        qDebug() << "✓ Connected to Chat Agent";
+        ui->chatWidget->addSystemMessage("Connected to chat agent");
     } else {
-        ui->chatWidget->addAIMessage(QString::fromUtf8(data));
+        qDebug() << "✗ Chat Agent not connected (is it running?)";
+        ui->chatWidget->addSystemMessage("Chat agent not available. Start it with: python3 agent/chat_agent.py");
     }
 }
 
-void EqualizerMainWindow::onChatError()
+void EqualizerMainWindow::onChatResponseAborted()
 {
-    qDebug() << "Chat socket error:" << m_chatSocket->errorString();
-    ui->chatWidget->addSystemMessage("Connection error: " + m_chatSocket->errorString());
+    ui->chatWidget->endAIMessage(QString());  // Keeps what arrived
+    ui->chatWidget->addSystemMessage("Connection to chat agent lost; the reply is incomplete.");
 }
 
 void EqualizerMainWindow::onModelBandGainChanged(int band, double gain)
@@ -257,52 +353,60 @@ void EqualizerMainWindow::onModelAllGainsChanged(const QVector<double>& gains)
     updateSliders(gains);
 }
 
-void EqualizerMainWindow::onAudioStarted()
+void EqualizerMainWindow::onModelLayoutChanged(const EqLayout& layout)
 {
-    qDebug() << "Audio processing started";
-    ui->startStopButton->setText("Stop Audio");
+    // Keep the selector in sync with layouts set over IPC
+    ui->layoutCombo->blockSignals(true);
+    ui->layoutCombo->setCurrentIndex(static_cast<int>(layout.kind()));
+    ui->layoutCombo->blockSignals(false);
+    
+    createEqualizerControls(ui->eqGroup);
 }
 
-void EqualizerMainWindow::onAudioStopped()
+void EqualizerMainWindow::onModelBypassChanged(bool enabled)
 {
-    qDebug() << "Audio processing stopped";
-    ui->startStopButton->setText("Start Audio");
+    // Keep the checkbox in sync with bypass set over IPC
+    ui->bypassCheck->blockSignals(true);
+    ui->bypassCheck->setChecked(enabled);
+    ui->bypassCheck->blockSignals(false);
 }
 
-void EqualizerMainWindow::onAudioError(const QString& error)
+void EqualizerMainWindow::onModelSmoothGainsChanged(bool enabled)
 {
-    ui->startStopButton->setText("Start Audio");
-    QMessageBox::warning(this, "Audio Error", error);
+    // Agents usually turn this on over IPC along with their automation
+    ui->smoothGainsCheck->blockSignals(true);
+    ui->smoothGainsCheck->setChecked(enabled);
+    ui->smoothGainsCheck->blockSignals(false);
 }
 
-// ========== IPC server: receive JSON band gains ==========
-void EqualizerMainWindow::startIpcServer(quint16 port)
+void EqualizerMainWindow::onModelLatencyTargetChanged(int ms)
 {
-    m_ipcServer = new QTcpServer(this);
-    connect(m_ipcServer, &QTcpServer::newConnection, this, &EqualizerMainWindow::onIpcNewConnection);
-    if (!m_ipcServer->listen(QHostAddress::LocalHost, port)) {
-        qWarning() << "IPC listen failed on" << port << ":" << m_ipcServer->errorString();
-    } else {
-        qDebug() << "IPC listening on" << m_ipcServer->serverAddress().toString() << port;
-    }
+    // Keep the checkbox in sync with targets set over IPC
+    ui->lowLatencyCheck->blockSignals(true);
+    ui->lowLatencyCheck->setChecked(ms > 0);
+    ui->lowLatencyCheck->blockSignals(false);
 }
 
-void EqualizerMainWindow::onIpcNewConnection()
+void EqualizerMainWindow::onModelMeasuredLatencyChanged(double ms)
 {
-    while (m_ipcServer->hasPendingConnections()) {
-        QTcpSocket* s = m_ipcServer->nextPendingConnection();
-        connect(s, &QTcpSocket::readyRead, this, &EqualizerMainWindow::onIpcReadyRead);
-        connect(s, &QTcpSocket::disconnected, s, &QTcpSocket::deleteLater);
-    }
+    ui->latencyLabel->setText(QString("Latency: %1 ms").arg(ms, 0, 'f', 1));
+}
+
+void EqualizerMainWindow::onAudioStarted()
+{
+    qDebug() << "Audio processing started";
+    ui->startStopButton->setText("Stop Audio");
+}
+
+void EqualizerMainWindow::onAudioStopped()
+{
+    qDebug() << "Audio processing stopped";
+    ui->startStopButton->setText("Start Audio");
+    ui->latencyLabel->setText("Latency: --");
 }
 
-void EqualizerMainWindow::onIpcReadyRead()
+void EqualizerMainWindow::onAudioError(const QString& error)
 {
-    QTcpSocket* s = qobject_cast<QTcpSocket*>(sender());
-    if (!s) return;
-    const QByteArray data = s->readAll();
-    const QString json = QString::fromUtf8(data).trimmed();
-    bool ok = m_model->setBandGainsJson(json);
-    s->write(ok ? QByteArray("OK\n") : QByteArray("ERROR\n"));
-    s->flush();
+    ui->startStopButton->setText("Start Audio");
+    QMessageBox::warning(this, "Audio Error", error);
 }
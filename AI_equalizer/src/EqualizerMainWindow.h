@@ -6,14 +6,16 @@
 #include <QLabel>
 #include <QComboBox>
 #include <QPushButton>
+#include <QSpinBox>
+#include <QDoubleSpinBox>
 #include <QVector>
-#include <QTcpSocket>
-#include <QTcpServer>
 #include <memory>
 #include "EqualizerViewModel.h"
-#include "AudioProcessingThread.h"
+#include "AudioController.h"
 #include "PresetModel.h"
 #include "ChatView.h"
+#include "ChatClient.h"
+#include "IpcServer.h"
 
 namespace Ui {
 class EqualizerMainWindow;
@@ -30,13 +32,19 @@ public:
 private slots:
     void onBandSliderChanged(int value);
     void onPresetChanged(int index);
+    void onLayoutSelected(int index);
     void onStartStopClicked();
     void onResetClicked();
     void onChatMessage(const QString& message);
-    void onChatResponse();
-    void onChatError();
+    void onChatConnectionChanged(bool connected);
+    void onChatResponseAborted();
     void onModelBandGainChanged(int band, double gain);
     void onModelAllGainsChanged(const QVector<double>& gains);
+    void onModelLayoutChanged(const EqLayout& layout);
+    void onModelBypassChanged(bool enabled);
+    void onModelSmoothGainsChanged(bool enabled);
+    void onModelLatencyTargetChanged(int ms);
+    void onModelMeasuredLatencyChanged(double ms);
     void onAudioStarted();
     void onAudioStopped();
     void onAudioError(const QString& error);
@@ -47,29 +55,29 @@ private:
     
     // MVVM Components
     EqualizerViewModel* m_model;
-    AudioProcessingThread* m_audioThread;
+    AudioController* m_audioController;
     PresetModel* m_presetManager;
     
     // UI components
     QVector<QSlider*> m_bandSliders;
     QVector<QLabel*> m_bandLabels;
     QVector<QLabel*> m_bandValueLabels;
+    // Parametric layouts only
+    QVector<QComboBox*> m_bandTypeCombos;
+    QVector<QSpinBox*> m_bandFreqSpins;
+    QVector<QDoubleSpinBox*> m_bandQSpins;
     
-    // Chat socket
-    QTcpSocket* m_chatSocket;
-    QString m_currentChatMessage;
+    // Chat agent connection
+    ChatClient* m_chatClient;
     
-    // Simple IPC server to receive JSON band gains
-    QTcpServer* m_ipcServer;
-    void startIpcServer(quint16 port = 5560);
-    void onIpcNewConnection();
-    void onIpcReadyRead();
+    // Control protocol for agents, on its own thread
+    std::unique_ptr<IpcServer> m_ipcServer;
     
     void setupUI();
     void createEqualizerControls(QWidget* container);
     void updateSliders(const QVector<double>& gains);
     void updateBandLabel(int band);
-    void connectChatAgent();
+    void applyBandConfig(int band);
 };
 
 #endif // MAINWINDOW_H
@@ -1,16 +1,19 @@
 #include "EqualizerViewModel.h"
-#include "equalizerengine.h"
 #include <QJsonDocument>
 #include <QJsonArray>
+#include <QJsonObject>
 #include <QJsonValue>
 
 EqualizerViewModel::EqualizerViewModel(QObject *parent)
-    : QObject(parent), m_audioRunning(false)
+    : QObject(parent), m_audioRunning(false), m_bypass(false), m_linearPhase(false),
+      m_multirate(false), m_smoothGains(false), m_gainUpdateDepth(0), m_gainsBatched(false),
+      m_latencyTargetMs(0), m_measuredLatencyMs(0.0)
 {
-    m_bandGains.resize(EqualizerEngine::NUM_BANDS);
-    for (int i = 0; i < EqualizerEngine::NUM_BANDS; ++i) {
-        m_bandGains[i] = 0.0;
-    }
+    // Layouts travel through queued connections to the audio thread
+    qRegisterMetaType<EqLayout>("EqLayout");
+    qRegisterMetaType<BandConfig>("BandConfig");
+
+    m_bandGains.fill(0.0, m_layout.bandCount());
 }
 
 QVector<double> EqualizerViewModel::getBandGains() const
@@ -35,6 +38,10 @@ void EqualizerViewModel::setBandGain(int band, double gain)
         if (band >= 0 && band < m_bandGains.size()) {
             m_bandGains[band] = gain;
         }
+        if (m_gainUpdateDepth > 0) {
+            m_gainsBatched = true;
+            return;
+        }
     }
     emit bandGainChanged(band, gain);
 }
@@ -46,21 +53,103 @@ void EqualizerViewModel::setAllBandGains(const QVector<double>& gains)
         if (gains.size() == m_bandGains.size()) {
             m_bandGains = gains;
         }
+        if (m_gainUpdateDepth > 0) {
+            m_gainsBatched = true;
+            return;
+        }
+    }
+    emit allGainsChanged(gains);
+}
+
+void EqualizerViewModel::beginGainUpdate()
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_gainUpdateDepth;
+}
+
+void EqualizerViewModel::commitGainUpdate()
+{
+    QVector<double> gains;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_gainUpdateDepth == 0 || --m_gainUpdateDepth > 0 || !m_gainsBatched) {
+            return;
+        }
+        m_gainsBatched = false;
+        gains = m_bandGains;
     }
     emit allGainsChanged(gains);
 }
 
+void EqualizerViewModel::setGraphic10Gains(const QVector<double>& gains)
+{
+    const EqLayout current = layout();
+    if (current.kind() == EqLayout::Kind::Graphic10) {
+        setAllBandGains(gains);
+    } else {
+        setAllBandGains(current.mapGains(EqLayout::graphic10(), gains));
+    }
+}
+
+bool EqualizerViewModel::setBandGains(const QVector<double>& gains)
+{
+    if (gains.size() == layout().bandCount()) {
+        setAllBandGains(gains);
+    } else if (gains.size() == EqLayout::graphic10().bandCount()) {
+        setGraphic10Gains(gains);
+    } else {
+        return false;
+    }
+    return true;
+}
+
 bool EqualizerViewModel::setBandGainsJson(const QString& jsonArrayString)
+{
+    return setBandGainsJson(jsonArrayString.toUtf8());
+}
+
+bool EqualizerViewModel::setBandGainsJson(const QByteArray& json)
 {
     QJsonParseError parseError;
-    QJsonDocument doc = QJsonDocument::fromJson(jsonArrayString.toUtf8(), &parseError);
-    if (parseError.error != QJsonParseError::NoError || !doc.isArray()) {
+    const QJsonDocument doc = QJsonDocument::fromJson(json, &parseError);
+    if (parseError.error != QJsonParseError::NoError) {
         return false;
     }
-    QJsonArray arr = doc.array();
-    if (arr.size() != m_bandGains.size()) {
+    return setBandGainsJson(doc);
+}
+
+bool EqualizerViewModel::setBandGainsJson(const QJsonDocument& doc)
+{
+    if (doc.isObject()) {
+        const QJsonObject obj = doc.object();
+        if (obj.contains("bypass") && !obj.contains("layout")) {
+            if (!obj.value("bypass").isBool()) {
+                return false;
+            }
+            setBypass(obj.value("bypass").toBool());
+            return true;
+        }
+        if (obj.contains("smooth") && !obj.contains("layout")) {
+            if (!obj.value("smooth").isBool()) {
+                return false;
+            }
+            setSmoothGains(obj.value("smooth").toBool());
+            return true;
+        }
+        if (obj.contains("band_gains") && !obj.contains("layout")) {
+            return obj.value("band_gains").isObject()
+                   && applyBandGainsJson(obj.value("band_gains").toObject());
+        }
+        if (obj.contains("latency_ms") && !obj.contains("layout")) {
+            return obj.value("latency_ms").isDouble()
+                   && setLatencyTargetMs(obj.value("latency_ms").toInt());
+        }
+        return applyLayoutJson(obj);
+    }
+    if (!doc.isArray()) {
         return false;
     }
+    QJsonArray arr = doc.array();
     QVector<double> gains;
     gains.reserve(arr.size());
     for (int i = 0; i < arr.size(); ++i) {
@@ -70,10 +159,118 @@ bool EqualizerViewModel::setBandGainsJson(const QString& jsonArrayString)
         }
         gains.push_back(v.toDouble());
     }
-    setAllBandGains(gains);
+    return setBandGains(gains);
+}
+
+bool EqualizerViewModel::applyBandGainsJson(const QJsonObject& gains)
+{
+    // Validate everything first, so a bad entry changes nothing
+    const int bandCount = layout().bandCount();
+    QVector<QPair<int, double>> changes;
+    for (auto it = gains.constBegin(); it != gains.constEnd(); ++it) {
+        bool ok = false;
+        const int band = it.key().toInt(&ok);
+        if (!ok || band < 0 || band >= bandCount || !it.value().isDouble()) {
+            return false;
+        }
+        changes.append(qMakePair(band, it.value().toDouble()));
+    }
+
+    beginGainUpdate();
+    for (const auto& change : changes) {
+        setBandGain(change.first, change.second);
+    }
+    commitGainUpdate();
     return true;
 }
 
+bool EqualizerViewModel::applyLayoutJson(const QJsonObject& obj)
+{
+    EqLayout::Kind kind;
+    if (!EqLayout::kindFromName(obj.value("layout").toString(), &kind)) {
+        return false;
+    }
+
+    EqLayout newLayout;
+    QVector<double> gains;
+    if (kind == EqLayout::Kind::Parametric) {
+        const QJsonArray bands = obj.value("bands").toArray();
+        if (bands.isEmpty() || bands.size() > EqLayout::MAX_BANDS) {
+            return false;
+        }
+        QVector<BandConfig> configs;
+        for (const QJsonValue& value : bands) {
+            const QJsonObject band = value.toObject();
+            BandConfig config;
+            if (!EqLayout::typeFromName(band.value("type").toString("peak"), &config.type)
+                || !band.value("freq").isDouble()) {
+                return false;
+            }
+            config.frequency = band.value("freq").toDouble();
+            config.q = band.value("q").toDouble(0.707);
+            if (config.frequency <= 0.0 || config.q <= 0.0) {
+                return false;
+            }
+            configs.append(config);
+            gains.append(band.value("gain").toDouble(0.0));
+        }
+        newLayout = EqLayout::parametric(configs);
+    } else {
+        newLayout = kind == EqLayout::Kind::Graphic31 ? EqLayout::graphic31() : EqLayout::graphic10();
+        const QJsonArray values = obj.value("gains").toArray();
+        if (values.isEmpty()) {
+            // No gains given: carry the current curve over
+            gains = newLayout.mapGains(layout(), getBandGains());
+        } else if (values.size() == newLayout.bandCount()) {
+            for (const QJsonValue& v : values) {
+                if (!v.isDouble()) {
+                    return false;
+                }
+                gains.append(v.toDouble());
+            }
+        } else {
+            return false;
+        }
+    }
+
+    applyLayout(newLayout, gains);
+    return true;
+}
+
+EqLayout EqualizerViewModel::layout() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_layout;
+}
+
+void EqualizerViewModel::setLayout(const EqLayout& layout)
+{
+    applyLayout(layout, layout.mapGains(this->layout(), getBandGains()));
+}
+
+void EqualizerViewModel::applyLayout(const EqLayout& layout, const QVector<double>& gains)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_layout = layout;
+        m_bandGains = gains;
+    }
+    // Listeners read the new gains from the model
+    emit layoutChanged(layout);
+}
+
+void EqualizerViewModel::setBandConfig(int band, const BandConfig& config)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_layout.isGraphic() || band < 0 || band >= m_layout.bandCount()) {
+            return;
+        }
+        m_layout.setBand(band, config);
+    }
+    emit bandConfigChanged(band, config);
+}
+
 bool EqualizerViewModel::isAudioRunning() const
 {
     QMutexLocker locker(&m_mutex);
@@ -88,3 +285,118 @@ void EqualizerViewModel::setAudioRunning(bool running)
     }
     emit audioRunningChanged(running);
 }
+
+bool EqualizerViewModel::isBypassed() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_bypass;
+}
+
+void EqualizerViewModel::setBypass(bool enabled)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_bypass == enabled) {
+            return;
+        }
+        m_bypass = enabled;
+    }
+    emit bypassChanged(enabled);
+}
+
+bool EqualizerViewModel::isLinearPhase() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_linearPhase;
+}
+
+void EqualizerViewModel::setLinearPhase(bool enabled)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_linearPhase = enabled;
+    }
+    emit linearPhaseChanged(enabled);
+}
+
+bool EqualizerViewModel::isMultirate() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_multirate;
+}
+
+void EqualizerViewModel::setMultirate(bool enabled)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_multirate = enabled;
+    }
+    emit multirateChanged(enabled);
+}
+
+bool EqualizerViewModel::isSmoothGains() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_smoothGains;
+}
+
+void EqualizerViewModel::setSmoothGains(bool enabled)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_smoothGains == enabled) {
+            return;
+        }
+        m_smoothGains = enabled;
+    }
+    emit smoothGainsChanged(enabled);
+}
+
+int EqualizerViewModel::latencyTargetMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_latencyTargetMs;
+}
+
+bool EqualizerViewModel::setLatencyTargetMs(int ms)
+{
+    if (ms != 0 && (ms < MIN_LATENCY_MS || ms > MAX_LATENCY_MS)) {
+        return false;
+    }
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_latencyTargetMs == ms) {
+            return true;
+        }
+        m_latencyTargetMs = ms;
+    }
+    emit latencyTargetChanged(ms);
+    return true;
+}
+
+double EqualizerViewModel::measuredLatencyMs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_measuredLatencyMs;
+}
+
+AudioStats EqualizerViewModel::audioStats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_audioStats;
+}
+
+void EqualizerViewModel::setAudioStats(const AudioStats& stats)
+{
+    QMutexLocker locker(&m_mutex);
+    m_audioStats = stats;
+}
+
+void EqualizerViewModel::setMeasuredLatencyMs(double ms)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_measuredLatencyMs = ms;
+    }
+    emit measuredLatencyChanged(ms);
+}
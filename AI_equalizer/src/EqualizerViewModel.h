@@ -4,6 +4,17 @@
 #include <QObject>
 #include <QVector>
 #include <QMutex>
+#include "eqlayout.h"
+
+class QJsonDocument;
+class QJsonObject;
+
+// Audio pipeline figures for status queries, refreshed while running
+struct AudioStats {
+    double driftPpm{0.0};
+    int underruns{0};
+    quint64 droppedFrames{0};  // Lost to queue overflow
+};
 
 // Model: Holds the data state
 class EqualizerViewModel : public QObject
@@ -11,27 +22,104 @@ class EqualizerViewModel : public QObject
     Q_OBJECT
 
 public:
+    // End-to-end latency targets for low-latency mode (0 = stable buffering)
+    static constexpr int MIN_LATENCY_MS = 10;
+    static constexpr int MAX_LATENCY_MS = 500;
+    static constexpr int DEFAULT_LOW_LATENCY_MS = 20;
+
     explicit EqualizerViewModel(QObject *parent = nullptr);
 
     QVector<double> getBandGains() const;
     double getBandGain(int band) const;
     void setBandGain(int band, double gain);
     void setAllBandGains(const QVector<double>& gains);
-    // Accept a JSON array of doubles (size must match number of bands)
+    // Gains given on the 10-band graphic grid (presets, agent), mapped onto
+    // the current layout
+    void setGraphic10Gains(const QVector<double>& gains);
+    // Either of the above, by size; false for any other size
+    bool setBandGains(const QVector<double>& gains);
+    // Gain transaction: gains set between begin and commit are stored at
+    // once but announced together, as one allGainsChanged() on the
+    // outermost commit (only if any were set). Transactions nest.
+    void beginGainUpdate();
+    void commitGainUpdate();
+    // Accepts either a JSON array of gains (current band count, or 10 to be
+    // mapped) or an object switching layout:
+    //   {"layout": "graphic31", "gains": [...]}
+    //   {"layout": "parametric", "bands": [{"type": "peak", "freq": 1000, "q": 1.0, "gain": 3.0}]}
+    // or selecting the latency mode: {"latency_ms": 20} (0 = stable)
+    // or toggling bypass: {"bypass": true}
+    // or toggling smooth gains: {"smooth": true}
+    // or setting some bands in one transaction: {"band_gains": {"0": 3.0, "4": -2.0}}
     Q_INVOKABLE bool setBandGainsJson(const QString& jsonArrayString);
+    // Same, from UTF-8 or already parsed
+    bool setBandGainsJson(const QByteArray& json);
+    bool setBandGainsJson(const QJsonDocument& doc);
+
+    EqLayout layout() const;
+    // Current gains are carried over by frequency
+    void setLayout(const EqLayout& layout);
+    void setBandConfig(int band, const BandConfig& config);
 
     bool isAudioRunning() const;
     void setAudioRunning(bool running);
 
+    // Passes audio through untouched, whatever the gains
+    bool isBypassed() const;
+    void setBypass(bool enabled);
+
+    bool isLinearPhase() const;
+    void setLinearPhase(bool enabled);
+
+    // Low bands at a reduced rate; ignored while linear phase is on
+    bool isMultirate() const;
+    void setMultirate(bool enabled);
+
+    // Gain changes glide per sample instead of stepping; ignored while
+    // linear phase or multirate is on
+    bool isSmoothGains() const;
+    void setSmoothGains(bool enabled);
+
+    // 0 for stable buffering, else MIN_LATENCY_MS..MAX_LATENCY_MS
+    int latencyTargetMs() const;
+    bool setLatencyTargetMs(int ms);
+    // Reported by the audio thread while running
+    double measuredLatencyMs() const;
+    void setMeasuredLatencyMs(double ms);
+    AudioStats audioStats() const;
+    void setAudioStats(const AudioStats& stats);
+
 signals:
     void bandGainChanged(int band, double gain);
     void allGainsChanged(const QVector<double>& gains);
     void audioRunningChanged(bool running);
+    void bypassChanged(bool enabled);
+    void linearPhaseChanged(bool enabled);
+    void multirateChanged(bool enabled);
+    void smoothGainsChanged(bool enabled);
+    void latencyTargetChanged(int ms);
+    void measuredLatencyChanged(double ms);
+    void layoutChanged(const EqLayout& layout);
+    void bandConfigChanged(int band, const BandConfig& config);
 
 private:
     mutable QMutex m_mutex;
+    EqLayout m_layout;
     QVector<double> m_bandGains;
     bool m_audioRunning;
+    bool m_bypass;
+    bool m_linearPhase;
+    bool m_multirate;
+    bool m_smoothGains;
+    int m_gainUpdateDepth;
+    bool m_gainsBatched;
+    int m_latencyTargetMs;
+    double m_measuredLatencyMs;
+    AudioStats m_audioStats;
+
+    void applyLayout(const EqLayout& layout, const QVector<double>& gains);
+    bool applyLayoutJson(const QJsonObject& obj);
+    bool applyBandGainsJson(const QJsonObject& gains);
 };
 
 #endif // EQUALIZERVIEWMODEL_H
@@ -0,0 +1,510 @@
+#include "IpcServer.h"
+#include <QDebug>
+#include <QDir>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QtEndian>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Plain arrays of numbers, e.g. "[3, 2.5, -1]"; anything else is left to
+// the JSON parser
+bool parseNumberArray(const QByteArray& line, QVector<double>* values)
+{
+    const int end = line.size() - 1;
+    if (end < 1 || line[0] != '[' || line[end] != ']') {
+        return false;
+    }
+    int pos = 1;
+    while (pos < end) {
+        int next = line.indexOf(',', pos);
+        if (next < 0 || next > end) {
+            next = end;
+        }
+        bool ok = false;
+        const double value = QByteArray::fromRawData(line.constData() + pos, next - pos).trimmed().toDouble(&ok);
+        if (!ok || !std::isfinite(value)) {
+            return false;
+        }
+        values->append(value);
+        pos = next + 1;
+    }
+    return true;
+}
+
+float readFloat(const char* data)
+{
+    const quint32 bits = qFromLittleEndian<quint32>(data);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void appendFloat(QByteArray& out, float value)
+{
+    quint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char bytes[4];
+    qToLittleEndian(bits, bytes);
+    out.append(bytes, sizeof(bytes));
+}
+
+void appendUInt32(QByteArray& out, quint32 value)
+{
+    char bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(bytes, sizeof(bytes));
+}
+
+void appendHeader(QByteArray& out, quint8 type, int size)
+{
+    char length[2];
+    qToLittleEndian(static_cast<quint16>(size), length);
+    out.append(IpcServer::BINARY_MAGIC);
+    out.append(static_cast<char>(type));
+    out.append(length, sizeof(length));
+}
+
+} // namespace
+
+IpcServer::IpcServer(EqualizerViewModel* model, const LevelMeter* meter)
+    : QObject(nullptr), m_model(model), m_meter(meter),
+      m_socketPath(defaultSocketPath()), m_sharedName(SharedControl::DEFAULT_NAME)
+{
+    m_thread.setObjectName("ipc");
+}
+
+IpcServer::~IpcServer()
+{
+    stop();
+}
+
+QString IpcServer::defaultSocketPath()
+{
+    QString dir = qEnvironmentVariable("XDG_RUNTIME_DIR");
+    if (dir.isEmpty()) {
+        dir = QDir::tempPath();
+    }
+    return QDir(dir).filePath("ai_equalizer.sock");
+}
+
+bool IpcServer::start(quint16 port)
+{
+    if (m_thread.isRunning()) {
+        return true;
+    }
+    if (thread() != &m_thread) {
+        moveToThread(&m_thread);
+    }
+    m_thread.start();
+
+    bool listening = false;
+    QMetaObject::invokeMethod(this, [this, port, &listening] { listening = listen(port); },
+                              Qt::BlockingQueuedConnection);
+    if (!listening) {
+        m_thread.quit();
+        m_thread.wait();
+    }
+    return listening;
+}
+
+void IpcServer::stop()
+{
+    if (!m_thread.isRunning()) {
+        return;
+    }
+    QMetaObject::invokeMethod(this, [this] { close(); }, Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+}
+
+bool IpcServer::listen(quint16 port)
+{
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &IpcServer::onNewConnection);
+    bool listening = m_server->listen(QHostAddress::LocalHost, port);
+    if (listening) {
+        qDebug() << "IPC listening on" << m_server->serverAddress().toString() << port;
+    } else {
+        qWarning() << "IPC listen failed on" << port << ":" << m_server->errorString();
+        delete m_server;
+        m_server = nullptr;
+    }
+    // Each endpoint works without the others
+    listening = listenLocal() || listening;
+    listening = openShared() || listening;
+    return listening;
+}
+
+bool IpcServer::listenLocal()
+{
+    if (m_socketPath.isEmpty()) {
+        return false;
+    }
+    // A socket file left by a crashed instance would block listen()
+    QLocalServer::removeServer(m_socketPath);
+    m_localServer = new QLocalServer(this);
+    m_localServer->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(m_localServer, &QLocalServer::newConnection, this, &IpcServer::onNewLocalConnection);
+    if (!m_localServer->listen(m_socketPath)) {
+        qWarning() << "IPC listen failed on" << m_socketPath << ":" << m_localServer->errorString();
+        delete m_localServer;
+        m_localServer = nullptr;
+        return false;
+    }
+    qDebug() << "IPC listening on" << m_localServer->fullServerName();
+    return true;
+}
+
+bool IpcServer::openShared()
+{
+    if (m_sharedName.isEmpty()) {
+        return false;
+    }
+    if (!m_shared.create(m_sharedName.toLocal8Bit().constData())) {
+        qWarning() << "IPC shared memory unavailable:" << m_shared.lastError();
+        return false;
+    }
+    // Republish the model's side only when it changes, and right away
+    const auto markDirty = [this] {
+        m_sharedStateDirty.store(true, std::memory_order_release);
+        m_shared.wake();
+    };
+    connect(m_model, &EqualizerViewModel::bandGainChanged, this, markDirty);
+    connect(m_model, &EqualizerViewModel::allGainsChanged, this, markDirty);
+    connect(m_model, &EqualizerViewModel::bypassChanged, this, markDirty);
+    connect(m_model, &EqualizerViewModel::layoutChanged, this, markDirty);
+    connect(m_model, &EqualizerViewModel::audioRunningChanged, this, markDirty);
+    connect(m_model, &EqualizerViewModel::measuredLatencyChanged, this, markDirty);
+    m_sharedStateDirty = true;
+    m_sharedStopping = false;
+    m_sharedThread = QThread::create([this] { serveShared(); });
+    m_sharedThread->setObjectName("ipc-shm");
+    m_sharedThread->start();
+    qDebug() << "IPC shared memory at" << m_sharedName;
+    return true;
+}
+
+void IpcServer::close()
+{
+    for (auto it = m_buffers.constBegin(); it != m_buffers.constEnd(); ++it) {
+        it.key()->disconnect(this);
+        delete it.key();
+    }
+    m_buffers.clear();
+    delete m_server;
+    m_server = nullptr;
+    delete m_localServer;
+    m_localServer = nullptr;
+    m_model->disconnect(this);
+    if (m_sharedThread) {
+        m_sharedStopping.store(true, std::memory_order_release);
+        m_shared.wake();
+        m_sharedThread->wait();
+        delete m_sharedThread;
+        m_sharedThread = nullptr;
+    }
+    m_shared.close();
+}
+
+void IpcServer::onNewConnection()
+{
+    while (m_server->hasPendingConnections()) {
+        QTcpSocket* socket = m_server->nextPendingConnection();
+        // Replies to small pipelined requests should not wait for Nagle
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::disconnected, this, [this, socket] {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+        addConnection(socket);
+    }
+}
+
+void IpcServer::onNewLocalConnection()
+{
+    while (m_localServer->hasPendingConnections()) {
+        QLocalSocket* socket = m_localServer->nextPendingConnection();
+        connect(socket, &QLocalSocket::disconnected, this, [this, socket] {
+            m_buffers.remove(socket);
+            socket->deleteLater();
+        });
+        addConnection(socket);
+    }
+}
+
+void IpcServer::addConnection(QIODevice* socket)
+{
+    m_buffers.insert(socket, QByteArray());
+    connect(socket, &QIODevice::readyRead, this, [this, socket] { onReadyRead(socket); });
+    connect(socket, &QIODevice::readChannelFinished, this, [this, socket] { onReadFinished(socket); });
+}
+
+void IpcServer::closeConnection(QIODevice* socket)
+{
+    if (auto* tcp = qobject_cast<QTcpSocket*>(socket)) {
+        tcp->disconnectFromHost();
+    } else if (auto* local = qobject_cast<QLocalSocket*>(socket)) {
+        local->disconnectFromServer();
+    }
+}
+
+void IpcServer::onReadyRead(QIODevice* socket)
+{
+    const auto it = m_buffers.find(socket);
+    if (it == m_buffers.end()) {
+        return;
+    }
+    QByteArray& input = it.value();
+    input.append(socket->readAll());
+    QByteArray reply;
+    const bool ok = processInput(input, reply);
+    if (!reply.isEmpty()) {
+        socket->write(reply);
+    }
+    if (!ok) {
+        qWarning() << "IPC: malformed input, closing connection";
+        input.clear();
+        closeConnection(socket);
+    }
+}
+
+void IpcServer::onReadFinished(QIODevice* socket)
+{
+    // The client is done sending; a last line may lack its newline
+    onReadyRead(socket);
+    const auto it = m_buffers.find(socket);
+    if (it == m_buffers.end()) {
+        return;
+    }
+    QByteArray& input = it.value();
+    if (!input.isEmpty() && input[0] != BINARY_MAGIC) {
+        QByteArray reply;
+        handleLine(input.trimmed(), reply);
+        socket->write(reply);
+    }
+    input.clear();
+    closeConnection(socket);
+}
+
+void IpcServer::serveShared()
+{
+    for (;;) {
+        // Read first: a wake() from here on ends the wait below at once
+        const uint32_t since = m_shared.wakeCount();
+        if (m_sharedStopping.load(std::memory_order_acquire)) {
+            break;
+        }
+        SharedRequest request;
+        uint32_t sequence = 0;
+        if (m_shared.takeRequest(&request, &sequence)) {
+            applySharedRequest(request);
+            m_sharedState.applied = sequence;
+            m_sharedStateDirty.store(true, std::memory_order_relaxed);
+        }
+        publishSharedState();
+        m_shared.waitForRequest(since, SHARED_METER_MS);
+    }
+}
+
+void IpcServer::applySharedRequest(const SharedRequest& request)
+{
+    // Invalid gains are dropped, as they are answered ERROR on a socket
+    if (request.flags & SharedRequest::Gains) {
+        const int count = static_cast<int>(std::min<uint32_t>(request.bandCount, BiquadBank::MAX_BANDS));
+        QVector<double> gains(count);
+        bool finite = count > 0;
+        for (int i = 0; i < count; ++i) {
+            gains[i] = request.gains[i];
+            finite = finite && std::isfinite(gains[i]);
+        }
+        if (!finite || !m_model->setBandGains(gains)) {
+            qWarning() << "IPC: invalid gains in shared request";
+        }
+    }
+    if (request.flags & SharedRequest::Bypass) {
+        m_model->setBypass(request.bypass != 0);
+    }
+}
+
+void IpcServer::publishSharedState()
+{
+    SharedState& state = m_sharedState;
+    if (m_sharedStateDirty.exchange(false, std::memory_order_acq_rel)) {
+        const QVector<double> gains = m_model->getBandGains();
+        state.bandCount = static_cast<uint32_t>(std::min<int>(gains.size(), BiquadBank::MAX_BANDS));
+        std::fill(state.gains, state.gains + BiquadBank::MAX_BANDS, 0.0f);
+        for (uint32_t i = 0; i < state.bandCount; ++i) {
+            state.gains[i] = static_cast<float>(gains[i]);
+        }
+        state.bypass = m_model->isBypassed() ? 1 : 0;
+        state.running = m_model->isAudioRunning() ? 1 : 0;
+        state.latencyMs = static_cast<float>(m_model->measuredLatencyMs());
+    }
+    const LevelMeter::Levels levels = m_meter ? m_meter->levels() : LevelMeter::Levels();
+    state.channels = static_cast<uint32_t>(levels.channels);
+    std::copy(levels.peak, levels.peak + LevelMeter::MAX_CHANNELS, state.peak);
+    std::copy(levels.rms, levels.rms + LevelMeter::MAX_CHANNELS, state.rms);
+    m_shared.publishState(state);
+}
+
+bool IpcServer::processInput(QByteArray& input, QByteArray& reply)
+{
+    const int size = input.size();
+    int pos = 0;
+    bool ok = true;
+    while (pos < size) {
+        if (input[pos] == BINARY_MAGIC) {
+            if (size - pos < BINARY_HEADER_BYTES) {
+                break;
+            }
+            const quint8 type = static_cast<quint8>(input[pos + 1]);
+            const int length = qFromLittleEndian<quint16>(input.constData() + pos + 2);
+            if (size - pos < BINARY_HEADER_BYTES + length) {
+                break;
+            }
+            handleBinary(type, input.constData() + pos + BINARY_HEADER_BYTES, length, reply);
+            pos += BINARY_HEADER_BYTES + length;
+            continue;
+        }
+        const int newline = input.indexOf('\n', pos);
+        if (newline < 0 || newline - pos > MAX_LINE_BYTES) {
+            ok = (newline < 0) && size - pos <= MAX_LINE_BYTES;
+            break;
+        }
+        const QByteArray line = input.mid(pos, newline - pos).trimmed();
+        if (!line.isEmpty()) {
+            handleLine(line, reply);
+        }
+        pos = newline + 1;
+    }
+    input.remove(0, pos);
+    return ok;
+}
+
+void IpcServer::handleLine(const QByteArray& line, QByteArray& reply)
+{
+    // The common case, a whole curve, skips the JSON parser
+    QVector<double> gains;
+    if (parseNumberArray(line, &gains)) {
+        reply.append(m_model->setBandGains(gains) ? "OK\n" : "ERROR\n");
+        return;
+    }
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(line, &error);
+    if (error.error != QJsonParseError::NoError) {
+        reply.append("ERROR\n");
+        return;
+    }
+    if (doc.isObject() && doc.object().contains("get")) {
+        const QByteArray answer = query(doc.object().value("get").toString());
+        reply.append(answer.isEmpty() ? QByteArray("ERROR") : answer);
+        reply.append('\n');
+        return;
+    }
+    reply.append(m_model->setBandGainsJson(doc) ? "OK\n" : "ERROR\n");
+}
+
+void IpcServer::handleBinary(quint8 type, const char* payload, int size, QByteArray& reply)
+{
+    constexpr int FLOAT_BYTES = 4;
+    constexpr int BAND_ENTRY_BYTES = 1 + FLOAT_BYTES;
+
+    switch (type) {
+    case SetGains: {
+        if (size == 0 || size % FLOAT_BYTES != 0) {
+            break;
+        }
+        QVector<double> gains(size / FLOAT_BYTES);
+        bool finite = true;
+        for (int i = 0; i < gains.size(); ++i) {
+            gains[i] = readFloat(payload + i * FLOAT_BYTES);
+            finite = finite && std::isfinite(gains[i]);
+        }
+        if (!finite || !m_model->setBandGains(gains)) {
+            break;
+        }
+        appendHeader(reply, SetGains | REPLY_FLAG, 0);
+        return;
+    }
+    case SetBands: {
+        if (size == 0 || size % BAND_ENTRY_BYTES != 0) {
+            break;
+        }
+        // All or nothing, as for {"band_gains": ...}
+        const int bandCount = m_model->layout().bandCount();
+        bool valid = true;
+        for (int offset = 0; offset < size; offset += BAND_ENTRY_BYTES) {
+            const int band = static_cast<quint8>(payload[offset]);
+            valid = valid && band < bandCount && std::isfinite(readFloat(payload + offset + 1));
+        }
+        if (!valid) {
+            break;
+        }
+        m_model->beginGainUpdate();
+        for (int offset = 0; offset < size; offset += BAND_ENTRY_BYTES) {
+            m_model->setBandGain(static_cast<quint8>(payload[offset]), readFloat(payload + offset + 1));
+        }
+        m_model->commitGainUpdate();
+        appendHeader(reply, SetBands | REPLY_FLAG, 0);
+        return;
+    }
+    case GetGains: {
+        const QVector<double> gains = m_model->getBandGains();
+        appendHeader(reply, GetGains | REPLY_FLAG, gains.size() * FLOAT_BYTES);
+        for (double gain : gains) {
+            appendFloat(reply, static_cast<float>(gain));
+        }
+        return;
+    }
+    case GetStats: {
+        const AudioStats stats = m_model->audioStats();
+        appendHeader(reply, GetStats | REPLY_FLAG, 4 * 4 + 1);
+        appendFloat(reply, static_cast<float>(m_model->measuredLatencyMs()));
+        appendFloat(reply, static_cast<float>(stats.driftPpm));
+        appendUInt32(reply, static_cast<quint32>(stats.underruns));
+        appendUInt32(reply, static_cast<quint32>(stats.droppedFrames));
+        reply.append(m_model->isAudioRunning() ? '\1' : '\0');
+        return;
+    }
+    default:
+        break;
+    }
+    appendHeader(reply, ReplyError, 0);
+}
+
+QByteArray IpcServer::query(const QString& what) const
+{
+    QJsonObject answer;
+    if (what == "gains") {
+        answer["layout"] = EqLayout::kindName(m_model->layout().kind());
+        QJsonArray gains;
+        for (double gain : m_model->getBandGains()) {
+            gains.append(gain);
+        }
+        answer["gains"] = gains;
+    } else if (what == "latency") {
+        answer["latency_ms"] = m_model->measuredLatencyMs();
+        answer["target_ms"] = m_model->latencyTargetMs();
+    } else if (what == "stats") {
+        const AudioStats stats = m_model->audioStats();
+        answer["running"] = m_model->isAudioRunning();
+        answer["latency_ms"] = m_model->measuredLatencyMs();
+        answer["drift_ppm"] = stats.driftPpm;
+        answer["underruns"] = stats.underruns;
+        answer["dropped_frames"] = static_cast<double>(stats.droppedFrames);
+    } else {
+        return QByteArray();
+    }
+    return QJsonDocument(answer).toJson(QJsonDocument::Compact);
+}
@@ -0,0 +1,137 @@
+#ifndef IPCSERVER_H
+#define IPCSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QThread>
+#include "EqualizerViewModel.h"
+#include "levelmeter.h"
+#include "sharedcontrol.h"
+#include <atomic>
+
+class QIODevice;
+class QLocalServer;
+class QTcpServer;
+
+/**
+ * @class IpcServer
+ * @brief Control endpoints for agents and scripts, served from their own threads
+ *
+ * Three endpoints, served off the GUI thread:
+ * - TCP on localhost (DEFAULT_PORT), on the I/O thread
+ * - A Unix domain socket (defaultSocketPath()), same protocol without the
+ *   TCP stack, for local clients, on the I/O thread
+ * - A SharedControl block (SharedControl::DEFAULT_NAME): co-located
+ *   controllers write requests and read the gains, bypass flag and output
+ *   meters straight from memory. A thread of its own sleeps on the block's
+ *   futex and takes a request as soon as it is written; it republishes the
+ *   state when the model changes and the meters every SHARED_METER_MS.
+ *
+ * Socket connections stay open for any number of requests, which may be
+ * pipelined: every complete request in the input is answered in order, and
+ * the replies to one read go out in one write. Two framings can be mixed
+ * on a connection:
+ *
+ * - Text: one JSON document per line, as accepted by
+ *   EqualizerViewModel::setBandGainsJson() (answered "OK" or "ERROR"), or a
+ *   query answered with one line of JSON:
+ *     {"get": "gains"}    -> {"layout": "graphic10", "gains": [...]}
+ *     {"get": "latency"}  -> {"latency_ms": 21.3, "target_ms": 20}
+ *     {"get": "stats"}    -> {"running": true, "latency_ms": ..., "drift_ppm": ...,
+ *                             "underruns": 0, "dropped_frames": 0}
+ *   Plain arrays of numbers are read without the JSON parser. A client that
+ *   closes its side without a final newline still has its last line handled.
+ *
+ * - Binary: BINARY_MAGIC, a message type byte, the payload length (uint16
+ *   little-endian) and the payload; all numbers little-endian, gains as
+ *   float32 dB. Replies use the same header with the request type plus
+ *   REPLY_FLAG, or ReplyError with no payload.
+ *     SetGains  n x float32 (the layout's band count, or 10 to be mapped)
+ *     SetBands  n x (uint8 band, float32 gain), applied as one transaction
+ *     GetGains  -> n x float32
+ *     GetStats  -> float32 latency ms, float32 drift ppm, uint32 underruns,
+ *                  uint32 dropped frames, uint8 running
+ *
+ * Requests act on the model, whose state is mutex-protected; the change
+ * notifications reach the UI and the audio controller through queued
+ * signals. Parsing, queries and replies never wait for the GUI thread.
+ * Handling the notifications is cheap there, except for a latency target
+ * change: AudioController reopens the audio streams for it on the GUI
+ * thread, which blocks that thread while the sound server connects.
+ */
+class IpcServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr quint16 DEFAULT_PORT = 5560;
+    static constexpr int SHARED_METER_MS = 20;
+    static constexpr char BINARY_MAGIC = '\xEB';  // Never starts UTF-8 text
+    static constexpr int BINARY_HEADER_BYTES = 4;
+    static constexpr quint8 REPLY_FLAG = 0x80;
+    // A longer line or an unterminated one beyond this closes the connection
+    static constexpr int MAX_LINE_BYTES = 64 * 1024;
+
+    enum MessageType : quint8 {
+        SetGains = 0x01,
+        SetBands = 0x02,
+        GetGains = 0x10,
+        GetStats = 0x11,
+        ReplyError = 0xFF
+    };
+
+    // The model and the meter (optional) must outlive the server
+    explicit IpcServer(EqualizerViewModel* model, const LevelMeter* meter = nullptr);
+    ~IpcServer() override;
+
+    // $XDG_RUNTIME_DIR/ai_equalizer.sock, else in the temp directory
+    static QString defaultSocketPath();
+    // Before start(); empty disables the endpoint
+    void setLocalSocketPath(const QString& path) { m_socketPath = path; }
+    void setSharedMemoryName(const QString& name) { m_sharedName = name; }
+
+    // Starts the I/O thread and opens the endpoints; false if none of them
+    // could be opened
+    bool start(quint16 port = DEFAULT_PORT);
+    // Closes all connections and ends the thread
+    void stop();
+
+private:
+    EqualizerViewModel* m_model;
+    const LevelMeter* m_meter;
+    QString m_socketPath;
+    QString m_sharedName;
+    QThread m_thread;
+    // I/O thread only
+    QTcpServer* m_server{nullptr};
+    QLocalServer* m_localServer{nullptr};
+    QHash<QIODevice*, QByteArray> m_buffers;  // Unconsumed input per connection
+    SharedControl m_shared;
+    QThread* m_sharedThread{nullptr};
+    std::atomic<bool> m_sharedStopping{false};
+    std::atomic<bool> m_sharedStateDirty{true};  // Model side of m_sharedState is stale
+    SharedState m_sharedState{};  // Shared-memory thread only
+
+    bool listen(quint16 port);
+    bool listenLocal();
+    bool openShared();
+    void close();
+    void onNewConnection();
+    void onNewLocalConnection();
+    void addConnection(QIODevice* socket);
+    void closeConnection(QIODevice* socket);
+    void onReadyRead(QIODevice* socket);
+    void onReadFinished(QIODevice* socket);
+    void serveShared();
+    void applySharedRequest(const SharedRequest& request);
+    void publishSharedState();
+    // Consumes the complete requests at the front of the input and appends
+    // their replies; false on a protocol error
+    bool processInput(QByteArray& input, QByteArray& reply);
+    void handleLine(const QByteArray& line, QByteArray& reply);
+    void handleBinary(quint8 type, const char* payload, int size, QByteArray& reply);
+    QByteArray query(const QString& what) const;
+};
+
+#endif // IPCSERVER_H
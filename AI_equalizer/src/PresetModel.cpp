@@ -22,7 +22,7 @@ QVector<double> PresetModel::getPresetGains(int index) const
     if (index >= 0 && index < names.size()) {
         return m_presets.value(names[index]).bandGains;
     }
-    return QVector<double>(10, 0.0);
+    return QVector<double>(EQPreset::NUM_BANDS, 0.0);
 }
 
 bool PresetModel::hasPreset(const QString& name) const
@@ -38,7 +38,7 @@ void PresetModel::savePreset(const QString& name, const QVector<double>& gains)
 void PresetModel::initializeDefaultPresets()
 {
     // Flat (no change)
-    m_presets["Flat"] = EQPreset("Flat", QVector<double>(10, 0.0));
+    m_presets["Flat"] = EQPreset("Flat", QVector<double>(EQPreset::NUM_BANDS, 0.0));
     
     // Rock - Enhanced lows and highs
     m_presets["Rock"] = EQPreset("Rock", {
@@ -6,11 +6,15 @@
 #include <QMap>
 #include <QVector>
 
+// Presets are stored on the 10-band graphic grid; EqualizerViewModel maps
+// them onto other layouts
 struct EQPreset {
+    static constexpr int NUM_BANDS = 10;
+    
     QString name;
-    QVector<double> bandGains; // 10 bands
+    QVector<double> bandGains;
     
-    EQPreset() : bandGains(10, 0.0) {}
+    EQPreset() : bandGains(NUM_BANDS, 0.0) {}
     EQPreset(const QString& n, const QVector<double>& gains) 
         : name(n), bandGains(gains) {}
 };
@@ -0,0 +1,130 @@
+#include "audiobackend.h"
+#include "filebackend.h"
+#include "nullbackend.h"
+#include "pareccapture.h"
+#include "pulsecapture.h"
+#include "pulsesink.h"
+#include <QMap>
+#include <QStringList>
+
+namespace {
+
+// Format of headerless capture files unless given as options
+constexpr int RAW_DEFAULT_RATE = 44100;
+constexpr int RAW_DEFAULT_CHANNELS = 2;
+
+struct BackendSpec {
+    QString kind;
+    QString argument;
+    QMap<QString, QString> options;  // Flags map to an empty value
+};
+
+BackendSpec parseSpec(const QString& spec)
+{
+    BackendSpec parsed;
+    const QStringList parts = spec.split(',');
+    const QString head = parts.value(0).trimmed();
+    const int colon = head.indexOf(':');
+    parsed.kind = (colon < 0 ? head : head.left(colon)).toLower();
+    parsed.argument = colon < 0 ? QString() : head.mid(colon + 1);
+    for (int i = 1; i < parts.size(); ++i) {
+        const QString option = parts[i].trimmed();
+        const int equals = option.indexOf('=');
+        parsed.options.insert((equals < 0 ? option : option.left(equals)).toLower(),
+                              equals < 0 ? QString() : option.mid(equals + 1));
+    }
+    if (parsed.kind.isEmpty()) {
+        parsed.kind = AudioBackend::DEFAULT_SPEC;
+    }
+    return parsed;
+}
+
+bool parseSampleFormat(const QString& name, SampleFormat* format)
+{
+    const QString lower = name.toLower();
+    if (lower.isEmpty() || lower == "float" || lower == "float32" || lower == "float32le") {
+        *format = SampleFormat::Float32;
+    } else if (lower == "s16" || lower == "s16le") {
+        *format = SampleFormat::S16;
+    } else if (lower == "s24" || lower == "s24le") {
+        *format = SampleFormat::S24;
+    } else if (lower == "s32" || lower == "s32le") {
+        *format = SampleFormat::S32;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void setError(QString* error, const QString& message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+} // namespace
+
+std::unique_ptr<AudioCaptureBackend> AudioBackend::createCapture(const QString& spec, QString* error)
+{
+    const BackendSpec parsed = parseSpec(spec);
+    const bool realtime = parsed.options.contains("realtime");
+    if (parsed.kind == "pulse") {
+        return std::make_unique<PulseCapture>(parsed.argument.isEmpty() ? PulseCapture::DEFAULT_SOURCE
+                                                                        : parsed.argument);
+    }
+    if (parsed.kind == "parec") {
+        return std::make_unique<ParecCapture>(parsed.argument.isEmpty() ? PulseCapture::DEFAULT_SOURCE
+                                                                        : parsed.argument);
+    }
+    if (parsed.kind == "file") {
+        if (parsed.argument.isEmpty()) {
+            setError(error, "File capture needs a path (file:<path>)");
+            return nullptr;
+        }
+        AudioStreamFormat raw;
+        raw.sampleRate = parsed.options.value("rate", QString::number(RAW_DEFAULT_RATE)).toInt();
+        raw.channels = parsed.options.value("channels", QString::number(RAW_DEFAULT_CHANNELS)).toInt();
+        if (!parseSampleFormat(parsed.options.value("format"), &raw.format) || raw.sampleRate <= 0
+            || raw.channels <= 0) {
+            setError(error, QString("Invalid raw file format in '%1'").arg(spec));
+            return nullptr;
+        }
+        return std::make_unique<FileCapture>(parsed.argument, raw, realtime);
+    }
+    if (parsed.kind == "sine" || parsed.kind == "noise" || parsed.kind == "silence") {
+        GeneratorCapture::Waveform waveform = GeneratorCapture::Waveform::Silence;
+        if (parsed.kind == "sine") {
+            waveform = GeneratorCapture::Waveform::Sine;
+        } else if (parsed.kind == "noise") {
+            waveform = GeneratorCapture::Waveform::Noise;
+        }
+        const double frequency = parsed.argument.isEmpty() ? 1000.0 : parsed.argument.toDouble();
+        const double seconds = parsed.options.value("seconds").toDouble();
+        return std::make_unique<GeneratorCapture>(waveform, frequency, seconds, realtime);
+    }
+    setError(error, QString("Unknown capture backend '%1'").arg(spec));
+    return nullptr;
+}
+
+std::unique_ptr<AudioSinkBackend> AudioBackend::createSink(const QString& spec, QString* error)
+{
+    const BackendSpec parsed = parseSpec(spec);
+    if (parsed.kind == "pulse") {
+        return std::make_unique<PulseSink>(parsed.argument.isEmpty() ? PulseSink::DEFAULT_SINK
+                                                                     : parsed.argument);
+    }
+    if (parsed.kind == "file") {
+        SampleFormat format = SampleFormat::Float32;
+        if (parsed.argument.isEmpty() || !parseSampleFormat(parsed.options.value("format"), &format)) {
+            setError(error, QString("File sink needs a path and a valid format: '%1'").arg(spec));
+            return nullptr;
+        }
+        return std::make_unique<FileSink>(parsed.argument, format);
+    }
+    if (parsed.kind == "null") {
+        return std::make_unique<NullSink>(parsed.options.contains("realtime"));
+    }
+    setError(error, QString("Unknown sink backend '%1'").arg(spec));
+    return nullptr;
+}
@@ -0,0 +1,120 @@
+#ifndef AUDIOBACKEND_H
+#define AUDIOBACKEND_H
+
+#include <QString>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include "sampleformat.h"
+
+// Interleaved stream layout. In preferredFormat(), a backend leaves
+// sampleRate or channels at 0 when it can take any value.
+struct AudioStreamFormat {
+    int sampleRate{0};
+    int channels{0};
+    SampleFormat format{SampleFormat::Float32};
+
+    int bytesPerFrame() const { return bytesPerSample(format) * channels; }
+};
+
+/**
+ * @class AudioCaptureBackend
+ * @brief Source of interleaved frames for AudioProcessor
+ *
+ * start() begins delivering frames to the callback from a backend-owned
+ * thread, in fragments of about fragmentFrames; the callback must not
+ * block. A real-time backend is paced by a device clock; any other
+ * (file, generator) delivers as fast as the callback returns, and the
+ * processor applies backpressure instead of dropping audio.
+ */
+class AudioCaptureBackend {
+public:
+    using FrameCallback = std::function<void(const void* frames, int frameCount)>;
+
+    virtual ~AudioCaptureBackend() = default;
+
+    virtual const char* name() const = 0;
+    // The device's or file's own format; streams in it need no conversion
+    virtual AudioStreamFormat preferredFormat() { return AudioStreamFormat(); }
+    // Whether start() only accepts preferredFormat() (e.g. a file)
+    virtual bool requiresPreferredFormat() const { return false; }
+    virtual bool isRealtime() const { return true; }
+
+    // Blocks until frames flow or starting failed (see lastError())
+    virtual bool start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback) = 0;
+    // Returns once the callback can no longer run
+    virtual void stop() = 0;
+    // Keeps the stream open but stops delivery where the source allows it
+    // (callbacks may still arrive); for a warm restart
+    virtual void setPaused(bool paused) { (void)paused; }
+    // A finite source has delivered everything, or the device went away
+    virtual bool isFinished() const { return false; }
+    // Source-to-callback delay; 0 if unknown. Read by the audio thread, so it
+    // must not block
+    virtual double latencyMs() { return 0.0; }
+    // Another backend for the same source, to try when start() fails
+    virtual std::unique_ptr<AudioCaptureBackend> createFallback() const { return nullptr; }
+
+    QString lastError() const { return m_lastError; }
+
+protected:
+    QString m_lastError;
+};
+
+/**
+ * @class AudioSinkBackend
+ * @brief Destination for AudioProcessor's writer thread
+ *
+ * write() is called from a single thread and blocks while the device buffer
+ * is full, which is what paces the writer for a real-time sink. Other sinks
+ * accept frames as fast as they come.
+ */
+class AudioSinkBackend {
+public:
+    virtual ~AudioSinkBackend() = default;
+
+    virtual const char* name() const = 0;
+    virtual AudioStreamFormat preferredFormat() { return AudioStreamFormat(); }
+    virtual bool requiresPreferredFormat() const { return false; }
+    virtual bool isRealtime() const { return true; }
+
+    // bufferMs: playback buffering to ask the device for
+    virtual bool open(const AudioStreamFormat& format, int bufferMs) = 0;
+    virtual bool write(const void* frames, int frameCount) = 0;
+    // Written but not yet audible, in µs; -1 if unknown
+    virtual int64_t bufferedUsec() { return -1; }
+    // Blocks until everything written has been played
+    virtual void drain() {}
+    // Releases the device without waiting; unplayed audio is dropped
+    virtual void close() = 0;
+
+    QString lastError() const { return m_lastError; }
+
+protected:
+    QString m_lastError;
+};
+
+/**
+ * @class AudioBackend
+ * @brief Creates capture and sink backends from a spec string
+ *
+ * Specs are "kind[:argument][,option=value...]":
+ * - Capture: "pulse" (default), "parec", "file:<path>", "sine:<hz>",
+ *   "noise", "silence"
+ * - Sink: "pulse" (default), "file:<path>", "null"
+ *
+ * Files are WAV, or headerless with a ".raw" extension (options rate,
+ * channels and format describe them). Generators and the null sink run
+ * faster than real time unless given the "realtime" option; generators
+ * stop after "seconds" if set. Sink files are written in "format" (s16,
+ * s24, s32 or float, the default).
+ */
+class AudioBackend {
+public:
+    static constexpr const char* DEFAULT_SPEC = "pulse";
+
+    static std::unique_ptr<AudioCaptureBackend> createCapture(const QString& spec, QString* error = nullptr);
+    static std::unique_ptr<AudioSinkBackend> createSink(const QString& spec, QString* error = nullptr);
+};
+
+#endif // AUDIOBACKEND_H
@@ -1,36 +1,34 @@
 #include "audioprocessor.h"
 #include <QDebug>
-#include <QFile>
-#include <QTextStream>
+#include <algorithm>
 
 /**
  * AudioProcessor Implementation
  * 
- * This implementation uses PulseAudio's 'parec' utility for audio capture because:
+ * The default PulseAudio backends record through the PulseAudio API (PulseCapture) because:
  * 1. Qt's QAudioSource fails to enumerate PulseAudio monitor sources in WSL/RDP
- * 2. parec has direct PA API access and reliably captures from virtual sinks
+ * 2. A native record stream delivers fixed-size fragments with no pipe or polling
  * 3. Monitor sources (.monitor suffix) provide zero-latency audio loopback
+ * The 'parec' utility remains as a fallback capture path.
  * 
- * Prerequisites:
+ * Prerequisites (PulseAudio backends):
  * - PulseAudio/PipeWire running with module-null-sink loaded
  * - Virtual sink 'Equalizer_Input' created (via setup_virtual_sink.sh)
- * - parec utility installed (pulseaudio-utils package)
+ * - parec utility installed (pulseaudio-utils package) for the fallback path
  * - Audio source routed to 'Equalizer_Input' sink
  */
 
 AudioProcessor::AudioProcessor(EqualizerEngine* equalizer, QObject *parent)
     : QObject(parent)
     , m_equalizer(equalizer)
-    , m_parecProcess(nullptr)
-    , m_paOutput(nullptr)
-    , m_readThread(nullptr)
+    , m_control(std::make_unique<EngineControl>(equalizer))
     , m_writeThread(nullptr)
     , m_running(false)
     , m_totalBytesProcessed(0)
     , m_processingCycles(0)
 {
     Q_ASSERT(m_equalizer != nullptr);
-    setupAudioFormat();
+    setupAudioFormat(CHANNEL_COUNT, DEFAULT_SAMPLE_RATE);
 }
 
 AudioProcessor::~AudioProcessor()
@@ -38,20 +36,144 @@ AudioProcessor::~AudioProcessor()
     // Ensure clean shutdown even if stop() wasn't called
     if (m_running) {
         qWarning() << "AudioProcessor destroyed while running - forcing stop()";
+    }
+    if (m_capture) {
         stop();
     }
 }
 
-void AudioProcessor::setupAudioFormat()
+bool AudioProcessor::setChannelCount(int channels)
+{
+    if (m_running) {
+        qWarning() << "Channel count can only be changed while stopped";
+        return false;
+    }
+    if (channels < 1 || channels > EqualizerEngine::MAX_CHANNELS) {
+        qWarning() << "Unsupported channel count:" << channels
+                    << "(1 to" << EqualizerEngine::MAX_CHANNELS << ")";
+        return false;
+    }
+    setupAudioFormat(channels, m_format.sampleRate());
+    closeStreams();
+    return true;
+}
+
+bool AudioProcessor::setSampleRate(int rate)
+{
+    if (m_running) {
+        qWarning() << "Sample rate can only be changed while stopped";
+        return false;
+    }
+    if (rate != 0 && !CoefficientTable::isTabulated(rate)) {
+        qWarning() << "Unsupported sample rate:" << rate << "Hz";
+        return false;
+    }
+    m_requestedSampleRate = rate;
+    closeStreams();
+    return true;
+}
+
+bool AudioProcessor::setCaptureBackend(const QString& spec)
+{
+    if (m_running) {
+        qWarning() << "Capture backend can only be changed while stopped";
+        return false;
+    }
+    // Backends are created per start(); this only checks the spec
+    QString error;
+    if (!AudioBackend::createCapture(spec, &error)) {
+        qWarning() << error;
+        return false;
+    }
+    m_captureSpec = spec;
+    closeStreams();
+    return true;
+}
+
+bool AudioProcessor::setSinkBackend(const QString& spec)
+{
+    if (m_running) {
+        qWarning() << "Sink backend can only be changed while stopped";
+        return false;
+    }
+    QString error;
+    if (!AudioBackend::createSink(spec, &error)) {
+        qWarning() << error;
+        return false;
+    }
+    m_sinkSpec = spec;
+    return true;
+}
+
+bool AudioProcessor::setLatencyTargetMs(int ms)
+{
+    if (m_running) {
+        qWarning() << "Latency target can only be changed while stopped";
+        return false;
+    }
+    if (ms != 0 && (ms < MIN_LATENCY_MS || ms > MAX_LATENCY_MS)) {
+        qWarning() << "Unsupported latency target:" << ms << "ms (0 or"
+                   << MIN_LATENCY_MS << "to" << MAX_LATENCY_MS << ")";
+        return false;
+    }
+    if (ms != m_latencyTargetMs) {
+        m_latencyTargetMs = ms;
+        closeStreams();  // The playback buffer is sized at open
+    }
+    return true;
+}
+
+bool AudioProcessor::setQueueCapacityMs(int ms)
+{
+    if (m_running) {
+        qWarning() << "Queue capacity can only be changed while stopped";
+        return false;
+    }
+    if (ms < PREBUFFER_MS) {
+        qWarning() << "Queue capacity must hold the prebuffer (" << PREBUFFER_MS << "ms)";
+        return false;
+    }
+    m_queueCapacityMs = ms;
+    closeStreams();
+    return true;
+}
+
+bool AudioProcessor::setOverflowPolicy(RingBuffer::OverflowPolicy policy)
+{
+    if (m_running) {
+        qWarning() << "Overflow policy can only be changed while stopped";
+        return false;
+    }
+    m_overflowPolicy = policy;
+    closeStreams();
+    return true;
+}
+
+bool AudioProcessor::setCaptureFragmentMs(int ms)
+{
+    if (m_running) {
+        qWarning() << "Capture fragment length can only be changed while stopped";
+        return false;
+    }
+    if (ms < 1 || ms > 1000) {
+        qWarning() << "Unsupported capture fragment length:" << ms << "ms";
+        return false;
+    }
+    m_captureFragmentMs = ms;
+    closeStreams();
+    return true;
+}
+
+void AudioProcessor::setupAudioFormat(int channels, int sampleRate)
 {
-    // Configure audio format for 44.1kHz stereo float32
-    // This matches PulseAudio's native format for zero-copy processing
-    m_format.setSampleRate(SAMPLE_RATE);
-    m_format.setChannelCount(CHANNEL_COUNT);
+    // Frames travel between capture and playback as float32; the streams
+    // themselves use whatever format the devices have (see negotiateFormat)
+    m_format.setSampleRate(sampleRate);
+    m_format.setChannelCount(channels);
     m_format.setSampleFormat(QAudioFormat::Float);
     
     // Sync equalizer engine with our sample rate
-    m_equalizer->setSampleRate(m_format.sampleRate());
+    m_control->setSampleRate(m_format.sampleRate());
     
     qDebug() << "Audio format configured:"
              << "Rate:" << m_format.sampleRate() << "Hz"
@@ -60,6 +182,74 @@ void AudioProcessor::setupAudioFormat()
              << "| Frame size:" << m_format.bytesPerFrame() << "bytes";
 }
 
+bool AudioProcessor::negotiateFormat()
+{
+    // Run at the devices' own rate and format so nothing has to convert;
+    // the coefficient table covers every supported rate
+    const AudioStreamFormat capture = m_capture->preferredFormat();
+    if (!m_capture->lastError().isEmpty()) {
+        setError(m_capture->lastError());
+        return false;
+    }
+    const AudioStreamFormat sink = m_sink->preferredFormat();
+    if (!m_sink->lastError().isEmpty()) {
+        setError(m_sink->lastError());
+        return false;
+    }
+    m_captureFormat = capture.format;
+    m_playbackFormat = sink.format;
+    
+    // A fixed-format capture (a file) dictates the layout
+    int channels = m_format.channelCount();
+    int rate = m_requestedSampleRate;
+    if (m_capture->requiresPreferredFormat() && capture.channels > 0) {
+        channels = capture.channels;
+    }
+    if (m_capture->requiresPreferredFormat() && capture.sampleRate > 0) {
+        if (rate != 0 && rate != capture.sampleRate) {
+            qWarning() << "Ignoring requested rate" << rate << "Hz: the capture is fixed at"
+                       << capture.sampleRate << "Hz";
+        }
+        rate = capture.sampleRate;
+    } else if (m_sink->requiresPreferredFormat() && sink.sampleRate > 0) {
+        rate = sink.sampleRate;
+    } else if (rate == 0) {
+        if (CoefficientTable::isTabulated(sink.sampleRate)) {
+            rate = sink.sampleRate;
+        } else if (CoefficientTable::isTabulated(capture.sampleRate)) {
+            rate = capture.sampleRate;
+        } else {
+            rate = DEFAULT_SAMPLE_RATE;
+        }
+    }
+    if (rate != m_format.sampleRate() || channels != m_format.channelCount()) {
+        setupAudioFormat(channels, rate);
+    }
+    
+    qDebug() << "Capture:" << m_capture->name()
+             << (capture.sampleRate ? QString("%1 Hz %2").arg(capture.sampleRate).arg(sampleFormatName(capture.format))
+                                    : QString("any rate"))
+             << "| Playback:" << m_sink->name()
+             << (sink.sampleRate ? QString("%1 Hz %2").arg(sink.sampleRate).arg(sampleFormatName(sink.format))
+                                 : QString("any rate"));
+    if (capture.sampleRate && capture.sampleRate != rate) {
+        qWarning() << "Capture will be resampled by the server:" << capture.sampleRate << "→" << rate << "Hz";
+    }
+    if (sink.sampleRate && sink.sampleRate != rate) {
+        qWarning() << "Playback will be resampled by the server:" << rate << "→" << sink.sampleRate << "Hz";
+    }
+    return true;
+}
+
+AudioStreamFormat AudioProcessor::streamFormat(SampleFormat format) const
+{
+    AudioStreamFormat stream;
+    stream.sampleRate = m_format.sampleRate();
+    stream.channels = m_format.channelCount();
+    stream.format = format;
+    return stream;
+}
+
 bool AudioProcessor::start()
 {
     if (m_running) {
@@ -67,343 +257,444 @@ bool AudioProcessor::start()
         return true;
     }
     
+    if (m_capture) {
+        if (resume()) {
+            return true;
+        }
+        closeStreams();
+    }
+    
     qDebug() << "\n=== Starting Audio Processor ===";
     
+    m_lastError.clear();
+    QString error;
+    m_capture = AudioBackend::createCapture(m_captureSpec, &error);
+    m_sink = AudioBackend::createSink(m_sinkSpec, &error);
+    if (!m_capture || !m_sink) {
+        setError(error);
+        releaseBackends();
+        return false;
+    }
+    if (!negotiateFormat()) {
+        releaseBackends();
+        return false;
+    }
+    
     // Validate audio format before starting
     if (!validateAudioFormat()) {
         setError("Invalid audio format configuration");
+        releaseBackends();
         return false;
     }
     
-    // Reset statistics
-    m_totalBytesProcessed = 0;
-    m_processingCycles = 0;
-    m_lastError.clear();
-    
-    // Step 1: Find suitable output device (RDPSink for WSL/RDP environments)
-    QAudioDevice outputDevice;
-    QList<QAudioDevice> audioOutputs = QMediaDevices::audioOutputs();
-    
-    qDebug() << "Scanning for output devices...";
-    qDebug() << "Available outputs (" << audioOutputs.size() << " total):";
-    for (const QAudioDevice& device : audioOutputs) {
-        QString desc = device.description();
-        qDebug() << "  -" << desc << (device.isDefault() ? "[DEFAULT]" : "");
-        
-        // Prefer RDP sink for WSL/RDP, but remember any device as fallback
-        if (desc.contains(OUTPUT_SINK_KEYWORD, Qt::CaseInsensitive)) {
-            outputDevice = device;
-            qDebug() << "    ^ Selected (matched keyword:" << OUTPUT_SINK_KEYWORD << ")";
-        }
-    }
-    
-    // Fallback to default output if no RDP sink found
-    if (outputDevice.isNull() && !audioOutputs.isEmpty()) {
-        outputDevice = QMediaDevices::defaultAudioOutput();
-        qWarning() << "RDPSink not found, using default output:" << outputDevice.description();
+    // Without a device clock on both ends there is nothing to drift against
+    // and no deadline to meet: block instead of dropping audio
+    m_realtime = m_capture->isRealtime() && m_sink->isRealtime();
+    const RingBuffer::OverflowPolicy policy = m_realtime ? m_overflowPolicy : RingBuffer::OverflowPolicy::Block;
+    
+    // Preallocate the streaming buffers; nothing allocates while running
+    m_queue.reset(framesForMs(m_queueCapacityMs), m_format.channelCount(), policy);
+    m_writeChunk.assign(static_cast<size_t>(WRITE_CHUNK_FRAMES) * m_format.channelCount(), 0.0f);
+    
+    // Split the latency target between the playback buffer and the jitter buffer
+    const int rate = m_format.sampleRate();
+    int playbackMs = STABLE_PLAYBACK_MS;
+    if (m_latencyTargetMs > 0) {
+        playbackMs = m_latencyTargetMs / 2;
+        const int jitterFrames = (m_latencyTargetMs - playbackMs) * rate / 1000;
+        m_jitter.configure(jitterFrames, MAX_LATENCY_MS * rate / 1000, rate);
+        m_writeChunkFrames = std::min(WRITE_CHUNK_FRAMES, jitterFrames);
+    } else {
+        m_jitter.configure(framesForMs(PREBUFFER_MS), framesForMs(PREBUFFER_MS), rate);
+        m_writeChunkFrames = WRITE_CHUNK_FRAMES;
     }
-    
-    if (outputDevice.isNull()) {
-        setError("No audio output device available");
+    m_trimmedFrames = 0;
+    m_measuredLatencyMs.store(0.0, std::memory_order_relaxed);
+    m_underruns.store(0, std::memory_order_relaxed);
+    m_drift.configure(rate, DriftResampler::MAX_DEVIATION);
+    m_resampled.assign(static_cast<size_t>(DriftResampler::maxOutputFrames(WRITE_CHUNK_FRAMES))
+                       * m_format.channelCount() * bytesPerSample(m_playbackFormat), 0);
+    m_driftPpm.store(0.0, std::memory_order_relaxed);
+    qDebug() << "Latency mode:" << (m_latencyTargetMs > 0 ? "low" : "stable")
+             << "| playback buffer:" << playbackMs << "ms"
+             << "| jitter buffer:" << m_jitter.targetFrames() * 1000.0 / rate << "ms";
+    
+    // Step 1: Open the sink
+    m_playbackBufferMs = playbackMs;
+    if (!m_sink->open(streamFormat(m_playbackFormat), playbackMs)) {
+        setError(m_sink->lastError());
+        releaseBackends();
         return false;
     }
+    m_openSinkSpec = m_sinkSpec;
     
-    // Step 2: Initialize PulseAudio output
-    qDebug() << "\nInitializing PulseAudio output...";
-    qDebug() << "Output sink:" << OUTPUT_SINK_KEYWORD;
-    
-    pa_sample_spec ss;
-    ss.format = PA_SAMPLE_FLOAT32LE;
-    ss.rate = SAMPLE_RATE;
-    ss.channels = CHANNEL_COUNT;
-    
-    pa_buffer_attr bufattr;
-    bufattr.maxlength = (uint32_t) -1;
-    bufattr.tlength = pa_usec_to_bytes(200000, &ss); // 200ms target latency (more stable)
-    bufattr.prebuf = (uint32_t) -1;
-    bufattr.minreq = (uint32_t) -1;
-    
-    int error;
-    m_paOutput = pa_simple_new(
-        nullptr,                    // Default server
-        "AI_Equalizer",            // Application name
-        PA_STREAM_PLAYBACK,        // Playback stream
-        OUTPUT_SINK_KEYWORD,       // Sink name
-        "Equalized Audio",         // Stream description
-        &ss,                       // Sample format
-        nullptr,                   // Default channel map
-        &bufattr,                  // Buffer attributes
-        &error                     // Error code
-    );
-    
-    if (!m_paOutput) {
-        setError(QString("Failed to create PulseAudio output: %1").arg(pa_strerror(error)));
-        qCritical() << "pa_simple_new failed:" << pa_strerror(error);
+    // Step 2: Start capture; frames are equalized as they arrive
+    m_running = true;
+    if (!startCapture()) {
+        m_running = false;
+        m_sink->close();
+        releaseBackends();
         return false;
     }
     
-    qDebug() << "PulseAudio output initialized successfully";
-    qDebug() << "Format: float32le," << CHANNEL_COUNT << "ch," << SAMPLE_RATE << "Hz";
-    
-    // Step 3: Launch parec process to capture from monitor source
-    qDebug() << "\nLaunching parec capture process...";
-    qDebug() << "Monitor source:" << MONITOR_SOURCE;
-    
-    m_parecProcess = new QProcess(this);
+    // Step 3: Start the writer thread
+    startWriter();
     
-    // Connect diagnostics only; processing handled by worker threads
-    connect(m_parecProcess, &QProcess::errorOccurred, this, &AudioProcessor::onParecError);
-    connect(m_parecProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
-            this, &AudioProcessor::onParecFinished);
-    
-    // Build parec command arguments
-    QStringList args;
-    args << QString("--device=%1").arg(MONITOR_SOURCE)
-         << "--format=float32le"
-         << QString("--rate=%1").arg(m_format.sampleRate())
-         << QString("--channels=%1").arg(m_format.channelCount());
-    
-    qDebug() << "Command: parec" << args.join(" ");
-    
-    m_parecProcess->start("parec", args);
+    qDebug() << "\n✓ Audio processor started successfully";
+    qDebug() << "EQ latency:" << latencyMs() << "ms";
+    qDebug() << "Audio flow:" << m_capture->name() << "→ EQ (C++) →" << m_sink->name()
+             << (m_realtime ? "" : "(unpaced)") << "\n";
     
-    if (!m_parecProcess->waitForStarted(STARTUP_TIMEOUT_MS)) {
-        QString error = m_parecProcess->errorString();
-        setError(QString("Failed to start parec: %1").arg(error));
-        qCritical() << "parec startup failed after" << STARTUP_TIMEOUT_MS << "ms";
-        qCritical() << "Error:" << error;
-        qCritical() << "Make sure:";
-        qCritical() << "  1. 'parec' is installed (apt install pulseaudio-utils)";
-        qCritical() << "  2. Virtual sink exists (run setup_virtual_sink.sh)";
-        qCritical() << "  3. PulseAudio/PipeWire is running";
-        
-        // Cleanup on failure
-        if (m_paOutput) {
-            pa_simple_free(m_paOutput);
-            m_paOutput = nullptr;
+    return true;
+}
+
+bool AudioProcessor::startCapture()
+{
+    // Low-latency targets also shorten the capture fragments
+    const int fragmentFrames = std::min(framesForMs(m_captureFragmentMs), m_jitter.minFrames());
+    const auto callback = [this](const void* frames, int frameCount) { onCapturedFrames(frames, frameCount); };
+    while (!m_capture->start(streamFormat(m_captureFormat), fragmentFrames, callback)) {
+        const QString error = m_capture->lastError();
+        std::unique_ptr<AudioCaptureBackend> fallback = m_capture->createFallback();
+        if (!fallback) {
+            setError(error);
+            return false;
         }
-        delete m_parecProcess;
-        m_parecProcess = nullptr;
+        qWarning() << m_capture->name() << "capture failed:" << error << "| falling back to" << fallback->name();
+        m_capture = std::move(fallback);
+    }
+    return true;
+}
+
+bool AudioProcessor::resume()
+{
+    if (m_capture->isFinished()) {
+        return false;  // Ended or lost while suspended
+    }
+    qDebug() << "\n=== Resuming Audio Processor ===";
+    m_lastError.clear();
+    if (m_sinkSpec != m_openSinkSpec && !reopenSink()) {
         return false;
     }
-    
-    qDebug() << "parec process started (PID:" << m_parecProcess->processId() << ")";
-    
-    // Start worker threads
+    // What a live source queued before the pause is stale by now
+    if (m_realtime) {
+        m_queue.discard(m_queue.availableFrames());
+    }
     m_running = true;
-    m_readThread = QThread::create([this]{ readAudioLoop(); });
-    m_writeThread = QThread::create([this]{ writeAudioLoop(); });
-    m_readThread->start();
-    m_writeThread->start();
-    
-    qDebug() << "\n✓ Audio processor started successfully";
-    qDebug() << "Audio flow: " << MONITOR_SOURCE << "→ parec → EQ (C++) → PulseAudio →" 
-             << OUTPUT_SINK_KEYWORD << "\n";
-    
+    m_capture->setPaused(false);
+    startWriter();
+    qDebug() << "✓ Audio processor resumed:" << m_capture->name() << "→ EQ (C++) →" << m_sink->name() << "\n";
     return true;
 }
 
-void AudioProcessor::stop()
+bool AudioProcessor::reopenSink()
 {
-    if (!m_running) {
-        qDebug() << "Audio processor already stopped";
-        return;
+    QString error;
+    std::unique_ptr<AudioSinkBackend> sink = AudioBackend::createSink(m_sinkSpec, &error);
+    if (!sink) {
+        return false;
     }
-    
-    qDebug() << "\n=== Stopping Audio Processor ===";
-    
-    // Stop threads first
-    m_running = false;
-    if (m_readThread) {
-        m_readThread->quit();
-        m_readThread->wait();
-        delete m_readThread;
-        m_readThread = nullptr;
+    const AudioStreamFormat preferred = sink->preferredFormat();
+    // The stream's rate and the queue's policy stay; a sink that needs
+    // others takes a full start
+    if (!sink->lastError().isEmpty() || (m_capture->isRealtime() && sink->isRealtime()) != m_realtime
+        || (sink->requiresPreferredFormat() && preferred.sampleRate > 0
+            && preferred.sampleRate != m_format.sampleRate())) {
+        return false;
+    }
+    const SampleFormat format = preferred.format;
+    if (!sink->open(streamFormat(format), m_playbackBufferMs)) {
+        return false;
+    }
+    m_sink->close();
+    m_sink = std::move(sink);
+    m_openSinkSpec = m_sinkSpec;
+    if (format != m_playbackFormat) {
+        m_playbackFormat = format;
+        m_resampled.assign(static_cast<size_t>(DriftResampler::maxOutputFrames(WRITE_CHUNK_FRAMES))
+                           * m_format.channelCount() * bytesPerSample(m_playbackFormat), 0);
     }
+    qDebug() << "Sink switched to" << m_sink->name();
+    return true;
+}
+
+void AudioProcessor::startWriter()
+{
+    // The first block runs with everything posted so far
+    m_control->flush();
+    m_totalBytesProcessed = 0;
+    m_processingCycles = 0;
+    m_inputEnded = false;
+    m_resampler.reset(m_format.channelCount());
+    if (m_levelMeter) {
+        m_levelMeter->setSampleRate(m_format.sampleRate());
+    }
+    m_runTimer.start();
+    m_writeThread = QThread::create([this]{ writeAudioLoop(); });
+    m_writeThread->start();
+}
+
+void AudioProcessor::stopWriter()
+{
     if (m_writeThread) {
-        m_writeThread->quit();
         m_writeThread->wait();
         delete m_writeThread;
         m_writeThread = nullptr;
+        if (m_levelMeter) {
+            m_levelMeter->reset();
+        }
     }
-    {
-        QMutexLocker lock(&m_queueMutex);
-        m_audioQueue.clear();
+}
+
+void AudioProcessor::post(const EqualizerEngine::Command& command)
+{
+    m_control->post(command);
+}
+
+void AudioProcessor::closeStreams()
+{
+    if (m_running || !m_capture) {
+        return;
     }
-    m_writeBuffer.clear();
-    
-    // Print final statistics
-    if (m_processingCycles > 0) {
-        qDebug() << "Session statistics:";
-        qDebug() << "  Total bytes processed:" << m_totalBytesProcessed;
-        qDebug() << "  Processing cycles:" << m_processingCycles;
-        qDebug() << "  Average bytes/cycle:" << (m_processingCycles ? (m_totalBytesProcessed / m_processingCycles) : 0);
+    m_capture->stop();
+    m_sink->close();
+    releaseBackends();
+}
+
+void AudioProcessor::releaseBackends()
+{
+    m_capture.reset();
+    m_sink.reset();
+    m_openSinkSpec.clear();
+}
+
+void AudioProcessor::onCapturedFrames(const void* frames, int frameCount)
+{
+    // Capture backend thread: only converts the frames into the queue; the
+    // audio thread equalizes them as it takes them out
+    if (m_realtime && !m_running.load(std::memory_order_relaxed)) {
+        return;  // Suspended: nothing from a live source is kept
     }
-    
-    // Step 1: Terminate parec process (graceful → forced)
-    if (m_parecProcess) {
-        qDebug() << "Terminating parec process...";
-        
-        // Disconnect signals to avoid callbacks during shutdown
-        disconnect(m_parecProcess, nullptr, this, nullptr);
-        
-        // Try graceful termination first
-        m_parecProcess->terminate();
-        if (!m_parecProcess->waitForFinished(SHUTDOWN_TIMEOUT_MS)) {
-            qWarning() << "parec didn't terminate gracefully, forcing kill...";
-            m_parecProcess->kill();
-            m_parecProcess->waitForFinished(); // Wait indefinitely for kill
+    const int channels = m_format.channelCount();
+    const int frameBytes = bytesPerSample(m_captureFormat) * channels;
+    const uint8_t* input = static_cast<const uint8_t*>(frames);
+    for (int offset = 0; offset < frameCount; offset += CAPTURE_BLOCK_FRAMES) {
+        const int count = std::min(CAPTURE_BLOCK_FRAMES, frameCount - offset);
+        const RingBuffer::WriteRegion region = m_queue.prepareWrite(count);
+        const uint8_t* block = input + offset * frameBytes;
+        convertSamples(block, m_captureFormat, region.first, region.firstFrames * channels);
+        if (region.secondFrames > 0) {
+            convertSamples(block + region.firstFrames * frameBytes, m_captureFormat, region.second,
+                           region.secondFrames * channels);
         }
-        
-        qDebug() << "parec process terminated";
-        delete m_parecProcess;
-        m_parecProcess = nullptr;
+        m_queue.commitWrite(region.frames());
     }
-    
-    // Step 3: Free PulseAudio output
-    if (m_paOutput) {
-        qDebug() << "Closing PulseAudio output...";
-        pa_simple_drain(m_paOutput, nullptr);  // Drain remaining audio
-        pa_simple_free(m_paOutput);
-        m_paOutput = nullptr;
-        qDebug() << "PulseAudio output closed";
+}
+
+void AudioProcessor::stop()
+{
+    if (!m_capture) {
+        qDebug() << "Audio processor already stopped";
+        return;
     }
     
-    // Step 4: Clear state
+    qDebug() << "\n=== Stopping Audio Processor ===";
+    
+    // Stop the writer first; closing the queue releases a blocked producer
+    const bool wasRunning = m_running;
     m_running = false;
+    m_queue.close();
+    stopWriter();
+    // After the writer, which reads the capture latency
+    m_capture->stop();  // Returns once no capture callback can run
+    if (wasRunning) {
+        logStatistics();
+    }
+    
+    // A finished input is played to the end; anything else stops at once
+    if (m_inputEnded) {
+        m_sink->drain();
+    }
+    closeStreams();
     
     qDebug() << "✓ Audio processor stopped cleanly\n";
 }
 
-void AudioProcessor::readAudioLoop()
+void AudioProcessor::suspend()
 {
-    qDebug() << "Read thread started";
-    const int bytesPerFrame = m_format.bytesPerFrame();
-    if (bytesPerFrame <= 0) {
-        qCritical() << "Invalid bytes per frame in read loop" << bytesPerFrame;
+    if (!m_running) {
         return;
     }
-    QByteArray chunkBuffer;
-    while (m_running) {
-        if (!m_parecProcess || m_parecProcess->state() != QProcess::Running) {
-            QThread::msleep(10);
-            continue;
-        }
-        QByteArray data = m_parecProcess->readAllStandardOutput();
-        if (!data.isEmpty()) {
-            // Align to frame boundary
-            int alignedSize = (data.size() / bytesPerFrame) * bytesPerFrame;
-            if (alignedSize <= 0) {
-                QThread::msleep(5);
-                continue;
-            }
-            chunkBuffer = data.left(alignedSize);
-            const int frameCount = chunkBuffer.size() / bytesPerFrame;
-            float* buffer = reinterpret_cast<float*>(chunkBuffer.data());
-            m_equalizer->processBuffer(buffer, frameCount, m_format.channelCount());
-            QMutexLocker lock(&m_queueMutex);
-            m_audioQueue.enqueue(chunkBuffer);
-        } else {
-            QThread::msleep(5);
+    qDebug() << "\n=== Suspending Audio Processor ===";
+    m_running = false;
+    m_capture->setPaused(true);
+    stopWriter();
+    logStatistics();
+    qDebug() << "✓ Audio processor suspended, streams kept open\n";
+}
+
+void AudioProcessor::logStatistics() const
+{
+    const double elapsedSeconds = m_runTimer.elapsed() / 1000.0;
+    const int64_t frames = m_totalBytesProcessed / (bytesPerSample(m_playbackFormat) * m_format.channelCount());
+    if (m_processingCycles > 0) {
+        qDebug() << "Session statistics:";
+        qDebug() << "  Total bytes processed:" << m_totalBytesProcessed;
+        qDebug() << "  Processing cycles:" << m_processingCycles;
+        qDebug() << "  Average bytes/cycle:" << (m_processingCycles ? (m_totalBytesProcessed / m_processingCycles) : 0);
+        if (elapsedSeconds > 0.0) {
+            qDebug() << "  Processed" << frames << "frames in" << elapsedSeconds << "s ("
+                     << frames / (elapsedSeconds * m_format.sampleRate()) << "x real time)";
         }
     }
-    qDebug() << "Read thread exiting";
+    const RingBuffer::Stats queueStats = m_queue.stats();
+    if (queueStats.droppedOldest || queueStats.droppedNewest || queueStats.blockedWrites) {
+        qWarning() << "Queue overflow: dropped oldest" << queueStats.droppedOldest
+                   << "frames | dropped newest" << queueStats.droppedNewest
+                   << "frames | blocked writes" << queueStats.blockedWrites;
+    }
+    if (m_jitter.underruns() > 0 || m_trimmedFrames > 0) {
+        qDebug() << "  Underruns:" << m_jitter.underruns()
+                 << "| final jitter buffer:" << m_jitter.targetFrames() * 1000.0 / m_format.sampleRate() << "ms"
+                 << "| trimmed:" << m_trimmedFrames << "frames";
+    }
+    if (m_realtime) {
+        qDebug() << "  Clock drift:" << m_drift.driftPpm() << "ppm";
+    }
 }
 
 void AudioProcessor::writeAudioLoop()
 {
-    qDebug() << "Write thread started";
-    const int bytesPerFrame = m_format.bytesPerFrame();
+    qDebug() << "Audio thread started";
+    const RealtimeThread::Result realtime = RealtimeThread::enter(m_realtimeConfig, m_realtime);
+    m_equalizer->setFlushToZero(realtime.flushToZero);
+    const int channels = m_format.channelCount();
+    const int bytesPerFrame = bytesPerSample(m_playbackFormat) * channels;
+    const unsigned long pollMs = m_jitter.isAdaptive() ? 1 : 5;
+    QElapsedTimer reportTimer;
+    reportTimer.start();
+    // While the queue is dry, playback cannot run out before this (reportTimer
+    // time, in us); -1 when unknown
+    qint64 dryUntilUsec = -1;
+    // Only a device clock needs a cushion against capture jitter
+    bool prebuffering = m_realtime;
+    bool ended = false;
     while (m_running) {
-        // accumulate from queue
-        {
-            QMutexLocker lock(&m_queueMutex);
-            while (!m_audioQueue.isEmpty()) {
-                m_writeBuffer.append(m_audioQueue.dequeue());
+        // Checked before reading so the frames delivered last are not missed
+        const bool draining = m_capture->isFinished();
+        int queued = m_queue.availableFrames();
+        
+        // Fill the jitter buffer at start and again after an underrun
+        if (prebuffering && !draining) {
+            if (queued < m_jitter.targetFrames()) {
+                QThread::msleep(pollMs);
+                continue;
             }
+            prebuffering = false;
+            m_drift.restartAverage();
         }
-        if (m_writeBuffer.size() < PREBUFFER_BYTES) {
-            QThread::msleep(5);
+        
+        // Latency built up by a stall or a capture burst: drop back to the target
+        if (m_realtime && m_jitter.isAdaptive() && queued > m_jitter.trimThresholdFrames()) {
+            const int trimmed = m_queue.discard(queued - m_jitter.targetFrames());
+            m_trimmedFrames += trimmed;
+            queued -= trimmed;
+        }
+        
+        const int frameCount = m_queue.read(m_writeChunk.data(), m_writeChunkFrames);
+        if (frameCount == 0) {
+            if (draining) {
+                if (!m_capture->lastError().isEmpty()) {
+                    setError(QString("%1 capture ended: %2").arg(m_capture->name(), m_capture->lastError()));
+                } else {
+                    m_inputEnded = true;
+                }
+                ended = true;
+                break;
+            }
+            if (!m_realtime) {
+                QThread::msleep(1);
+                continue;
+            }
+            // Queue dry: only an underrun once playback is about to run out
+            // too. The sink is asked once, then again only when what it held
+            // would have played down to the guard
+            const qint64 nowUsec = reportTimer.nsecsElapsed() / 1000;
+            if (dryUntilUsec < 0 || nowUsec >= dryUntilUsec) {
+                const int64_t buffered = m_sink->bufferedUsec();
+                if (buffered <= UNDERRUN_GUARD_USEC) {
+                    // Counted only; AudioController logs them
+                    m_jitter.onUnderrun();
+                    m_underruns.store(m_jitter.underruns(), std::memory_order_relaxed);
+                    prebuffering = true;
+                    dryUntilUsec = -1;
+                    continue;
+                }
+                dryUntilUsec = nowUsec + buffered - UNDERRUN_GUARD_USEC;
+            }
+            QThread::msleep(1);
             continue;
         }
-        if (bytesPerFrame <= 0) {
-            qCritical() << "Invalid bytes per frame" << bytesPerFrame;
-            break;
+        dryUntilUsec = -1;
+        
+        m_equalizer->processBuffer(m_writeChunk.data(), frameCount, channels);
+        if (m_levelMeter) {
+            m_levelMeter->process(m_writeChunk.data(), frameCount, channels);
         }
-        int processSize = (m_writeBuffer.size() / bytesPerFrame) * bytesPerFrame;
-        if (processSize <= 0) {
-            QThread::msleep(5);
-            continue;
+        
+        int outputFrames = frameCount;
+        const void* output = m_resampled.data();
+        if (m_realtime) {
+            // Play the input slightly faster or slower to hold the fill at the target
+            m_resampler.setRatio(m_drift.update(queued, m_jitter.targetFrames(), frameCount));
+            outputFrames = m_resampler.process(m_writeChunk.data(), frameCount, m_resampled.data(),
+                                               m_playbackFormat);
+        } else if (m_playbackFormat == SampleFormat::Float32) {
+            // One clock: no drift, and no resampler delay in rendered output
+            output = m_writeChunk.data();
+        } else {
+            convertSamples(m_writeChunk.data(), m_resampled.data(), m_playbackFormat, frameCount * channels);
         }
-        QByteArray audioData = m_writeBuffer.left(processSize);
-        m_writeBuffer.remove(0, processSize);
-        const int frameCount = audioData.size() / bytesPerFrame;
-        int error;
-        if (pa_simple_write(m_paOutput, audioData.constData(), audioData.size(), &error) < 0) {
-            qWarning() << "PulseAudio write error:" << pa_strerror(error);
+        
+        if (outputFrames > 0 && !m_sink->write(output, outputFrames)) {
+            setError(QString("%1 write error: %2").arg(m_sink->name(), m_sink->lastError()));
+            ended = true;
             break;
         }
-        m_totalBytesProcessed += audioData.size();
+        m_jitter.onFramesPlayed(frameCount);
+        m_totalBytesProcessed += outputFrames * bytesPerFrame;
         m_processingCycles++;
+        
+        if (reportTimer.elapsed() >= LATENCY_REPORT_MS) {
+            measureLatency();
+            reportTimer.restart();
+        }
+    }
+    qDebug() << "Audio thread exiting";
+    RealtimeThread::leave(realtime);
+    if (ended && m_running) {
+        // The owner stops the processor; the stream cannot resume
+        emit streamEnded();
     }
-    qDebug() << "Write thread exiting";
 }
 
-void AudioProcessor::onParecError(QProcess::ProcessError error)
+void AudioProcessor::measureLatency()
 {
-    QString errorMsg;
-    switch (error) {
-        case QProcess::FailedToStart:
-            errorMsg = "Failed to start (parec not found or insufficient permissions)";
-            break;
-        case QProcess::Crashed:
-            errorMsg = "Process crashed";
-            break;
-        case QProcess::Timedout:
-            errorMsg = "Process timed out";
-            break;
-        case QProcess::WriteError:
-            errorMsg = "Write error";
-            break;
-        case QProcess::ReadError:
-            errorMsg = "Read error";
-            break;
-        default:
-            errorMsg = "Unknown error";
-    }
-    
-    qCritical() << "parec process error:" << errorMsg;
-    setError(QString("parec error: %1").arg(errorMsg));
-    
-    // Stop gracefully on error
-    if (m_running) {
-        stop();
-    }
+    const double rate = m_format.sampleRate();
+    const int64_t playback = m_sink->bufferedUsec();
+    const double playbackMs = playback < 0 ? 0.0 : playback / 1000.0;
+    const double captureMs = m_capture->latencyMs();
+    const int resamplerFrames = m_realtime ? DriftResampler::LATENCY_FRAMES : 0;
+    const double queueMs = (m_queue.availableFrames() + resamplerFrames) * 1000.0 / rate;
+    
+    const double total = captureMs + queueMs + latencyMs() + playbackMs;
+    m_measuredLatencyMs.store(total, std::memory_order_relaxed);
+    m_driftPpm.store(m_drift.driftPpm(), std::memory_order_relaxed);
 }
 
-void AudioProcessor::onParecFinished(int exitCode, QProcess::ExitStatus exitStatus)
+double AudioProcessor::latencyMs() const
 {
-    if (!m_running) {
-        // Normal shutdown, ignore
-        return;
-    }
-    
-    QString statusMsg = (exitStatus == QProcess::NormalExit) 
-                        ? QString("exited normally with code %1").arg(exitCode)
-                        : "crashed";
-    
-    qWarning() << "parec process" << statusMsg << "while audio processor was running";
-    
-    // Check stderr for error messages
-    if (m_parecProcess) {
-        QByteArray stderr = m_parecProcess->readAllStandardError();
-        if (!stderr.isEmpty()) {
-            qWarning() << "parec stderr:" << QString::fromUtf8(stderr).trimmed();
-        }
-    }
-    
-    setError(QString("parec %1").arg(statusMsg));
-    stop();
+    return m_equalizer->latencyFrames() * 1000.0 / m_format.sampleRate();
 }
 
 void AudioProcessor::setError(const QString& error)
@@ -414,15 +705,15 @@ void AudioProcessor::setError(const QString& error)
 
 bool AudioProcessor::validateAudioFormat() const
 {
-    if (m_format.sampleRate() != SAMPLE_RATE) {
-        qCritical() << "Invalid sample rate:" << m_format.sampleRate() 
-                    << "(expected" << SAMPLE_RATE << ")";
+    if (!CoefficientTable::isTabulated(m_format.sampleRate())) {
+        qCritical() << "Invalid sample rate:" << m_format.sampleRate()
+                    << "(expected 44100, 48000, 88200, 96000 or 192000)";
         return false;
     }
     
-    if (m_format.channelCount() != CHANNEL_COUNT) {
+    if (m_format.channelCount() < 1 || m_format.channelCount() > EqualizerEngine::MAX_CHANNELS) {
         qCritical() << "Invalid channel count:" << m_format.channelCount()
-                    << "(expected" << CHANNEL_COUNT << ")";
+                    << "(expected 1 to" << EqualizerEngine::MAX_CHANNELS << ")";
         return false;
     }
     
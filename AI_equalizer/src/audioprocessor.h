@@ -2,32 +2,58 @@
 #define AUDIOPROCESSOR_H
 
 #include <QObject>
-#include <QAudioSink>
-#include <QMediaDevices>
 #include <QAudioFormat>
-#include <QProcess>
+#include <QElapsedTimer>
 #include <QThread>
-#include <QQueue>
-#include <QMutex>
-#include <pulse/simple.h>
-#include <pulse/error.h>
 #include "equalizerengine.h"
+#include "audiobackend.h"
+#include "enginecontrol.h"
+#include "ringbuffer.h"
+#include "jitterbuffer.h"
+#include "driftestimator.h"
+#include "driftresampler.h"
+#include "realtimethread.h"
+#include "levelmeter.h"
+#include <atomic>
+#include <memory>
+#include <vector>
 
 /**
  * @class AudioProcessor
- * @brief Real-time audio capture and processing engine using PulseAudio's parec
+ * @brief Real-time audio capture and processing engine
  * 
- * This class implements a hybrid approach for audio capture in WSL/RDP environments:
- * - Capture: Uses external 'parec' process (direct PulseAudio API access)
- * - Processing: Routes audio through EqualizerEngine (10-band biquad filters)
- * - Output: Uses Qt's QAudioSink for playback
+ * Capture and playback go through AudioBackend interfaces, PulseAudio by default:
+ * - Capture: Native PulseAudio record stream (PulseCapture), with the external
+ *   'parec' process as a fallback
+ * - Processing: Routes audio through EqualizerEngine (biquad cascade, see EqLayout)
+ * - Output: PulseAudio simple API playback stream (PulseSink)
+ * 
+ * One audio thread does all the processing: it equalizes what the capture
+ * queued, compensates clock drift and writes to the sink. EQ changes are
+ * designed on the engine's control thread (see post()) and only picked up
+ * by the audio thread. Capture callbacks only convert frames into the
+ * queue, and no Qt event loop is involved while streaming.
+ * 
+ * File and generator/null backends run the same pipeline without a sound
+ * server. When either side is not paced by a device clock, the queue
+ * applies backpressure instead of dropping audio and the drift resampler
+ * is bypassed, so the output is deterministic and the run ends with the
+ * input (see streamEnded()).
  * 
  * Architecture Decision:
- * Qt's QAudioSource cannot access PulseAudio monitor sources in WSL/RDP environments.
- * The parec utility has native PulseAudio API access and works reliably.
+ * Qt's QAudioSource cannot access PulseAudio monitor sources in WSL/RDP environments,
+ * so the monitor is recorded through the PulseAudio API directly. Native capture
+ * queues each fragment from the stream callback as it arrives; the parec path
+ * reads a pipe from a polling thread and is kept for setups where the native
+ * stream cannot be opened.
+ * 
+ * Both streams are opened at the devices' own sample rate and format (see
+ * AudioCaptureBackend::preferredFormat()), so the server passes audio through instead of resampling
+ * or converting it; integer formats are converted to float on the way into
+ * the queue and back in the drift resampler's output loop.
  * 
  * Audio Flow:
- * Chrome → Equalizer_Input (sink) → .monitor (source) → parec → EQ → RDPSink → speakers
+ * Chrome → Equalizer_Input (sink) → .monitor (source) → capture → EQ → RDPSink → speakers
  */
 class AudioProcessor : public QObject
 {
@@ -35,15 +61,14 @@ class AudioProcessor : public QObject
 
 public:
     // Audio format constants
-    static constexpr int SAMPLE_RATE = 44100;      // 44.1kHz CD-quality audio
-    static constexpr int CHANNEL_COUNT = 2;         // Stereo
+    static constexpr int DEFAULT_SAMPLE_RATE = 44100; // When the devices report no usable rate
+    static constexpr int CHANNEL_COUNT = 2;         // Default: stereo (see setChannelCount)
     static constexpr int PROCESS_INTERVAL_MS = 20;  // Unused in threaded mode (kept for compatibility)
-    static constexpr int STARTUP_TIMEOUT_MS = 2000; // Max wait for parec to start
-    static constexpr int SHUTDOWN_TIMEOUT_MS = 1000;// Max wait for graceful termination
-    
-    // PulseAudio device names
-    static constexpr const char* MONITOR_SOURCE = "Equalizer_Input.monitor";
-    static constexpr const char* OUTPUT_SINK_KEYWORD = "Equalizer_Output";
+    static constexpr int CAPTURE_FRAGMENT_MS = 10;  // Native capture fragment length
+    static constexpr int MIN_LATENCY_MS = 10;       // Lowest low-latency target
+    static constexpr int MAX_LATENCY_MS = 500;      // Jitter buffer growth limit
+    static constexpr int STABLE_PLAYBACK_MS = 200;  // Playback buffer in stable mode
+    static constexpr int LATENCY_REPORT_MS = 500;   // Refresh interval of the measured latency
     
     explicit AudioProcessor(EqualizerEngine* equalizer, QObject *parent = nullptr);
     ~AudioProcessor() override;
@@ -53,10 +78,14 @@ public:
      * @return true if started successfully, false on error
      * 
      * Initializes:
-     * 1. Finds RDPSink output device
-     * 2. Starts QAudioSink for playback
-     * 3. Launches parec process to capture from Equalizer_Input.monitor
-     * 4. Starts timer for periodic audio processing
+     * 1. Creates the capture and sink backends and negotiates the format
+     * 2. Opens the sink for playback
+     * 3. Starts capture (for PulseAudio: native stream, parec as fallback)
+     * 4. Starts the writer thread
+     * 
+     * After suspend() this only restarts the writer on the open streams (a
+     * changed sink backend is reopened on its own); it falls back to the
+     * full sequence when the streams no longer fit.
      */
     bool start();
     
@@ -64,53 +93,213 @@ public:
      * @brief Stop audio processing and release all resources
      * 
      * Ensures clean shutdown:
-     * 1. Stops processing timer
-     * 2. Terminates parec process (graceful → forced)
-     * 3. Stops audio sink
-     * 4. Cleans up all allocated resources
+     * 1. Stops the writer thread
+     * 2. Stops capture (closes the stream or terminates parec)
+     * 3. Closes the sink; audio still buffered is only played out when the
+     *    input ended on its own
+     * 4. Releases both backends
      */
     void stop();
     
+    /**
+     * @brief Pause processing but keep the streams and EQ state (warm restart)
+     * 
+     * Stops the writer and pauses capture; the next start() resumes in
+     * milliseconds. Changing a stream setting in between closes the streams,
+     * except for setSinkBackend(), so that start() is a full one.
+     */
+    void suspend();
+    bool isSuspended() const { return !m_running && m_capture; }
+    
+    /**
+     * @brief Set the interleaved channel count (1 to EqualizerEngine::MAX_CHANNELS)
+     * 
+     * Must be called before start(). Capture and playback use PulseAudio's
+     * default channel map for the count, e.g. 6 = 5.1 and 8 = 7.1.
+     */
+    bool setChannelCount(int channels);
+    int channelCount() const { return m_format.channelCount(); }
+    
+    /**
+     * @brief Force a processing rate, or 0 (default) to follow the devices (before start())
+     * 
+     * Following the devices picks the sink's rate (else the source's) when it
+     * is one of CoefficientTable::SUPPORTED_RATES, else DEFAULT_SAMPLE_RATE.
+     * sampleRate() reports the rate in use once started.
+     */
+    bool setSampleRate(int rate);
+    int sampleRate() const { return m_format.sampleRate(); }
+    // Stream formats negotiated at start()
+    SampleFormat captureFormat() const { return m_captureFormat; }
+    SampleFormat playbackFormat() const { return m_playbackFormat; }
+    
+    /**
+     * @brief Select the capture and sink backends by spec (before start())
+     * 
+     * See AudioBackend for the spec strings; both default to "pulse". While
+     * suspended, a new sink is swapped in by the next start(). Native
+     * PulseAudio capture falls back to parec if the record stream cannot be
+     * opened; captureBackend() reports the backend actually in use while running.
+     */
+    bool setCaptureBackend(const QString& spec);
+    bool setSinkBackend(const QString& spec);
+    QString captureBackend() const { return m_capture ? m_capture->name() : QString(); }
+    // Native capture fragment length (before start())
+    bool setCaptureFragmentMs(int ms);
+    
+    /**
+     * @brief Opt-in real-time hardening of the audio thread (before start())
+     * 
+     * See RealtimeThread. SCHED_FIFO is only requested when both backends
+     * are paced by a device clock; an unpaced run never blocks and would
+     * starve the rest of the system.
+     */
+    void setRealtimeConfig(const RealtimeConfig& config) { m_realtimeConfig = config; }
+    
+    // Output levels, measured on the audio thread after the EQ (before
+    // start(); the meter must outlive the processor)
+    void setLevelMeter(LevelMeter* meter) { m_levelMeter = meter; }
+    
+    /**
+     * @brief Size and overflow policy of the capture → playback queue (before start())
+     * 
+     * The queue is preallocated at start() and never grows. When playback
+     * stalls and it fills, DropOldest (default) discards the oldest audio,
+     * DropNewest the incoming audio, and Block stalls the capture side.
+     */
+    bool setQueueCapacityMs(int ms);
+    bool setOverflowPolicy(RingBuffer::OverflowPolicy policy);
+    RingBuffer::Stats queueStats() const { return m_queue.stats(); }
+    
+    /**
+     * @brief End-to-end latency target in ms, or 0 for stable mode (before start())
+     * 
+     * Stable mode prebuffers PREBUFFER_MS (1s) with a 200ms playback
+     * buffer. A target of MIN_LATENCY_MS or more is split between the
+     * playback buffer and an adaptive jitter buffer in the queue, which grows
+     * on underruns (up to MAX_LATENCY_MS) and shrinks again once stable.
+     */
+    bool setLatencyTargetMs(int ms);
+    int latencyTargetMs() const { return m_latencyTargetMs; }
+    
+    // Capture + queue + EQ + playback, refreshed every LATENCY_REPORT_MS while running
+    double measuredLatencyMs() const { return m_measuredLatencyMs.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Estimated capture/playback clock drift in ppm, refreshed with the latency
+     * 
+     * The writer resamples by this much (DriftResampler) so the queue stays at
+     * the jitter buffer target instead of slowly draining or growing.
+     */
+    double driftPpm() const { return m_driftPpm.load(std::memory_order_relaxed); }
+    // Playback underruns since start(), counted as they happen
+    int underruns() const { return m_underruns.load(std::memory_order_relaxed); }
+    
+    /**
+     * @brief Hands an EQ change to the engine's control thread (any thread)
+     * 
+     * Folded into whatever is still pending and applied as one engine
+     * update (see EngineControl); never dropped, and never waits for the
+     * redesign. Changes posted before start() are in effect for the first
+     * block.
+     */
+    void post(const EqualizerEngine::Command& command);
+    
     bool isRunning() const { return m_running; }
     QString getLastError() const { return m_lastError; }
     
-private slots:
-    void onParecError(QProcess::ProcessError error);
-    void onParecFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    /**
+     * @brief Latency added by the EQ itself (0 for the biquad cascade)
+     * 
+     * Excludes capture/playback buffering; linear-phase mode adds the FIR
+     * group delay plus one convolution partition.
+     */
+    double latencyMs() const;
+    
+signals:
+    // Emitted from the writer thread when it stops on its own: a finite
+    // capture was played out, the capture device went away or the sink
+    // failed (see getLastError()). stop() still has to be called.
+    void streamEnded();
     
 private:
     // Core components
     EqualizerEngine* m_equalizer;
+    std::unique_ptr<EngineControl> m_control;  // m_equalizer's control thread
     QAudioFormat m_format;
-    QThread* m_readThread{nullptr};    // Thread to read from parec
-    QThread* m_writeThread{nullptr};   // Thread to process+write
+    QThread* m_writeThread{nullptr};   // The audio thread: EQ, drift, playback
     
-    // Audio capture (parec process)
-    QProcess* m_parecProcess;
+    // Backends, created by start() from their specs
+    QString m_captureSpec{AudioBackend::DEFAULT_SPEC};
+    QString m_sinkSpec{AudioBackend::DEFAULT_SPEC};
+    std::unique_ptr<AudioCaptureBackend> m_capture;
+    std::unique_ptr<AudioSinkBackend> m_sink;
+    bool m_realtime{true};  // Both sides paced by a device clock
+    QString m_openSinkSpec;   // Spec of m_sink
+    int m_playbackBufferMs{0};
+    bool m_inputEnded{false}; // The writer played out a finished capture
     
-    // Audio output (PulseAudio simple API)
-    pa_simple* m_paOutput;
+    // Audio capture
+    int m_captureFragmentMs{CAPTURE_FRAGMENT_MS};
+    SampleFormat m_captureFormat{SampleFormat::Float32};
+    
+    // Stream formats: rate requested via setSampleRate (0 = devices' own)
+    int m_requestedSampleRate{0};
+    SampleFormat m_playbackFormat{SampleFormat::Float32};
     
     // Processing control
-    bool m_running;
+    std::atomic_bool m_running{false};
+    RealtimeConfig m_realtimeConfig;
+    LevelMeter* m_levelMeter{nullptr};
     QString m_lastError;
     
     // Statistics (for debugging)
     qint64 m_totalBytesProcessed;
     int m_processingCycles;
+    QElapsedTimer m_runTimer;
+    
+    // Lock-free queue between capture and writer
+    RingBuffer m_queue;
+    std::vector<float> m_writeChunk; // writer thread's preallocated output block
+    int m_queueCapacityMs{QUEUE_CAPACITY_MS};
+    RingBuffer::OverflowPolicy m_overflowPolicy{RingBuffer::OverflowPolicy::DropOldest};
+    static constexpr int PREBUFFER_MS = 1000;
+    static constexpr int QUEUE_CAPACITY_MS = 2 * PREBUFFER_MS;
+    static constexpr int WRITE_CHUNK_FRAMES = 1024;   // Frames per sink write (max)
+    static constexpr int CAPTURE_BLOCK_FRAMES = 1024; // Frames reserved in the queue per conversion
+    static constexpr int64_t UNDERRUN_GUARD_USEC = 2000; // Playback buffer left when the queue runs dry
+    
+    // Latency control (writer thread owns m_jitter while running)
+    int m_latencyTargetMs{0};
+    JitterBuffer m_jitter;
+    int m_writeChunkFrames{WRITE_CHUNK_FRAMES};
+    std::atomic<double> m_measuredLatencyMs{0.0};
+    std::atomic<int> m_underruns{0};
+    qint64 m_trimmedFrames{0};
     
-    // Thread-safe queue between reader and writer
-    QQueue<QByteArray> m_audioQueue;
-    mutable QMutex m_queueMutex;
-    QByteArray m_writeBuffer; // accumulation buffer in writer thread
-    static constexpr int MIN_BUFFER_SIZE = 8820;  // ~50ms at 44.1kHz stereo (1102.5 frames × 8 bytes)
-    static constexpr int PREBUFFER_BYTES = SAMPLE_RATE * CHANNEL_COUNT * sizeof(float); // ~1s prebuffer
+    // Clock-drift compensation in the write path (writer thread)
+    DriftEstimator m_drift;
+    DriftResampler m_resampler;
+    std::vector<uint8_t> m_resampled; // preallocated resampler output, in the playback format
+    std::atomic<double> m_driftPpm{0.0};
     
-    void setupAudioFormat();
+    void setupAudioFormat(int channels, int sampleRate);
+    bool negotiateFormat();
+    AudioStreamFormat streamFormat(SampleFormat format) const;
+    int framesForMs(int ms) const { return static_cast<int>(static_cast<qint64>(ms) * m_format.sampleRate() / 1000); }
     void setError(const QString& error);
     bool validateAudioFormat() const;
-    void readAudioLoop();
+    bool startCapture();
+    bool resume();
+    bool reopenSink();
+    void startWriter();
+    void stopWriter();
+    void logStatistics() const;
+    void closeStreams();
+    void releaseBackends();
+    void onCapturedFrames(const void* frames, int frameCount);
     void writeAudioLoop();
+    void measureLatency();
 };
 
 #endif // AUDIOPROCESSOR_H
@@ -0,0 +1,515 @@
+#include "biquadkernel.h"
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BIQUAD_USE_SSE2 1
+#endif
+
+// AVX kernels are built with a per-function target and picked at runtime, so
+// the binary still runs on CPUs without AVX
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define BIQUAD_HAVE_AVX 1
+#define BIQUAD_AVX_TARGET __attribute__((target("avx")))
+#define BIQUAD_AVX2_TARGET __attribute__((target("avx2,fma")))
+#endif
+
+namespace {
+// Output range of the cascade, matches the previous per-filter clamp
+constexpr double OUTPUT_LIMIT = 10.0;
+// State magnitudes below this are flushed to keep the recursion out of denormals
+constexpr double DENORMAL_THRESHOLD = 1e-15;
+
+// Kernels run a group of up to MAX_FUSED sections per pass over the block.
+// A single recursion is latency bound; chaining a few sections in the same
+// loop lets the next section of frame n overlap with the first of frame n+1.
+// Each kernel covers a strip of 1, 2 or 4 adjacent channel lanes starting at
+// `lane`, in a block whose frames are `stride` doubles apart.
+template <int N>
+void monoKernel(BiquadBank::Section* const* sections, double* block, int frameCount, int stride, int lane)
+{
+    double b0[N], b1[N], b2[N], a1[N], a2[N], s1[N], s2[N];
+    for (int k = 0; k < N; ++k) {
+        const BiquadBank::Section& s = *sections[k];
+        b0[k] = s.b0[lane]; b1[k] = s.b1[lane]; b2[k] = s.b2[lane]; a1[k] = s.a1[lane]; a2[k] = s.a2[lane];
+        s1[k] = s.s1[lane]; s2[k] = s.s2[lane];
+    }
+    for (int frame = 0; frame < frameCount; ++frame) {
+        double x = block[frame * stride + lane];
+        for (int k = 0; k < N; ++k) {
+            const double y = b0[k] * x + s1[k];
+            s1[k] = b1[k] * x - a1[k] * y + s2[k];
+            s2[k] = b2[k] * x - a2[k] * y;
+            x = y;
+        }
+        block[frame * stride + lane] = x;
+    }
+    for (int k = 0; k < N; ++k) {
+        sections[k]->s1[lane] = s1[k];
+        sections[k]->s2[lane] = s2[k];
+    }
+}
+
+#ifdef BIQUAD_USE_SSE2
+template <int N>
+void pairKernelSse2(BiquadBank::Section* const* sections, double* block, int frameCount, int stride, int lane)
+{
+    __m128d b0[N], b1[N], b2[N], a1[N], a2[N], s1[N], s2[N];
+    for (int k = 0; k < N; ++k) {
+        const BiquadBank::Section& s = *sections[k];
+        b0[k] = _mm_load_pd(s.b0 + lane); b1[k] = _mm_load_pd(s.b1 + lane); b2[k] = _mm_load_pd(s.b2 + lane);
+        a1[k] = _mm_load_pd(s.a1 + lane); a2[k] = _mm_load_pd(s.a2 + lane);
+        s1[k] = _mm_load_pd(s.s1 + lane); s2[k] = _mm_load_pd(s.s2 + lane);
+    }
+    for (int frame = 0; frame < frameCount; ++frame) {
+        // Transposed direct form II, two channels in parallel lanes
+        double* io = block + frame * stride + lane;
+        __m128d x = _mm_load_pd(io);
+        for (int k = 0; k < N; ++k) {
+            const __m128d y = _mm_add_pd(_mm_mul_pd(b0[k], x), s1[k]);
+            s1[k] = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(b1[k], x), _mm_mul_pd(a1[k], y)), s2[k]);
+            s2[k] = _mm_sub_pd(_mm_mul_pd(b2[k], x), _mm_mul_pd(a2[k], y));
+            x = y;
+        }
+        _mm_store_pd(io, x);
+    }
+    for (int k = 0; k < N; ++k) {
+        _mm_store_pd(sections[k]->s1 + lane, s1[k]);
+        _mm_store_pd(sections[k]->s2 + lane, s2[k]);
+    }
+}
+#else
+template <int N>
+void pairKernel(BiquadBank::Section* const* sections, double* block, int frameCount, int stride, int lane)
+{
+    monoKernel<N>(sections, block, frameCount, stride, lane);
+    monoKernel<N>(sections, block, frameCount, stride, lane + 1);
+}
+#endif
+
+#ifdef BIQUAD_HAVE_AVX
+// Same recursion on four channel lanes. Compiled for AVX regardless of the
+// build flags and only called after a CPU check. Frames of a padded block are
+// not always 32-byte aligned, so block access is unaligned.
+template <int N>
+BIQUAD_AVX_TARGET void quadKernelAvx(BiquadBank::Section* const* sections, double* block, int frameCount,
+                                     int stride, int lane)
+{
+    __m256d b0[N], b1[N], b2[N], a1[N], a2[N], s1[N], s2[N];
+    for (int k = 0; k < N; ++k) {
+        const BiquadBank::Section& s = *sections[k];
+        b0[k] = _mm256_load_pd(s.b0 + lane); b1[k] = _mm256_load_pd(s.b1 + lane); b2[k] = _mm256_load_pd(s.b2 + lane);
+        a1[k] = _mm256_load_pd(s.a1 + lane); a2[k] = _mm256_load_pd(s.a2 + lane);
+        s1[k] = _mm256_load_pd(s.s1 + lane); s2[k] = _mm256_load_pd(s.s2 + lane);
+    }
+    for (int frame = 0; frame < frameCount; ++frame) {
+        double* io = block + frame * stride + lane;
+        __m256d x = _mm256_loadu_pd(io);
+        for (int k = 0; k < N; ++k) {
+            const __m256d y = _mm256_add_pd(_mm256_mul_pd(b0[k], x), s1[k]);
+            s1[k] = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(b1[k], x), _mm256_mul_pd(a1[k], y)), s2[k]);
+            s2[k] = _mm256_sub_pd(_mm256_mul_pd(b2[k], x), _mm256_mul_pd(a2[k], y));
+            x = y;
+        }
+        _mm256_storeu_pd(io, x);
+    }
+    for (int k = 0; k < N; ++k) {
+        _mm256_store_pd(sections[k]->s1 + lane, s1[k]);
+        _mm256_store_pd(sections[k]->s2 + lane, s2[k]);
+    }
+}
+#endif
+
+#ifdef BIQUAD_HAVE_AVX
+alignas(16) const double PAIR_ONE[2] = {1.0, 1.0};
+alignas(16) const double PAIR_ZERO[2] = {0.0, 0.0};
+
+// Two sections' values for both channels, interleaved by section:
+// {first L, second L, first R, second R}
+BIQUAD_AVX2_TARGET inline __m256d loadSectionPair(const double* first, const double* second)
+{
+    const __m256d halves = _mm256_insertf128_pd(_mm256_castpd128_pd256(_mm_load_pd(first)),
+                                                _mm_load_pd(second), 1);
+    return _mm256_permute4x64_pd(halves, _MM_SHUFFLE(3, 1, 2, 0));
+}
+
+// One section's {L, R} from a pair: the second one's for `second`
+BIQUAD_AVX2_TARGET inline __m128d pairHalf(__m256d pair, bool second)
+{
+    const __m256d lanes = second ? _mm256_permute4x64_pd(pair, _MM_SHUFFLE(3, 1, 3, 1))
+                                 : _mm256_permute4x64_pd(pair, _MM_SHUFFLE(2, 0, 2, 0));
+    return _mm256_castpd256_pd128(lanes);
+}
+
+// One step of the wavefront below: section k takes its next frame from
+// section k - 1's previous output, an in-lane shuffle of the two registers
+// holding them. While the pipeline fills or drains (Edge), only sections
+// that have a frame in this block update their state.
+template <int V, bool Edge>
+BIQUAD_AVX2_TARGET __attribute__((always_inline)) inline void
+wavefrontStep(const __m256d* b0, const __m256d* b1, const __m256d* b2, const __m256d* a1, const __m256d* a2,
+              __m256d* s1, __m256d* s2, __m256d* y, const __m256d* index, const double* in, int t, int frameCount)
+{
+    // Fully unrolled, so the pipeline stays in registers
+    __m256d x[V];
+    x[0] = _mm256_shuffle_pd(_mm256_broadcast_pd(reinterpret_cast<const __m128d*>(in)), y[0], 0x4);
+#pragma GCC unroll 16
+    for (int v = 1; v < V; ++v) {
+        x[v] = _mm256_shuffle_pd(y[v - 1], y[v], 0x5);
+    }
+#pragma GCC unroll 16
+    for (int v = 0; v < V; ++v) {
+        y[v] = _mm256_fmadd_pd(b0[v], x[v], s1[v]);
+        const __m256d n1 = _mm256_fnmadd_pd(a1[v], y[v], _mm256_fmadd_pd(b1[v], x[v], s2[v]));
+        const __m256d n2 = _mm256_fnmadd_pd(a2[v], y[v], _mm256_mul_pd(b2[v], x[v]));
+        if constexpr (Edge) {
+            const __m256d active = _mm256_and_pd(_mm256_cmp_pd(index[v], _mm256_set1_pd(t), _CMP_LE_OQ),
+                                                 _mm256_cmp_pd(index[v], _mm256_set1_pd(t - frameCount), _CMP_GT_OQ));
+            s1[v] = _mm256_blendv_pd(s1[v], n1, active);
+            s2[v] = _mm256_blendv_pd(s2[v], n2, active);
+        } else {
+            s1[v] = n1;
+            s2[v] = n2;
+        }
+    }
+}
+
+// Stereo cascade as a wavefront. Two lanes leave a stereo cascade latency
+// bound, one section after the other, so the sections advance together
+// instead: each register holds two consecutive sections for both channels,
+// section k works on frame t - k at step t, and every output moves one
+// section along per step. V registers cover up to 2V sections; an odd count
+// is padded with an identity section. Compiled for AVX2/FMA and only called
+// after a CPU check; the block must be unpadded stereo (stride 2, lane 0).
+template <int V>
+BIQUAD_AVX2_TARGET void stereoWavefrontAvx2(BiquadBank::Section* const* sections, int sectionCount,
+                                            double* block, int frameCount, int, int)
+{
+    __m256d b0[V], b1[V], b2[V], a1[V], a2[V], s1[V], s2[V], y[V], index[V];
+    for (int v = 0; v < V; ++v) {
+        const BiquadBank::Section& first = *sections[2 * v];
+        const BiquadBank::Section* second = 2 * v + 1 < sectionCount ? sections[2 * v + 1] : nullptr;
+        b0[v] = loadSectionPair(first.b0, second ? second->b0 : PAIR_ONE);
+        b1[v] = loadSectionPair(first.b1, second ? second->b1 : PAIR_ZERO);
+        b2[v] = loadSectionPair(first.b2, second ? second->b2 : PAIR_ZERO);
+        a1[v] = loadSectionPair(first.a1, second ? second->a1 : PAIR_ZERO);
+        a2[v] = loadSectionPair(first.a2, second ? second->a2 : PAIR_ZERO);
+        s1[v] = loadSectionPair(first.s1, second ? second->s1 : PAIR_ZERO);
+        s2[v] = loadSectionPair(first.s2, second ? second->s2 : PAIR_ZERO);
+        y[v] = _mm256_setzero_pd();
+        index[v] = _mm256_set_pd(2 * v + 1, 2 * v, 2 * v + 1, 2 * v);
+    }
+
+    // Frame t enters at step t and leaves the last section at step t + lag,
+    // in the second half of the last pair for an even section count
+    const int lag = sectionCount - 1;
+    const bool lastSecond = (sectionCount & 1) == 0;
+    const int filled = std::min(lag, frameCount);
+    int t = 0;
+    for (; t < filled; ++t) {
+        wavefrontStep<V, true>(b0, b1, b2, a1, a2, s1, s2, y, index, block + 2 * t, t, frameCount);
+    }
+    for (; t < frameCount; ++t) {
+        wavefrontStep<V, false>(b0, b1, b2, a1, a2, s1, s2, y, index, block + 2 * t, t, frameCount);
+        _mm_store_pd(block + 2 * (t - lag), pairHalf(y[V - 1], lastSecond));
+    }
+    for (; t < frameCount + lag; ++t) {
+        // Draining: nothing enters any more
+        wavefrontStep<V, true>(b0, b1, b2, a1, a2, s1, s2, y, index, PAIR_ZERO, t, frameCount);
+        if (t >= lag) {
+            _mm_store_pd(block + 2 * (t - lag), pairHalf(y[V - 1], lastSecond));
+        }
+    }
+
+    for (int k = 0; k < sectionCount; ++k) {
+        _mm_store_pd(sections[k]->s1, pairHalf(s1[k / 2], k & 1));
+        _mm_store_pd(sections[k]->s2, pairHalf(s2[k / 2], k & 1));
+    }
+}
+
+// Indexed by register count - 1
+const BiquadBank::CascadeRunner STEREO_WAVEFRONT[BiquadBank::MAX_BANDS / 2] = {
+    stereoWavefrontAvx2<1>, stereoWavefrontAvx2<2>, stereoWavefrontAvx2<3>, stereoWavefrontAvx2<4>,
+    stereoWavefrontAvx2<5>, stereoWavefrontAvx2<6>, stereoWavefrontAvx2<7>, stereoWavefrontAvx2<8>,
+    stereoWavefrontAvx2<9>, stereoWavefrontAvx2<10>, stereoWavefrontAvx2<11>, stereoWavefrontAvx2<12>,
+    stereoWavefrontAvx2<13>, stereoWavefrontAvx2<14>, stereoWavefrontAvx2<15>, stereoWavefrontAvx2<16>
+};
+#endif
+
+// Kernel sets: compile-time access through run<N>, runtime through table
+struct MonoKernels {
+    static constexpr int LANES = 1;
+    template <int N>
+    static void run(BiquadBank::Section* const* sections, double* block, int frameCount, int stride, int lane)
+    {
+        monoKernel<N>(sections, block, frameCount, stride, lane);
+    }
+    static const BiquadBank::BlockKernel table[BiquadBank::MAX_FUSED];
+};
+
+struct PairKernels {
+    static constexpr int LANES = 2;
+    template <int N>
+    static void run(BiquadBank::Section* const* sections, double* block, int frameCount, int stride, int lane)
+    {
+#ifdef BIQUAD_USE_SSE2
+        pairKernelSse2<N>(sections, block, frameCount, stride, lane);
+#else
+        pairKernel<N>(sections, block, frameCount, stride, lane);
+#endif
+    }
+    static const BiquadBank::BlockKernel table[BiquadBank::MAX_FUSED];
+};
+
+#ifdef BIQUAD_HAVE_AVX
+struct QuadKernels {
+    static constexpr int LANES = 4;
+    template <int N>
+    static void run(BiquadBank::Section* const* sections, double* block, int frameCount, int stride, int lane)
+    {
+        quadKernelAvx<N>(sections, block, frameCount, stride, lane);
+    }
+    static const BiquadBank::BlockKernel table[BiquadBank::MAX_FUSED];
+};
+#endif
+
+#define BIQUAD_KERNEL_TABLE(Kernels) \
+    const BiquadBank::BlockKernel Kernels::table[BiquadBank::MAX_FUSED] = { \
+        Kernels::run<1>, Kernels::run<2>, Kernels::run<3>, Kernels::run<4>, \
+        Kernels::run<5>, Kernels::run<6>, Kernels::run<7>, Kernels::run<8> \
+    };
+
+BIQUAD_KERNEL_TABLE(MonoKernels)
+BIQUAD_KERNEL_TABLE(PairKernels)
+#ifdef BIQUAD_HAVE_AVX
+BIQUAD_KERNEL_TABLE(QuadKernels)
+#endif
+
+#undef BIQUAD_KERNEL_TABLE
+
+// Groups are balanced so that no pass ends up with a lone section
+template <class Kernels>
+void runCascade(BiquadBank::Section* const* sections, int sectionCount, double* block, int frameCount,
+                int stride, int lane)
+{
+    const int groups = (sectionCount + BiquadBank::MAX_FUSED - 1) / BiquadBank::MAX_FUSED;
+    for (int g = 0, first = 0; g < groups; ++g) {
+        const int count = (sectionCount - first) / (groups - g);
+        Kernels::table[count - 1](sections + first, block, frameCount, stride, lane);
+        first += count;
+    }
+}
+
+// Same schedule with the section count known at compile time
+template <class Kernels, int Remaining, int Groups>
+void runGroups(BiquadBank::Section* const* sections, double* block, int frameCount, int stride, int lane)
+{
+    if constexpr (Groups > 0) {
+        constexpr int count = Remaining / Groups;
+        Kernels::template run<count>(sections, block, frameCount, stride, lane);
+        runGroups<Kernels, Remaining - count, Groups - 1>(sections + count, block, frameCount, stride, lane);
+    }
+}
+
+template <class Kernels, int Sections>
+void runFixedCascade(BiquadBank::Section* const* sections, int, double* block, int frameCount,
+                     int stride, int lane)
+{
+    constexpr int groups = (Sections + BiquadBank::MAX_FUSED - 1) / BiquadBank::MAX_FUSED;
+    runGroups<Kernels, Sections, groups>(sections, block, frameCount, stride, lane);
+}
+
+// By section count alone: flat bands are not in the cascade, so a graphic
+// layout with some of them runs the table
+template <class Kernels>
+BiquadBank::CascadeRunner unrolledRunnerFor(int sectionCount)
+{
+    switch (sectionCount) {
+    case 10:
+        return runFixedCascade<Kernels, 10>;
+    case 31:
+        return runFixedCascade<Kernels, 31>;
+    default:
+        return runCascade<Kernels>;
+    }
+}
+
+bool cpuHasAvx()
+{
+#ifdef BIQUAD_HAVE_AVX
+    static const bool hasAvx = __builtin_cpu_supports("avx");
+    return hasAvx;
+#else
+    return false;
+#endif
+}
+
+bool cpuHasAvx2Fma()
+{
+#ifdef BIQUAD_HAVE_AVX
+    static const bool hasAvx2Fma = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return hasAvx2Fma;
+#else
+    return false;
+#endif
+}
+}
+
+BiquadBank::BiquadBank()
+{
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        setCoefficients(band, BiquadCoefficients());
+    }
+    reset();
+}
+
+void BiquadBank::setCoefficients(int band, const BiquadCoefficients& c)
+{
+    if (band < 0 || band >= MAX_BANDS) {
+        return;
+    }
+    Section& s = m_sections[band];
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+        s.b0[ch] = c.b0;
+        s.b1[ch] = c.b1;
+        s.b2[ch] = c.b2;
+        s.a1[ch] = c.a1;
+        s.a2[ch] = c.a2;
+    }
+}
+
+void BiquadBank::reset()
+{
+    for (Section& s : m_sections) {
+        for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+            s.s1[ch] = 0.0;
+            s.s2[ch] = 0.0;
+        }
+    }
+}
+
+void BiquadBank::resetBand(int band)
+{
+    if (band < 0 || band >= MAX_BANDS) {
+        return;
+    }
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+        m_sections[band].s1[ch] = 0.0;
+        m_sections[band].s2[ch] = 0.0;
+    }
+}
+
+bool BiquadBank::isSettled(int band, int channels, double threshold) const
+{
+    const Section& s = m_sections[band];
+    for (int ch = 0; ch < channels; ++ch) {
+        if (std::abs(s.s1[ch]) >= threshold || std::abs(s.s2[ch]) >= threshold) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BiquadBank::planStrips(int channels, int sectionCount)
+{
+    // Mono runs unpadded; otherwise the block stride is padded to an even
+    // lane count. Stereo runs as one wavefront where AVX2 is available;
+    // more channels are covered by 4-lane strips where AVX is available,
+    // with 2-lane strips for the rest
+    m_stripCount = 0;
+    if (channels == 1) {
+        m_stride = 1;
+        m_strips[m_stripCount++] = Strip{::unrolledRunnerFor<MonoKernels>(sectionCount), 0};
+        return;
+    }
+    m_stride = (channels + 1) & ~1;
+    int lane = 0;
+#ifdef BIQUAD_HAVE_AVX
+    if (cpuHasAvx2Fma() && channels == 2) {
+        m_strips[m_stripCount++] = Strip{STEREO_WAVEFRONT[(sectionCount + 1) / 2 - 1], 0};
+        return;
+    }
+    if (cpuHasAvx() && channels > 2) {
+        for (; lane + 4 <= m_stride; lane += 4) {
+            m_strips[m_stripCount++] = Strip{::unrolledRunnerFor<QuadKernels>(sectionCount), lane};
+        }
+    }
+#endif
+    for (; lane < m_stride; lane += 2) {
+        m_strips[m_stripCount++] = Strip{::unrolledRunnerFor<PairKernels>(sectionCount), lane};
+    }
+}
+
+void BiquadBank::process(const int* bands, int bandCount, float* buffer, int frameCount, int channels)
+{
+    if (channels <= 0 || channels > MAX_CHANNELS || bandCount <= 0) {
+        return;
+    }
+    if (channels != m_plannedChannels || bandCount != m_plannedSections) {
+        planStrips(channels, bandCount);
+        m_plannedChannels = channels;
+        m_plannedSections = bandCount;
+    }
+
+    Section* sections[MAX_BANDS];
+    for (int i = 0; i < bandCount; ++i) {
+        sections[i] = &m_sections[bands[i]];
+    }
+
+    for (int offset = 0; offset < frameCount; offset += BLOCK_FRAMES) {
+        const int frames = std::min(BLOCK_FRAMES, frameCount - offset);
+        float* io = buffer + offset * channels;
+
+        if (m_stride == channels) {
+            for (int i = 0; i < frames * channels; ++i) {
+                m_block[i] = io[i];
+            }
+        } else {
+            // Odd channel counts: the padding lane stays at zero
+            for (int frame = 0; frame < frames; ++frame) {
+                double* row = m_block + frame * m_stride;
+                for (int ch = 0; ch < channels; ++ch) {
+                    row[ch] = io[frame * channels + ch];
+                }
+                row[channels] = 0.0;
+            }
+        }
+
+        // Band-outer: each group of sections runs over the whole block, one
+        // channel strip at a time
+        for (int i = 0; i < m_stripCount; ++i) {
+            m_strips[i].runner(sections, bandCount, m_block, frames, m_stride, m_strips[i].lane);
+        }
+
+        if (m_stride == channels) {
+            for (int i = 0; i < frames * channels; ++i) {
+                io[i] = static_cast<float>(std::clamp(m_block[i], -OUTPUT_LIMIT, OUTPUT_LIMIT));
+            }
+        } else {
+            for (int frame = 0; frame < frames; ++frame) {
+                const double* row = m_block + frame * m_stride;
+                for (int ch = 0; ch < channels; ++ch) {
+                    io[frame * channels + ch] = static_cast<float>(std::clamp(row[ch], -OUTPUT_LIMIT, OUTPUT_LIMIT));
+                }
+            }
+        }
+    }
+
+    if (!m_hardwareFlushToZero) {
+        flushDenormals(bands, bandCount, channels);
+    }
+}
+
+void BiquadBank::flushDenormals(const int* bands, int bandCount, int channels)
+{
+    // Once per buffer instead of per sample: the state only decays into the
+    // denormal range after long stretches of silence
+    for (int i = 0; i < bandCount; ++i) {
+        Section& s = m_sections[bands[i]];
+        for (int ch = 0; ch < channels; ++ch) {
+            if (std::abs(s.s1[ch]) < DENORMAL_THRESHOLD) s.s1[ch] = 0.0;
+            if (std::abs(s.s2[ch]) < DENORMAL_THRESHOLD) s.s2[ch] = 0.0;
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#ifndef BIQUADKERNEL_H
+#define BIQUADKERNEL_H
+
+#include <cmath>
+
+enum class FilterType {
+    Peaking,
+    LowShelf,
+    HighShelf,
+    HighPass,  // Gain is ignored
+    LowPass    // Gain is ignored
+};
+
+// Normalized biquad coefficients (a0 == 1)
+struct BiquadCoefficients {
+    double b0{1.0}, b1{0.0}, b2{0.0}, a1{0.0}, a2{0.0};
+
+    // Audio EQ Cookbook design for any FilterType
+    static BiquadCoefficients design(FilterType type, double frequency, double sampleRate,
+                                     double gainDB, double Q) {
+        if (type == FilterType::Peaking) {
+            return peakingEQ(frequency, sampleRate, gainDB, Q);
+        }
+        double A = std::pow(10.0, gainDB / 40.0);
+        double omega = 2.0 * M_PI * frequency / sampleRate;
+        double sn = std::sin(omega);
+        double cs = std::cos(omega);
+        double alpha = sn / (2.0 * Q);
+        double beta = 2.0 * std::sqrt(A) * alpha;
+
+        double b0 = 1.0, b1 = 0.0, b2 = 0.0, a0 = 1.0, a1 = 0.0, a2 = 0.0;
+        switch (type) {
+        case FilterType::LowShelf:
+            b0 = A * ((A + 1.0) - (A - 1.0) * cs + beta);
+            b1 = 2.0 * A * ((A - 1.0) - (A + 1.0) * cs);
+            b2 = A * ((A + 1.0) - (A - 1.0) * cs - beta);
+            a0 = (A + 1.0) + (A - 1.0) * cs + beta;
+            a1 = -2.0 * ((A - 1.0) + (A + 1.0) * cs);
+            a2 = (A + 1.0) + (A - 1.0) * cs - beta;
+            break;
+        case FilterType::HighShelf:
+            b0 = A * ((A + 1.0) + (A - 1.0) * cs + beta);
+            b1 = -2.0 * A * ((A - 1.0) + (A + 1.0) * cs);
+            b2 = A * ((A + 1.0) + (A - 1.0) * cs - beta);
+            a0 = (A + 1.0) - (A - 1.0) * cs + beta;
+            a1 = 2.0 * ((A - 1.0) - (A + 1.0) * cs);
+            a2 = (A + 1.0) - (A - 1.0) * cs - beta;
+            break;
+        case FilterType::HighPass:
+            b0 = (1.0 + cs) / 2.0;
+            b1 = -(1.0 + cs);
+            b2 = (1.0 + cs) / 2.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cs;
+            a2 = 1.0 - alpha;
+            break;
+        case FilterType::LowPass:
+            b0 = (1.0 - cs) / 2.0;
+            b1 = 1.0 - cs;
+            b2 = (1.0 - cs) / 2.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cs;
+            a2 = 1.0 - alpha;
+            break;
+        case FilterType::Peaking:
+            break;
+        }
+
+        BiquadCoefficients c;
+        c.b0 = b0 / a0;
+        c.b1 = b1 / a0;
+        c.b2 = b2 / a0;
+        c.a1 = a1 / a0;
+        c.a2 = a2 / a0;
+        return c;
+    }
+
+    // Audio EQ Cookbook peaking EQ with constant 0 dB peak gain
+    static BiquadCoefficients peakingEQ(double frequency, double sampleRate, double gainDB, double Q = 1.0) {
+        double A = std::pow(10.0, gainDB / 40.0);  // A = sqrt(10^(dB/20)) = 10^(dB/40)
+        double omega = 2.0 * M_PI * frequency / sampleRate;
+        return peakingEQFromTerms(A, std::sin(omega), std::cos(omega), Q);
+    }
+
+    // Same design from precomputed terms, for table builders that share the
+    // trig per frequency and the pow per gain
+    static BiquadCoefficients peakingEQFromTerms(double A, double sn, double cs, double Q) {
+        double alpha = sn / (2.0 * Q);
+
+        double a0 = 1.0 + alpha / A;
+        BiquadCoefficients c;
+        c.b0 = (1.0 + alpha * A) / a0;
+        c.b1 = (-2.0 * cs) / a0;
+        c.b2 = (1.0 - alpha * A) / a0;
+        c.a1 = (-2.0 * cs) / a0;
+        c.a2 = (1.0 - alpha / A) / a0;
+        return c;
+    }
+
+    // |H(e^jw)| from cos/sin of w and 2w
+    double magnitude(double cw, double sw, double c2w, double s2w) const {
+        const double br = b0 + b1 * cw + b2 * c2w;
+        const double bi = b1 * sw + b2 * s2w;
+        const double ar = 1.0 + a1 * cw + a2 * c2w;
+        const double ai = a1 * sw + a2 * s2w;
+        return std::sqrt((br * br + bi * bi) / (ar * ar + ai * ai));
+    }
+};
+
+/**
+ * @class BiquadBank
+ * @brief Block-oriented storage and SIMD kernels for the EQ cascade
+ *
+ * Each band owns one packed Section holding its coefficients and transposed
+ * direct form II state, with every value replicated/kept per channel lane
+ * (up to MAX_CHANNELS, enough for 7.1). All sections live in one contiguous
+ * array, so a band-outer pass touches a single 32-byte aligned record.
+ *
+ * Processing converts the interleaved float input into a double block once,
+ * runs the bands over the whole block in place, up to MAX_FUSED sections per
+ * pass with their state kept in registers for the entire inner loop, then
+ * clamps and converts back to float.
+ *
+ * Channels are processed in parallel lanes, in strips across the interleaved
+ * block (odd channel counts are padded with one silent lane):
+ * - 1 channel: scalar
+ * - 2-lane strips: SSE2, two channels in the double lanes of one register
+ * - 4-lane strips: AVX, four channels per register, chosen at runtime when
+ *   the CPU supports it and there are more than two channels (so 7.1 runs
+ *   as two AVX strips)
+ *
+ * Stereo on AVX2/FMA CPUs runs the whole cascade as a wavefront instead:
+ * pairs of sections share a register for both channels and section k works
+ * on frame t - k, so all sections advance at once rather than one after the
+ * other. See bench/biquad_bench.cpp for timings.
+ *
+ * Strip cascades of exactly 10 or 31 sections (the standard graphic
+ * layouts with every band active) run through a schedule unrolled at
+ * compile time (group sizes and kernel calls resolved statically); any
+ * other section count uses the table at runtime. The choice goes by the number of
+ * sections passed to process(), not by the layout.
+ */
+class BiquadBank {
+public:
+    static constexpr int MAX_BANDS = 32;
+    static constexpr int MAX_CHANNELS = 8;
+    static constexpr int BLOCK_FRAMES = 256;
+    static constexpr int MAX_FUSED = 8;
+
+    struct alignas(32) Section {
+        double b0[MAX_CHANNELS];
+        double b1[MAX_CHANNELS];
+        double b2[MAX_CHANNELS];
+        double a1[MAX_CHANNELS];
+        double a2[MAX_CHANNELS];
+        double s1[MAX_CHANNELS];
+        double s2[MAX_CHANNELS];
+    };
+
+    // Runs a group of sections over the channel lanes starting at `lane` of
+    // an interleaved double block with `stride` doubles per frame, in place
+    using BlockKernel = void (*)(Section* const* sections, double* block, int frameCount,
+                                 int stride, int lane);
+    // Runs a whole cascade of sections over the same lanes
+    using CascadeRunner = void (*)(Section* const* sections, int sectionCount, double* block,
+                                   int frameCount, int stride, int lane);
+
+    BiquadBank();
+
+    void setCoefficients(int band, const BiquadCoefficients& c);
+    void reset();
+    void resetBand(int band);
+
+    // True once every channel's state of the band is below threshold
+    bool isSettled(int band, int channels, double threshold) const;
+
+    // The processing thread runs with FTZ/DAZ set (see RealtimeThread), so
+    // state cannot go denormal and the per-buffer flush is skipped
+    void setHardwareFlushToZero(bool enabled) { m_hardwareFlushToZero = enabled; }
+
+    // Run the listed bands in cascade over interleaved float frames, in place
+    void process(const int* bands, int bandCount, float* buffer, int frameCount, int channels);
+
+private:
+    // One cascade runner per group of channel lanes
+    struct Strip {
+        CascadeRunner runner;
+        int lane;
+    };
+
+    Section m_sections[MAX_BANDS];
+    alignas(32) double m_block[BLOCK_FRAMES * MAX_CHANNELS];
+
+    // Strip plan, rebuilt when the channel or section count changes
+    Strip m_strips[MAX_CHANNELS]{};
+    int m_stripCount{0};
+    int m_stride{0};
+    int m_plannedChannels{0};
+    int m_plannedSections{0};
+    bool m_hardwareFlushToZero{false};
+
+    void planStrips(int channels, int sectionCount);
+    void flushDenormals(const int* bands, int bandCount, int channels);
+};
+
+#endif // BIQUADKERNEL_H
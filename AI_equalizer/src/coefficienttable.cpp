@@ -0,0 +1,59 @@
+#include "coefficienttable.h"
+#include <algorithm>
+
+CoefficientTable::CoefficientTable(const double* frequencies, int bandCount, double Q)
+    : m_frequencies(frequencies, frequencies + bandCount), m_Q(Q)
+{
+    // A = 10^(dB/40) per gain step, shared by every rate and band
+    std::vector<double> amplitudes(GAIN_STEPS);
+    for (int step = 0; step < GAIN_STEPS; ++step) {
+        amplitudes[step] = std::pow(10.0, (MIN_GAIN_DB + step * GAIN_STEP_DB) / 40.0);
+    }
+
+    m_table.resize(static_cast<size_t>(NUM_RATES) * bandCount * GAIN_STEPS);
+    auto out = m_table.begin();
+    for (int rate = 0; rate < NUM_RATES; ++rate) {
+        for (int band = 0; band < bandCount; ++band) {
+            const double omega = 2.0 * M_PI * m_frequencies[band] / SUPPORTED_RATES[rate];
+            const double sn = std::sin(omega);
+            const double cs = std::cos(omega);
+            for (int step = 0; step < GAIN_STEPS; ++step) {
+                *out++ = BiquadCoefficients::peakingEQFromTerms(amplitudes[step], sn, cs, m_Q);
+            }
+        }
+    }
+}
+
+BiquadCoefficients CoefficientTable::lookup(int band, double sampleRate, double gainDB) const
+{
+    const int bandCount = static_cast<int>(m_frequencies.size());
+    if (band < 0 || band >= bandCount) {
+        return BiquadCoefficients();
+    }
+    const int rate = rateIndex(sampleRate);
+    if (rate < 0) {
+        return BiquadCoefficients::peakingEQ(m_frequencies[band], sampleRate, quantizeGain(gainDB), m_Q);
+    }
+    return m_table[(static_cast<size_t>(rate) * bandCount + band) * GAIN_STEPS + gainIndex(gainDB)];
+}
+
+double CoefficientTable::quantizeGain(double gainDB)
+{
+    return MIN_GAIN_DB + gainIndex(gainDB) * GAIN_STEP_DB;
+}
+
+int CoefficientTable::gainIndex(double gainDB)
+{
+    const double clamped = std::clamp(gainDB, MIN_GAIN_DB, MAX_GAIN_DB);
+    return static_cast<int>(std::lround((clamped - MIN_GAIN_DB) / GAIN_STEP_DB));
+}
+
+int CoefficientTable::rateIndex(double sampleRate)
+{
+    for (int i = 0; i < NUM_RATES; ++i) {
+        if (SUPPORTED_RATES[i] == sampleRate) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,48 @@
+#ifndef COEFFICIENTTABLE_H
+#define COEFFICIENTTABLE_H
+
+#include <vector>
+#include "biquadkernel.h"
+
+/**
+ * @class CoefficientTable
+ * @brief Precomputed peaking EQ coefficients for a fixed set of bands
+ *
+ * Indexed by [sample rate][band][gain step], with gains quantized to
+ * GAIN_STEP_DB over the engine's gain range. Building is cheap because the
+ * trig only depends on (rate, band) and the pow only on the gain step, so
+ * every supported rate is tabulated up front. After that a gain change costs
+ * a table read instead of pow/sin/cos.
+ *
+ * Rates outside SUPPORTED_RATES fall back to computing the design directly.
+ */
+class CoefficientTable {
+public:
+    static constexpr double MIN_GAIN_DB = -30.0;
+    static constexpr double MAX_GAIN_DB = 30.0;
+    static constexpr double GAIN_STEP_DB = 0.1;
+    static constexpr int GAIN_STEPS = 601;  // (MAX - MIN) / STEP + 1
+
+    static constexpr int NUM_RATES = 5;
+    static constexpr double SUPPORTED_RATES[NUM_RATES] = {
+        44100.0, 48000.0, 88200.0, 96000.0, 192000.0
+    };
+
+    CoefficientTable(const double* frequencies, int bandCount, double Q);
+
+    BiquadCoefficients lookup(int band, double sampleRate, double gainDB) const;
+    static bool isTabulated(double sampleRate) { return rateIndex(sampleRate) >= 0; }
+
+    // Gain actually realized by lookup()
+    static double quantizeGain(double gainDB);
+
+private:
+    std::vector<double> m_frequencies;
+    double m_Q;
+    std::vector<BiquadCoefficients> m_table;
+
+    static int gainIndex(double gainDB);
+    static int rateIndex(double sampleRate);
+};
+
+#endif // COEFFICIENTTABLE_H
@@ -0,0 +1,30 @@
+#include "driftestimator.h"
+#include <algorithm>
+
+void DriftEstimator::configure(int sampleRate, double maxDeviation)
+{
+    m_sampleRate = sampleRate;
+    m_maxDeviation = maxDeviation;
+    m_average = 0.0;
+    m_integral = 0.0;
+    m_ratio = 1.0;
+    m_primed = false;
+}
+
+double DriftEstimator::update(int fillFrames, int targetFrames, int elapsedFrames)
+{
+    if (!m_primed) {
+        m_average = fillFrames;
+        m_primed = true;
+    }
+    const double alpha = std::min(1.0, elapsedFrames / (SMOOTHING_SECONDS * m_sampleRate));
+    m_average += alpha * (fillFrames - m_average);
+
+    // Fill error in seconds of audio
+    const double error = (m_average - targetFrames) / m_sampleRate;
+    const double dt = elapsedFrames / m_sampleRate;
+    m_integral = std::clamp(m_integral + error * dt / (CORRECTION_SECONDS * INTEGRAL_SECONDS),
+                            -m_maxDeviation, m_maxDeviation);
+    m_ratio = 1.0 + std::clamp(error / CORRECTION_SECONDS + m_integral, -m_maxDeviation, m_maxDeviation);
+    return m_ratio;
+}
@@ -0,0 +1,46 @@
+#ifndef DRIFTESTIMATOR_H
+#define DRIFTESTIMATOR_H
+
+/**
+ * @class DriftEstimator
+ * @brief Estimates capture/playback clock drift from the queue fill level
+ *
+ * Capture and playback run on independent clocks, so the queue between them
+ * slowly fills or drains. The fill level, smoothed over SMOOTHING_SECONDS,
+ * drives a PI controller whose output is the resampling ratio (input frames
+ * per output frame): a queue above target is played slightly faster. The
+ * integral term settles on the actual drift, leaving the fill at the
+ * target; the proportional term pulls fill errors back within about
+ * CORRECTION_SECONDS. Both are limited to maxDeviation (anti-windup).
+ *
+ * Used by the writer thread only.
+ */
+class DriftEstimator {
+public:
+    static constexpr double SMOOTHING_SECONDS = 2.0;
+    static constexpr double CORRECTION_SECONDS = 10.0;
+    static constexpr double INTEGRAL_SECONDS = 100.0;
+
+    void configure(int sampleRate, double maxDeviation);
+
+    // Forgets the smoothed fill (e.g. after re-prebuffering); the drift
+    // estimate itself is kept
+    void restartAverage() { m_primed = false; }
+
+    // Called once per write with the fill seen before reading elapsedFrames
+    double update(int fillFrames, int targetFrames, int elapsedFrames);
+
+    double ratio() const { return m_ratio; }
+    // Estimated drift: positive when capture runs fast relative to playback
+    double driftPpm() const { return m_integral * 1e6; }
+
+private:
+    double m_sampleRate{44100.0};
+    double m_maxDeviation{0.0};
+    double m_average{0.0};
+    double m_integral{0.0};
+    double m_ratio{1.0};
+    bool m_primed{false};
+};
+
+#endif // DRIFTESTIMATOR_H
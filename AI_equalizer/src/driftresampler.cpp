@@ -0,0 +1,148 @@
+#include "driftresampler.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define DRIFT_USE_SSE 1
+#endif
+
+DriftResampler::DriftResampler()
+{
+    // Tap k multiplies the input HALF - 1 - k + frac frames before the output position
+    for (int p = 0; p <= PHASES; ++p) {
+        const double frac = static_cast<double>(p) / PHASES;
+        double taps[TAPS];
+        double sum = 0.0;
+        for (int k = 0; k < TAPS; ++k) {
+            const double d = k - (HALF - 1) - frac;
+            // Exact zeros at whole-frame offsets keep integer positions bit-exact
+            double sinc;
+            if (d == std::round(d)) {
+                sinc = d == 0.0 ? 1.0 : 0.0;
+            } else {
+                sinc = std::sin(M_PI * d) / (M_PI * d);
+            }
+            const double window = 0.42 + 0.5 * std::cos(M_PI * d / HALF) + 0.08 * std::cos(2.0 * M_PI * d / HALF);
+            taps[k] = sinc * window;
+            sum += taps[k];
+        }
+        for (int k = 0; k < TAPS; ++k) {
+            m_kernels[p][k] = static_cast<float>(taps[k] / sum);
+        }
+    }
+    reset(2);
+}
+
+void DriftResampler::reset(int channels)
+{
+    m_channels = std::clamp(channels, 1, MAX_CHANNELS);
+    m_history.assign(static_cast<size_t>(m_channels) * 2 * HISTORY_FRAMES, 0.0f);
+    m_inputFrames = 0;
+    m_outputIndex = 0;
+    m_outputFrac = 0.0;
+}
+
+void DriftResampler::setRatio(double ratio)
+{
+    m_ratio = std::clamp(ratio, 1.0 - MAX_DEVIATION, 1.0 + MAX_DEVIATION);
+}
+
+void DriftResampler::prepareKernel(double frac)
+{
+    const double position = frac * PHASES;
+    const int phase = std::min(static_cast<int>(position), PHASES - 1);
+    const float mu = static_cast<float>(position - phase);
+    const float* a = m_kernels[phase];
+    const float* b = m_kernels[phase + 1];
+#ifdef DRIFT_USE_SSE
+    const __m128 weight = _mm_set1_ps(mu);
+    for (int k = 0; k < TAPS; k += 4) {
+        const __m128 va = _mm_load_ps(a + k);
+        const __m128 vb = _mm_load_ps(b + k);
+        _mm_store_ps(m_kernel + k, _mm_add_ps(va, _mm_mul_ps(weight, _mm_sub_ps(vb, va))));
+    }
+#else
+    for (int k = 0; k < TAPS; ++k) {
+        m_kernel[k] = a[k] + mu * (b[k] - a[k]);
+    }
+#endif
+}
+
+float DriftResampler::dot(const float* samples) const
+{
+#ifdef DRIFT_USE_SSE
+    __m128 s0 = _mm_setzero_ps();
+    __m128 s1 = _mm_setzero_ps();
+    for (int k = 0; k < TAPS; k += 8) {
+        s0 = _mm_add_ps(s0, _mm_mul_ps(_mm_load_ps(m_kernel + k), _mm_loadu_ps(samples + k)));
+        s1 = _mm_add_ps(s1, _mm_mul_ps(_mm_load_ps(m_kernel + k + 4), _mm_loadu_ps(samples + k + 4)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, _mm_add_ps(s0, s1));
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    // Independent partial sums; a single accumulator is add-latency bound
+    float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+    for (int k = 0; k < TAPS; k += 4) {
+        s0 += m_kernel[k] * samples[k];
+        s1 += m_kernel[k + 1] * samples[k + 1];
+        s2 += m_kernel[k + 2] * samples[k + 2];
+        s3 += m_kernel[k + 3] * samples[k + 3];
+    }
+    return (s0 + s1) + (s2 + s3);
+#endif
+}
+
+int DriftResampler::process(const float* input, int inputFrames, float* output)
+{
+    return processAs<SampleFormat::Float32>(input, inputFrames, reinterpret_cast<uint8_t*>(output));
+}
+
+int DriftResampler::process(const float* input, int inputFrames, void* output, SampleFormat outputFormat)
+{
+    uint8_t* out = static_cast<uint8_t*>(output);
+    switch (outputFormat) {
+    case SampleFormat::S16:
+        return processAs<SampleFormat::S16>(input, inputFrames, out);
+    case SampleFormat::S24:
+        return processAs<SampleFormat::S24>(input, inputFrames, out);
+    case SampleFormat::S32:
+        return processAs<SampleFormat::S32>(input, inputFrames, out);
+    case SampleFormat::Float32:
+        break;
+    }
+    return processAs<SampleFormat::Float32>(input, inputFrames, out);
+}
+
+template <SampleFormat F>
+int DriftResampler::processAs(const float* input, int inputFrames, uint8_t* output)
+{
+    const int sampleBytes = bytesPerSample(F);
+    int outputFrames = 0;
+    for (int frame = 0; frame < inputFrames; ++frame) {
+        const int pos = static_cast<int>(m_inputFrames & HISTORY_MASK);
+        for (int ch = 0; ch < m_channels; ++ch) {
+            float* history = &m_history[ch * 2 * HISTORY_FRAMES];
+            history[pos] = history[pos + HISTORY_FRAMES] = input[frame * m_channels + ch];
+        }
+        ++m_inputFrames;
+
+        // Every output whose kernel window now lies within the history
+        while (m_outputIndex + HALF < m_inputFrames) {
+            prepareKernel(m_outputFrac);
+            const int start = static_cast<int>((m_outputIndex - (HALF - 1)) & HISTORY_MASK);
+            uint8_t* out = output + outputFrames * m_channels * sampleBytes;
+            for (int ch = 0; ch < m_channels; ++ch) {
+                SampleCodec<F>::store(out + ch * sampleBytes, dot(&m_history[ch * 2 * HISTORY_FRAMES + start]));
+            }
+            ++outputFrames;
+
+            m_outputFrac += m_ratio;
+            const double whole = std::floor(m_outputFrac);
+            m_outputIndex += static_cast<int64_t>(whole);
+            m_outputFrac -= whole;
+        }
+    }
+    return outputFrames;
+}
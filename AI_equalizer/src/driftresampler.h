@@ -0,0 +1,75 @@
+#ifndef DRIFTRESAMPLER_H
+#define DRIFTRESAMPLER_H
+
+#include <cstdint>
+#include <vector>
+#include "sampleformat.h"
+
+/**
+ * @class DriftResampler
+ * @brief Variable-ratio resampler for ratios within a fraction of a percent of 1
+ *
+ * Absorbs the clock difference between the capture source and the playback
+ * sink: ratio() input frames are consumed per output frame. Each output is
+ * a TAPS-point windowed-sinc interpolation at a fractional input position;
+ * the kernel for that position is interpolated between the two nearest of
+ * PHASES precomputed ones, then applied to every channel as a contiguous
+ * dot product (SSE where available).
+ *
+ * The sinc is not band-limited below Nyquist: at ratios this close to 1
+ * there is nothing to alias, and a whole-frame position reduces the kernel
+ * to a single 1.0 tap, so a ratio of exactly 1 passes audio through
+ * bit-exact. LATENCY_FRAMES of input are held back for the kernel's
+ * look-ahead.
+ *
+ * Output can be written in any SampleFormat, converted as each frame is
+ * computed, so the playback stream gets the sink's format without a
+ * separate pass.
+ */
+class DriftResampler {
+public:
+    static constexpr int TAPS = 32;
+    static constexpr int PHASES = 128;
+    static constexpr int MAX_CHANNELS = 8;
+    static constexpr int LATENCY_FRAMES = TAPS / 2;
+    static constexpr double MAX_DEVIATION = 0.002;  // Ratio limit, ±2000 ppm
+
+    DriftResampler();
+
+    // Clears the history; the next output starts at the next input frame
+    void reset(int channels);
+
+    // Input frames per output frame, clamped to 1 ± MAX_DEVIATION
+    void setRatio(double ratio);
+    double ratio() const { return m_ratio; }
+
+    // Consumes all of the input; returns the number of frames written
+    int process(const float* input, int inputFrames, float* output);
+    int process(const float* input, int inputFrames, void* output, SampleFormat outputFormat);
+
+    // Output capacity process() needs for inputFrames
+    static int maxOutputFrames(int inputFrames) { return inputFrames + inputFrames / 256 + 2; }
+
+private:
+    static constexpr int HALF = LATENCY_FRAMES;
+    static constexpr int HISTORY_FRAMES = 2 * TAPS;
+    static constexpr int HISTORY_MASK = HISTORY_FRAMES - 1;
+
+    // Kernel rows for fractional positions p / PHASES, p = 0..PHASES
+    alignas(16) float m_kernels[PHASES + 1][TAPS];
+    alignas(16) float m_kernel[TAPS];  // Interpolated kernel for the current output
+
+    std::vector<float> m_history;  // [channel][2 * HISTORY_FRAMES], stored twice over
+    int m_channels{0};
+    int64_t m_inputFrames{0};  // Frames appended so far
+    int64_t m_outputIndex{0};  // Integer part of the next output's input position
+    double m_outputFrac{0.0};  // Fractional part, in [0, 1)
+    double m_ratio{1.0};
+
+    template <SampleFormat F>
+    int processAs(const float* input, int inputFrames, uint8_t* output);
+    void prepareKernel(double frac);
+    float dot(const float* samples) const;
+};
+
+#endif // DRIFTRESAMPLER_H
@@ -0,0 +1,154 @@
+#include "enginecontrol.h"
+#include <QThread>
+#include <algorithm>
+
+EngineControl::EngineControl(EqualizerEngine* engine)
+    : m_engine(engine)
+{
+    m_thread = QThread::create([this] { run(); });
+    m_thread->setObjectName("eq-control");
+    m_thread->start();
+}
+
+EngineControl::~EngineControl()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_quit = true;
+        m_wake.wakeOne();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void EngineControl::post(const EqualizerEngine::Command& command)
+{
+    QMutexLocker locker(&m_mutex);
+    merge(m_pending, command);
+    m_wake.wakeOne();
+}
+
+void EngineControl::setSampleRate(double rate)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_pending.any = true;
+        m_pending.sampleRate = true;
+        m_pending.rate = rate;
+        m_wake.wakeOne();
+    }
+    flush();
+}
+
+void EngineControl::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    while (m_pending.any || m_applying) {
+        m_idle.wait(&m_mutex);
+    }
+}
+
+void EngineControl::merge(Pending& pending, const EqualizerEngine::Command& command)
+{
+    using Type = EqualizerEngine::Command::Type;
+    pending.any = true;
+    switch (command.type) {
+    case Type::Layout:
+        // A new layout brings its own bands and gains
+        pending.layout = true;
+        pending.layoutCommand = command;
+        pending.allGains = false;
+        std::fill(pending.bandConfig, pending.bandConfig + MAX_BANDS, false);
+        std::fill(pending.bandGain, pending.bandGain + MAX_BANDS, false);
+        break;
+    case Type::BandConfig:
+        if (command.band >= 0 && command.band < MAX_BANDS) {
+            pending.bandConfig[command.band] = true;
+            pending.configs[command.band] = command.bands[0];
+        }
+        break;
+    case Type::AllGains:
+        pending.allGains = true;
+        pending.gainCount = command.count;
+        std::copy(command.gains, command.gains + command.count, pending.gains);
+        std::fill(pending.bandGain, pending.bandGain + MAX_BANDS, false);
+        break;
+    case Type::BandGain:
+        if (command.band < 0 || command.band >= MAX_BANDS) {
+            break;
+        }
+        if (pending.allGains && command.band < pending.gainCount) {
+            pending.gains[command.band] = command.gains[0];
+        } else {
+            pending.bandGain[command.band] = true;
+            pending.bandGains[command.band] = command.gains[0];
+        }
+        break;
+    case Type::Mode:
+        pending.mode = true;
+        pending.modeValue = command.mode;
+        break;
+    case Type::Bypass:
+        pending.bypass = true;
+        pending.bypassValue = command.enabled;
+        break;
+    }
+}
+
+void EngineControl::run()
+{
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (!m_pending.any && !m_quit) {
+            m_wake.wait(&m_mutex);
+        }
+        // Whatever is still pending goes in before quitting
+        if (!m_pending.any) {
+            break;
+        }
+        m_taken = m_pending;
+        m_pending = Pending();
+        m_applying = true;
+        locker.unlock();
+        apply(m_taken);
+        locker.relock();
+        m_applying = false;
+        m_idle.wakeAll();
+    }
+}
+
+void EngineControl::apply(const Pending& changes)
+{
+    // Rate and layout changes publish and reset on their own, so the band
+    // changes below land on the new filters
+    if (changes.sampleRate) {
+        m_engine->setSampleRate(changes.rate);
+    }
+    if (changes.layout) {
+        m_engine->apply(changes.layoutCommand);
+    }
+
+    m_engine->beginUpdate();
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        if (changes.bandConfig[band]) {
+            m_engine->setBandConfig(band, changes.configs[band]);
+        }
+    }
+    if (changes.allGains) {
+        m_engine->setAllGains(QVector<double>(changes.gains, changes.gains + changes.gainCount));
+    }
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        if (changes.bandGain[band]) {
+            m_engine->setBandGain(band, changes.bandGains[band]);
+        }
+    }
+    m_engine->commitUpdate();
+
+    // After the publish, so a switch to linear phase finds its FIR designed
+    if (changes.mode) {
+        m_engine->setMode(changes.modeValue);
+    }
+    if (changes.bypass) {
+        m_engine->setBypass(changes.bypassValue);
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef ENGINECONTROL_H
+#define ENGINECONTROL_H
+
+#include <QMutex>
+#include <QWaitCondition>
+#include "equalizerengine.h"
+
+class QThread;
+
+/**
+ * @class EngineControl
+ * @brief The control thread of an EqualizerEngine
+ *
+ * Commands posted from any thread are folded into latest-value slots: one
+ * sample rate, one layout, one configuration and one gain per band, one
+ * mode and one bypass flag. The control thread takes whatever has
+ * accumulated and applies it: the layout, then one batch for the bands
+ * (see EqualizerEngine::beginUpdate()), then mode and bypass. Coefficient
+ * design, linear-phase FIR redesign and coefficient table rebuilds all
+ * happen here; the audio thread only adopts the published snapshots.
+ *
+ * post() never waits on design work and never drops a change: a burst
+ * costs one redesign with the latest values, and the last state posted is
+ * always the one applied.
+ */
+class EngineControl {
+public:
+    // The engine must outlive the control thread
+    explicit EngineControl(EqualizerEngine* engine);
+    ~EngineControl();
+    EngineControl(const EngineControl&) = delete;
+    EngineControl& operator=(const EngineControl&) = delete;
+
+    // Any thread
+    void post(const EqualizerEngine::Command& command);
+    // Applied like a command; returns once it is in effect
+    void setSampleRate(double rate);
+    // Blocks until everything posted so far has been applied
+    void flush();
+
+private:
+    static constexpr int MAX_BANDS = EqualizerEngine::MAX_BANDS;
+
+    // Changes not applied yet; a slot only holds the latest value
+    struct Pending {
+        bool any{false};
+        bool sampleRate{false};
+        double rate{0.0};
+        bool layout{false};
+        EqualizerEngine::Command layoutCommand;  // Carries the layout's gains
+        bool bandConfig[MAX_BANDS]{};
+        BandConfig configs[MAX_BANDS]{};
+        bool allGains{false};
+        int gainCount{0};
+        double gains[MAX_BANDS]{};
+        bool bandGain[MAX_BANDS]{};
+        double bandGains[MAX_BANDS]{};
+        bool mode{false};
+        EqualizerEngine::Mode modeValue{EqualizerEngine::Mode::MinimumPhase};
+        bool bypass{false};
+        bool bypassValue{false};
+    };
+
+    EqualizerEngine* m_engine;
+    QThread* m_thread;
+    QMutex m_mutex;
+    QWaitCondition m_wake;  // Something pending, or quit
+    QWaitCondition m_idle;  // Nothing pending and nothing being applied
+    Pending m_pending;
+    bool m_applying{false};
+    bool m_quit{false};
+    Pending m_taken;  // Control thread only
+
+    static void merge(Pending& pending, const EqualizerEngine::Command& command);
+    void run();
+    void apply(const Pending& changes);
+};
+
+#endif // ENGINECONTROL_H
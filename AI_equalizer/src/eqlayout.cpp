@@ -0,0 +1,209 @@
+#include "eqlayout.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const double GRAPHIC10_FREQUENCIES[] = {
+    31.25, 62.5, 125, 250, 500, 1000, 2000, 4000, 8000, 16000
+};
+const double GRAPHIC10_Q = 1.0;
+
+// ISO 266 third-octave centers
+const double GRAPHIC31_FREQUENCIES[] = {
+    20, 25, 31.5, 40, 50, 63, 80, 100, 125, 160, 200, 250, 315, 400, 500, 630,
+    800, 1000, 1250, 1600, 2000, 2500, 3150, 4000, 5000, 6300, 8000, 10000,
+    12500, 16000, 20000
+};
+// Q for a one-third-octave bandwidth: sqrt(2^(1/3)) / (2^(1/3) - 1)
+const double GRAPHIC31_Q = 4.318;
+
+QVector<BandConfig> peakingBands(const double* frequencies, int count, double q)
+{
+    QVector<BandConfig> bands(count);
+    for (int i = 0; i < count; ++i) {
+        bands[i] = BandConfig{FilterType::Peaking, frequencies[i], q};
+    }
+    return bands;
+}
+
+bool hasGain(FilterType type)
+{
+    return type != FilterType::HighPass && type != FilterType::LowPass;
+}
+}
+
+EqLayout::EqLayout()
+    : EqLayout(graphic10())
+{
+}
+
+EqLayout::EqLayout(Kind kind, const QVector<BandConfig>& bands)
+    : m_kind(kind), m_bands(bands)
+{
+}
+
+EqLayout EqLayout::graphic10()
+{
+    return EqLayout(Kind::Graphic10, peakingBands(GRAPHIC10_FREQUENCIES, 10, GRAPHIC10_Q));
+}
+
+EqLayout EqLayout::graphic31()
+{
+    return EqLayout(Kind::Graphic31, peakingBands(GRAPHIC31_FREQUENCIES, 31, GRAPHIC31_Q));
+}
+
+EqLayout EqLayout::parametric(const QVector<BandConfig>& bands)
+{
+    return EqLayout(Kind::Parametric, bands.mid(0, MAX_BANDS));
+}
+
+EqLayout EqLayout::defaultParametric()
+{
+    return parametric({
+        {FilterType::LowShelf, 80.0, 0.707},
+        {FilterType::Peaking, 250.0, 1.0},
+        {FilterType::Peaking, 1000.0, 1.0},
+        {FilterType::Peaking, 4000.0, 1.0},
+        {FilterType::HighShelf, 10000.0, 0.707}
+    });
+}
+
+QVector<double> EqLayout::frequencies() const
+{
+    QVector<double> result;
+    result.reserve(m_bands.size());
+    for (const BandConfig& band : m_bands) {
+        result.append(band.frequency);
+    }
+    return result;
+}
+
+double EqLayout::sharedQ() const
+{
+    return m_bands.isEmpty() ? GRAPHIC10_Q : m_bands.first().q;
+}
+
+void EqLayout::setBand(int index, const BandConfig& config)
+{
+    if (m_kind == Kind::Parametric && index >= 0 && index < m_bands.size()) {
+        m_bands[index] = config;
+    }
+}
+
+QString EqLayout::bandLabel(int index) const
+{
+    if (index < 0 || index >= m_bands.size()) {
+        return QString();
+    }
+    const double frequency = m_bands[index].frequency;
+    if (frequency >= 1000.0) {
+        return QString::number(frequency / 1000.0, 'g', 3) + "k";
+    }
+    return QString::number(frequency, 'g', 3);
+}
+
+QVector<double> EqLayout::mapGains(const EqLayout& from, const QVector<double>& gains) const
+{
+    // Source points on a log2(frequency) axis, skipping gainless bands
+    QVector<QPair<double, double>> points;
+    for (int i = 0; i < from.bandCount() && i < gains.size(); ++i) {
+        if (hasGain(from.band(i).type)) {
+            points.append(qMakePair(std::log2(from.band(i).frequency), gains[i]));
+        }
+    }
+    std::sort(points.begin(), points.end());
+
+    QVector<double> result(m_bands.size(), 0.0);
+    if (points.isEmpty()) {
+        return result;
+    }
+    for (int i = 0; i < m_bands.size(); ++i) {
+        if (!hasGain(m_bands[i].type)) {
+            continue;
+        }
+        const double x = std::log2(m_bands[i].frequency);
+        if (x <= points.first().first) {
+            result[i] = points.first().second;
+        } else if (x >= points.last().first) {
+            result[i] = points.last().second;
+        } else {
+            int upper = 1;
+            while (points[upper].first < x) {
+                ++upper;
+            }
+            const auto& a = points[upper - 1];
+            const auto& b = points[upper];
+            const double t = (x - a.first) / (b.first - a.first);
+            result[i] = a.second + t * (b.second - a.second);
+        }
+    }
+    return result;
+}
+
+QString EqLayout::kindName(Kind kind)
+{
+    switch (kind) {
+    case Kind::Graphic10:
+        return "graphic10";
+    case Kind::Graphic31:
+        return "graphic31";
+    case Kind::Parametric:
+        return "parametric";
+    }
+    return QString();
+}
+
+bool EqLayout::kindFromName(const QString& name, Kind* kind)
+{
+    for (Kind candidate : {Kind::Graphic10, Kind::Graphic31, Kind::Parametric}) {
+        if (name.compare(kindName(candidate), Qt::CaseInsensitive) == 0) {
+            *kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+QString EqLayout::typeName(FilterType type)
+{
+    switch (type) {
+    case FilterType::Peaking:
+        return "peak";
+    case FilterType::LowShelf:
+        return "lowshelf";
+    case FilterType::HighShelf:
+        return "highshelf";
+    case FilterType::HighPass:
+        return "highpass";
+    case FilterType::LowPass:
+        return "lowpass";
+    }
+    return QString();
+}
+
+bool EqLayout::typeFromName(const QString& name, FilterType* type)
+{
+    for (FilterType candidate : {FilterType::Peaking, FilterType::LowShelf, FilterType::HighShelf,
+                                 FilterType::HighPass, FilterType::LowPass}) {
+        if (name.compare(typeName(candidate), Qt::CaseInsensitive) == 0) {
+            *type = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool EqLayout::operator==(const EqLayout& other) const
+{
+    if (m_kind != other.m_kind || m_bands.size() != other.m_bands.size()) {
+        return false;
+    }
+    for (int i = 0; i < m_bands.size(); ++i) {
+        const BandConfig& a = m_bands[i];
+        const BandConfig& b = other.m_bands[i];
+        if (a.type != b.type || a.frequency != b.frequency || a.q != b.q) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef EQLAYOUT_H
+#define EQLAYOUT_H
+
+#include <QMetaType>
+#include <QString>
+#include <QVector>
+#include "biquadkernel.h"
+
+// One band of the equalizer; gain is kept separately by the engine
+struct BandConfig {
+    FilterType type{FilterType::Peaking};
+    double frequency{1000.0};  // Center/corner frequency (Hz)
+    double q{1.0};
+};
+
+/**
+ * @class EqLayout
+ * @brief Band count, frequencies and filter types of the equalizer
+ *
+ * Graphic layouts are fixed sets of peaking bands with a shared Q (the
+ * classic 10-band octave EQ and a 31-band ISO third-octave EQ); their
+ * coefficients are tabulated by the engine. Parametric layouts carry any
+ * number of bands up to MAX_BANDS, each with its own type, frequency and Q.
+ *
+ * Plain value type, cheap to copy and safe to pass through queued signals.
+ */
+class EqLayout {
+public:
+    enum class Kind {
+        Graphic10,
+        Graphic31,
+        Parametric
+    };
+
+    static constexpr int MAX_BANDS = BiquadBank::MAX_BANDS;
+
+    EqLayout();  // Graphic10
+
+    static EqLayout graphic10();
+    static EqLayout graphic31();
+    // Bands beyond MAX_BANDS are dropped
+    static EqLayout parametric(const QVector<BandConfig>& bands);
+    // Starting point for the parametric editor: shelves around three peaks
+    static EqLayout defaultParametric();
+
+    Kind kind() const { return m_kind; }
+    bool isGraphic() const { return m_kind != Kind::Parametric; }
+    int bandCount() const { return m_bands.size(); }
+    const BandConfig& band(int index) const { return m_bands[index]; }
+    const QVector<BandConfig>& bands() const { return m_bands; }
+    QVector<double> frequencies() const;
+    double sharedQ() const;  // Q of a graphic layout's bands
+
+    // Parametric layouts only; ignored for graphic ones
+    void setBand(int index, const BandConfig& config);
+
+    // Short slider label, e.g. "31", "1k", "12.5k"
+    QString bandLabel(int index) const;
+
+    // Moves gains set on another layout onto this one, interpolated on a
+    // log-frequency axis (held flat beyond the outermost bands)
+    QVector<double> mapGains(const EqLayout& from, const QVector<double>& gains) const;
+
+    static QString kindName(Kind kind);
+    static bool kindFromName(const QString& name, Kind* kind);
+    static QString typeName(FilterType type);
+    static bool typeFromName(const QString& name, FilterType* type);
+
+    bool operator==(const EqLayout& other) const;
+    bool operator!=(const EqLayout& other) const { return !(*this == other); }
+
+private:
+    EqLayout(Kind kind, const QVector<BandConfig>& bands);
+
+    Kind m_kind;
+    QVector<BandConfig> m_bands;
+};
+
+Q_DECLARE_METATYPE(BandConfig)
+Q_DECLARE_METATYPE(EqLayout)
+
+#endif // EQLAYOUT_H
@@ -1,38 +1,107 @@
 #include "equalizerengine.h"
 
-EqualizerEngine::EqualizerEngine(QObject *parent)
-    : QObject(parent), m_sampleRate(48000.0)
+EqualizerEngine::EqualizerEngine()
+    : m_sampleRate(48000.0),
+      m_coefficientTable(m_layout.frequencies().constData(), m_layout.bandCount(), m_layout.sharedQ()),
+      m_firFft(FIR_LENGTH), m_firTrig((FIR_LENGTH / 2 + 1) * 4),
+      m_firSpectrum(FIR_LENGTH), m_firTaps(FIR_LENGTH),
+      m_dry(BiquadBank::BLOCK_FRAMES * MAX_CHANNELS)
 {
-    m_bandGains.resize(NUM_BANDS);
-    m_filtersLeft.resize(NUM_BANDS);
-    m_filtersRight.resize(NUM_BANDS);
+    for (int bin = 0; bin <= FIR_LENGTH / 2; ++bin) {
+        const double omega = 2.0 * M_PI * bin / FIR_LENGTH;
+        m_firTrig[bin * 4 + 0] = std::cos(omega);
+        m_firTrig[bin * 4 + 1] = std::sin(omega);
+        m_firTrig[bin * 4 + 2] = std::cos(2.0 * omega);
+        m_firTrig[bin * 4 + 3] = std::sin(2.0 * omega);
+    }
     
     // Initialize all gains to 0 dB (no change)
-    for (int i = 0; i < NUM_BANDS; ++i) {
-        m_bandGains[i] = 0.0;
-    }
+    m_bandGains.fill(0.0, m_layout.bandCount());
     
     updateFilters();
 }
 
 void EqualizerEngine::setSampleRate(double rate)
 {
+    if (rate == m_sampleRate) {
+        return;
+    }
     m_sampleRate = rate;
     updateFilters();
+    // State built up at the old rate means nothing at the new one
+    reset();
+}
+
+void EqualizerEngine::setLayout(const EqLayout& layout, const QVector<double>& gains)
+{
+    if (layout.isGraphic() && layout.kind() != m_layout.kind()) {
+        const QVector<double> frequencies = layout.frequencies();
+        m_coefficientTable = CoefficientTable(frequencies.constData(), layout.bandCount(), layout.sharedQ());
+    }
+    m_layout = layout;
+    
+    if (gains.size() == layout.bandCount()) {
+        m_bandGains = gains;
+    } else {
+        m_bandGains.fill(0.0, layout.bandCount());
+    }
+    
+    // Slots past the new band count become identities and drain out
+    for (int band = layout.bandCount(); band < MAX_BANDS; ++band) {
+        m_pending.coefficients[band] = BiquadCoefficients();
+        m_pending.active[band] = false;
+        m_pending.subband[band] = false;
+        m_pending.subbandCoefficients[band] = BiquadCoefficients();
+        m_pending.svf[band] = SvfParameters();
+    }
+    beginUpdate();
+    updateFilters();
+    commitUpdate();
+    // Band indices now refer to different filters; start from rest
+    reset();
+}
+
+EqLayout EqualizerEngine::layout() const
+{
+    return m_layout;
+}
+
+int EqualizerEngine::bandCount() const
+{
+    return m_layout.bandCount();
+}
+
+void EqualizerEngine::setBandConfig(int band, const BandConfig& config)
+{
+    if (m_layout.isGraphic() || band < 0 || band >= m_layout.bandCount()) {
+        return;
+    }
+    beginUpdate();
+    m_layout.setBand(band, config);
+    updateSvfTuning(band);
+    markBandDirty(band);
+    commitUpdate();
 }
 
 void EqualizerEngine::setBandGain(int band, double gainDB)
 {
-    if (band >= 0 && band < NUM_BANDS) {
-        m_bandGains[band] = qBound(-30.0, gainDB, 30.0);
-        updateFilters();
-        emit bandGainChanged(band, m_bandGains[band]);
+    if (band < 0 || band >= m_bandGains.size()) {
+        return;
+    }
+    const double gain = qBound(-30.0, gainDB, 30.0);
+    if (gain == m_bandGains[band]) {
+        return;
     }
+    beginUpdate();
+    m_bandGains[band] = gain;
+    // Only the changed band is redesigned
+    markBandDirty(band);
+    commitUpdate();
 }
 
 double EqualizerEngine::getBandGain(int band) const
 {
-    if (band >= 0 && band < NUM_BANDS) {
+    if (band >= 0 && band < m_bandGains.size()) {
         return m_bandGains[band];
     }
     return 0.0;
@@ -40,13 +109,52 @@ double EqualizerEngine::getBandGain(int band) const
 
 void EqualizerEngine::setAllGains(const QVector<double>& gains)
 {
-    if (gains.size() == NUM_BANDS) {
-        m_bandGains = gains;
-        updateFilters();
-        for (int i = 0; i < NUM_BANDS; ++i) {
-            emit bandGainChanged(i, m_bandGains[i]);
+    applyGains(gains.constData(), gains.size());
+}
+
+void EqualizerEngine::applyGains(const double* gains, int count)
+{
+    if (count != m_bandGains.size()) {
+        return;
+    }
+    beginUpdate();
+    for (int i = 0; i < count; ++i) {
+        const double gain = qBound(-30.0, gains[i], 30.0);
+        if (gain != m_bandGains[i]) {
+            m_bandGains[i] = gain;
+            markBandDirty(i);
         }
     }
+    commitUpdate();
+}
+
+void EqualizerEngine::beginUpdate()
+{
+    ++m_updateDepth;
+}
+
+void EqualizerEngine::commitUpdate()
+{
+    if (m_updateDepth == 0 || --m_updateDepth > 0) {
+        return;
+    }
+    if (m_snapshotDirty) {
+        // Slots past a shrunk layout were already cleared by setLayout()
+        for (int band = 0; band < MAX_BANDS; ++band) {
+            if (m_bandDirty[band] && band < m_layout.bandCount()) {
+                updateBand(band);
+            }
+            m_bandDirty[band] = false;
+        }
+        m_snapshotDirty = false;
+        publishSnapshot();
+    }
+}
+
+void EqualizerEngine::markBandDirty(int band)
+{
+    m_bandDirty[band] = true;
+    m_snapshotDirty = true;
 }
 
 QVector<double> EqualizerEngine::getAllGains() const
@@ -54,57 +162,492 @@ QVector<double> EqualizerEngine::getAllGains() const
     return m_bandGains;
 }
 
+void EqualizerEngine::setMode(Mode mode)
+{
+    // The FIR must be current before the audio thread can switch to it; an
+    // open batch redesigns it when it publishes
+    if (mode == Mode::LinearPhase && m_firDirty && !m_snapshotDirty) {
+        updateLinearPhaseFir();
+    }
+    m_mode.store(static_cast<int>(mode), std::memory_order_release);
+}
+
+EqualizerEngine::Mode EqualizerEngine::mode() const
+{
+    return static_cast<Mode>(m_mode.load(std::memory_order_relaxed));
+}
+
+bool EqualizerEngine::isSubbandEligible(const BandConfig& band, double sampleRate)
+{
+    // Peaks, low shelves and high-passes only change the spectrum around and
+    // below their frequency, with skirts that widen as Q drops (f / Q). Keep
+    // that well inside the subband stage's passband.
+    constexpr double MAX_BANDWIDTH_RATIO = 1.0 / 512.0;
+    if (band.type == FilterType::HighShelf || band.type == FilterType::LowPass) {
+        return false;
+    }
+    return band.frequency / band.q <= sampleRate * MAX_BANDWIDTH_RATIO;
+}
+
+EqualizerEngine::Command EqualizerEngine::Command::setBandGain(int band, double gainDB)
+{
+    Command command;
+    command.type = Type::BandGain;
+    command.band = band;
+    command.gains[0] = gainDB;
+    return command;
+}
+
+EqualizerEngine::Command EqualizerEngine::Command::setAllGains(const QVector<double>& gains)
+{
+    Command command;
+    command.type = Type::AllGains;
+    command.count = std::min(static_cast<int>(gains.size()), MAX_BANDS);
+    std::copy(gains.constData(), gains.constData() + command.count, command.gains);
+    return command;
+}
+
+EqualizerEngine::Command EqualizerEngine::Command::setBandConfig(int band, const BandConfig& config)
+{
+    Command command;
+    command.type = Type::BandConfig;
+    command.band = band;
+    command.bands[0] = config;
+    return command;
+}
+
+EqualizerEngine::Command EqualizerEngine::Command::setLayout(const EqLayout& layout, const QVector<double>& gains)
+{
+    Command command = setAllGains(gains);
+    command.type = Type::Layout;
+    command.kind = layout.kind();
+    command.band = layout.bandCount();
+    std::copy(layout.bands().constData(), layout.bands().constData() + command.band, command.bands);
+    return command;
+}
+
+EqualizerEngine::Command EqualizerEngine::Command::setMode(Mode mode)
+{
+    Command command;
+    command.type = Type::Mode;
+    command.mode = mode;
+    return command;
+}
+
+EqualizerEngine::Command EqualizerEngine::Command::setBypass(bool enabled)
+{
+    Command command;
+    command.type = Type::Bypass;
+    command.enabled = enabled;
+    return command;
+}
+
+void EqualizerEngine::apply(const Command& command)
+{
+    switch (command.type) {
+    case Command::Type::BandGain:
+        setBandGain(command.band, command.gains[0]);
+        break;
+    case Command::Type::AllGains:
+        applyGains(command.gains, command.count);
+        break;
+    case Command::Type::BandConfig:
+        setBandConfig(command.band, command.bands[0]);
+        break;
+    case Command::Type::Layout: {
+        EqLayout layout = EqLayout::graphic10();
+        if (command.kind == EqLayout::Kind::Graphic31) {
+            layout = EqLayout::graphic31();
+        } else if (command.kind == EqLayout::Kind::Parametric) {
+            layout = EqLayout::parametric(QVector<BandConfig>(command.bands, command.bands + command.band));
+        }
+        setLayout(layout, QVector<double>(command.gains, command.gains + command.count));
+        break;
+    }
+    case Command::Type::Mode:
+        setMode(command.mode);
+        break;
+    case Command::Type::Bypass:
+        setBypass(command.enabled);
+        break;
+    }
+}
+
+void EqualizerEngine::setBypass(bool enabled)
+{
+    m_bypassForced.store(enabled, std::memory_order_release);
+}
+
+bool EqualizerEngine::isBypassForced() const
+{
+    return m_bypassForced.load(std::memory_order_relaxed);
+}
+
+bool EqualizerEngine::isBypassed() const
+{
+    return m_bypassActive.load(std::memory_order_relaxed);
+}
+
+int EqualizerEngine::latencyFrames() const
+{
+    return isBypassed() ? 0 : modeLatencyFrames(mode());
+}
+
+int EqualizerEngine::modeLatencyFrames(Mode mode) const
+{
+    switch (mode) {
+    case Mode::LinearPhase:
+        return FIR_DELAY + PartitionedConvolver::latencyFrames();
+    case Mode::Multirate:
+        return SubbandProcessor::LATENCY_FRAMES;
+    case Mode::MinimumPhase:
+    case Mode::StateVariable:
+        break;
+    }
+    return 0;
+}
+
+void EqualizerEngine::setFlushToZero(bool enabled)
+{
+    m_filters.setHardwareFlushToZero(enabled);
+    m_subband.bank().setHardwareFlushToZero(enabled);
+    m_svf.setHardwareFlushToZero(enabled);
+}
+
 void EqualizerEngine::processBuffer(float* buffer, int frameCount, int channels)
 {
-    if (channels == 2) {
-        // Stereo processing
-        for (int frame = 0; frame < frameCount; ++frame) {
-            float left = buffer[frame * 2];
-            float right = buffer[frame * 2 + 1];
-            
-            // Process through all bands (skip bands with near-zero gain)
-            for (int band = 0; band < NUM_BANDS; ++band) {
-                if (std::abs(m_bandGains[band]) > 0.01) {  // Only process if gain > 0.01 dB
-                    left = m_filtersLeft[band].process(left);
-                    right = m_filtersRight[band].process(right);
-                }
+    if (channels <= 0 || channels > MAX_CHANNELS) {
+        return;
+    }
+    
+    const Mode mode = beginBlock();
+    const bool bypass = m_bypassForced.load(std::memory_order_acquire) || m_snapshots.readBuffer().activeCount == 0;
+    if (!bypass && m_bypassed) {
+        // Leaving bypass: the filters start from rest and stay muted until
+        // their output is no longer just their startup delay
+        m_bypassed = false;
+        m_primeFrames = modeLatencyFrames(mode);
+        m_bypassActive.store(false, std::memory_order_relaxed);
+    }
+    if (bypass && m_bypassed) {
+        return;
+    }
+    if (bypass || m_wetFrames < BYPASS_FADE_FRAMES || m_primeFrames > 0) {
+        processCrossfade(mode, bypass, buffer, frameCount, channels);
+        return;
+    }
+    processFloat(mode, buffer, frameCount, channels);
+}
+
+EqualizerEngine::Mode EqualizerEngine::beginBlock()
+{
+    // Block boundary: adopt the latest published coefficients, if any
+    if (m_snapshots.update()) {
+        const CoefficientSnapshot& snapshot = m_snapshots.readBuffer();
+        for (int band = 0; band < MAX_BANDS; ++band) {
+            m_filters.setCoefficients(band, snapshot.coefficients[band]);
+            m_subband.bank().setCoefficients(band, snapshot.subbandCoefficients[band]);
+        }
+        // New gain targets start their ramps here
+        m_svf.setRampFrames(snapshot.svfRampFrames);
+        for (int band = 0; band < MAX_BANDS; ++band) {
+            m_svf.setParameters(band, snapshot.svf[band]);
+        }
+        // Newly active bands join with the state they have: zero if they
+        // were retired, warm if they were still draining
+        for (int i = 0; i < snapshot.activeCount; ++i) {
+            m_bandRunning[snapshot.activeBands[i]] = true;
+        }
+        rebuildRunningBands();
+    }
+    if (m_resetRequested.exchange(false, std::memory_order_acquire)) {
+        resetFilterState();
+    }
+    
+    const Mode mode = static_cast<Mode>(m_mode.load(std::memory_order_acquire));
+    if (mode != m_activeMode) {
+        // The paths have different latency; start the new one from rest
+        if (mode == Mode::LinearPhase) {
+            m_convolver.reset();
+        } else {
+            m_filters.reset();
+            m_subband.reset();
+            m_svf.reset();
+        }
+        m_activeMode = mode;
+        rebuildRunningBands();
+    }
+    return mode;
+}
+
+void EqualizerEngine::resetFilterState()
+{
+    m_filters.reset();
+    m_convolver.reset();
+    m_subband.reset();
+    m_svf.reset();
+    const CoefficientSnapshot& snapshot = m_snapshots.readBuffer();
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        m_bandRunning[band] = snapshot.active[band];
+    }
+    rebuildRunningBands();
+}
+
+void EqualizerEngine::processCrossfade(Mode mode, bool bypass, float* buffer, int frameCount, int channels)
+{
+    // The processed path runs in place next to a dry copy of each block and
+    // the two are mixed with a linear ramp; the ends of the ramp take either
+    // path unmixed
+    const int target = bypass ? 0 : BYPASS_FADE_FRAMES;
+    const int step = bypass ? -1 : 1;
+    constexpr float FADE_SCALE = 1.0f / BYPASS_FADE_FRAMES;
+    for (int offset = 0; offset < frameCount; offset += BiquadBank::BLOCK_FRAMES) {
+        const int frames = std::min(BiquadBank::BLOCK_FRAMES, frameCount - offset);
+        const int samples = frames * channels;
+        if (m_bypassed) {
+            continue;
+        }
+        float* wet = buffer + offset * channels;
+        float* dry = m_dry.data();
+        std::copy(wet, wet + samples, dry);
+        processFloat(mode, wet, frames, channels);
+        for (int frame = 0; frame < frames; ++frame) {
+            if (m_primeFrames > 0 && !bypass) {
+                --m_primeFrames;
+            } else if (m_wetFrames != target) {
+                m_wetFrames += step;
             }
-            
-            buffer[frame * 2] = left;
-            buffer[frame * 2 + 1] = right;
-        }
-    } else if (channels == 1) {
-        // Mono processing
-        for (int frame = 0; frame < frameCount; ++frame) {
-            float sample = buffer[frame];
-            
-            for (int band = 0; band < NUM_BANDS; ++band) {
-                if (std::abs(m_bandGains[band]) > 0.01) {  // Only process if gain > 0.01 dB
-                    sample = m_filtersLeft[band].process(sample);
+            float* sample = wet + frame * channels;
+            const float* drySample = dry + frame * channels;
+            if (m_wetFrames == 0) {
+                std::copy(drySample, drySample + channels, sample);
+            } else if (m_wetFrames < BYPASS_FADE_FRAMES) {
+                const float weight = m_wetFrames * FADE_SCALE;
+                for (int ch = 0; ch < channels; ++ch) {
+                    sample[ch] = drySample[ch] + weight * (sample[ch] - drySample[ch]);
                 }
             }
-            
-            buffer[frame] = sample;
+        }
+        if (bypass && m_wetFrames == 0) {
+            enterBypass();
         }
     }
 }
 
-void EqualizerEngine::reset()
+void EqualizerEngine::enterBypass()
+{
+    // Whatever the filters hold would be a stale transient on leaving
+    resetFilterState();
+    m_bypassed = true;
+    m_primeFrames = 0;
+    m_bypassActive.store(true, std::memory_order_relaxed);
+}
+
+void EqualizerEngine::processFloat(Mode mode, float* buffer, int frameCount, int channels)
 {
-    for (int i = 0; i < NUM_BANDS; ++i) {
-        m_filtersLeft[i].reset();
-        m_filtersRight[i].reset();
+    if (mode == Mode::LinearPhase) {
+        m_convolver.process(buffer, frameCount, channels);
+        return;
+    }
+    if (mode == Mode::StateVariable) {
+        m_svf.process(m_runningSvfBands, m_runningSvfCount, buffer, frameCount, channels);
+        retireIdleSvfBands();
+        return;
     }
+    
+    // The subband stage always runs in multirate mode to keep its delay
+    if (mode == Mode::Multirate) {
+        m_subband.process(m_runningSubbands, m_runningSubbandCount, buffer, frameCount, channels);
+    } else if (m_runningCount == 0) {
+        return;
+    }
+    
+    // Band-outer block processing, all channels in parallel lanes
+    if (m_runningCount > 0) {
+        m_filters.process(m_runningBands, m_runningCount, buffer, frameCount, channels);
+    }
+    retireSettledBands(channels);
+}
+
+bool EqualizerEngine::routedToSubband(int band) const
+{
+    return m_activeMode == Mode::Multirate && m_snapshots.readBuffer().subband[band];
+}
+
+void EqualizerEngine::rebuildRunningBands()
+{
+    m_runningCount = 0;
+    m_runningSubbandCount = 0;
+    m_runningSvfCount = 0;
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        if (m_svf.isActive(band)) {
+            m_runningSvfBands[m_runningSvfCount++] = band;
+        }
+        // A band moving between stages starts over from rest in its new one
+        const bool subband = routedToSubband(band);
+        if (subband != m_bandSubband[band]) {
+            m_filters.resetBand(band);
+            m_subband.bank().resetBand(band);
+            m_bandSubband[band] = subband;
+        }
+        if (!m_bandRunning[band]) {
+            continue;
+        }
+        if (subband) {
+            m_runningSubbands[m_runningSubbandCount++] = band;
+        } else {
+            m_runningBands[m_runningCount++] = band;
+        }
+    }
+}
+
+void EqualizerEngine::retireSettledBands(int channels)
+{
+    // A 0 dB band is an exact identity; its TDF-II state only carries the
+    // transient left by its last non-flat setting. Once that is below the
+    // output resolution the band can leave the cascade without a click.
+    constexpr double SETTLED_THRESHOLD = 1e-7;
+    
+    const CoefficientSnapshot& snapshot = m_snapshots.readBuffer();
+    bool changed = false;
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        if (!m_bandRunning[band] || snapshot.active[band]) {
+            continue;
+        }
+        BiquadBank& bank = m_bandSubband[band] ? m_subband.bank() : m_filters;
+        if (bank.isSettled(band, channels, SETTLED_THRESHOLD)) {
+            bank.resetBand(band);
+            m_bandRunning[band] = false;
+            changed = true;
+        }
+    }
+    if (changed) {
+        rebuildRunningBands();
+    }
+}
+
+void EqualizerEngine::retireIdleSvfBands()
+{
+    // No draining needed: a band whose ramp has ended at 0 dB is an exact
+    // identity and its state no longer reaches the output
+    bool changed = false;
+    for (int i = 0; i < m_runningSvfCount; ++i) {
+        const int band = m_runningSvfBands[i];
+        if (!m_svf.isActive(band)) {
+            m_svf.resetBand(band);
+            changed = true;
+        }
+    }
+    if (changed) {
+        rebuildRunningBands();
+    }
+}
+
+void EqualizerEngine::reset()
+{
+    m_resetRequested.store(true, std::memory_order_release);
 }
 
 void EqualizerEngine::updateFilters()
 {
-    for (int i = 0; i < NUM_BANDS; ++i) {
-        double frequency = BAND_FREQUENCIES[i];
-        double gain = m_bandGains[i];
-        double Q = 1.0; // Bandwidth
-        
-        m_filtersLeft[i].setPeakingEQ(frequency, m_sampleRate, gain, Q);
-        m_filtersRight[i].setPeakingEQ(frequency, m_sampleRate, gain, Q);
+    beginUpdate();
+    m_pending.svfRampFrames = static_cast<int>(std::lround(m_sampleRate * GAIN_RAMP_MS / 1000.0));
+    for (int i = 0; i < m_layout.bandCount(); ++i) {
+        updateSvfTuning(i);
+        markBandDirty(i);
+    }
+    commitUpdate();
+}
+
+void EqualizerEngine::updateBand(int band)
+{
+    const double gain = CoefficientTable::quantizeGain(m_bandGains[band]);
+    const BandConfig& config = m_layout.band(band);
+    // Kept below Nyquist for parametric bands
+    const double frequency = qBound(1.0, config.frequency, 0.49 * m_sampleRate);
+    
+    if (m_layout.isGraphic()) {
+        // Table lookup for the supported rates; no trig on the update path
+        m_pending.coefficients[band] = m_coefficientTable.lookup(band, m_sampleRate, gain);
+        m_pending.active[band] = gain != 0.0;
+    } else {
+        // Parametric bands are designed directly
+        m_pending.coefficients[band] = BiquadCoefficients::design(config.type, frequency, m_sampleRate,
+                                                                  gain, config.q);
+        // Shelves and peaks are identities at 0 dB; the pass filters never are
+        m_pending.active[band] = gain != 0.0 || config.type == FilterType::HighPass
+                                 || config.type == FilterType::LowPass;
+    }
+    
+    // Same band at the subband stage's rate, for multirate mode
+    m_pending.subband[band] = isSubbandEligible(config, m_sampleRate);
+    if (m_pending.subband[band]) {
+        const double subbandRate = m_sampleRate / SubbandProcessor::DECIMATION;
+        m_pending.subbandCoefficients[band] = BiquadCoefficients::design(config.type, frequency, subbandRate,
+                                                                         gain, config.q);
+    } else {
+        m_pending.subbandCoefficients[band] = BiquadCoefficients();
+    }
+    
+    // The state-variable filters glide to the exact gain, so it is not
+    // quantized for them
+    m_pending.svf[band].gainDB = m_bandGains[band];
+}
+
+void EqualizerEngine::updateSvfTuning(int band)
+{
+    // Only frequency, Q and the rate need trig; gain changes reuse this
+    const BandConfig& config = m_layout.band(band);
+    const double frequency = qBound(1.0, config.frequency, 0.49 * m_sampleRate);
+    m_pending.svf[band] = SvfParameters::design(config.type, frequency, m_sampleRate, m_bandGains[band],
+                                                config.q);
+}
+
+void EqualizerEngine::publishSnapshot()
+{
+    // Compact the active band list here, once per change, not per block
+    m_pending.activeCount = 0;
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        if (m_pending.active[band]) {
+            m_pending.activeBands[m_pending.activeCount++] = band;
+        }
+    }
+    
+    // Hand a complete copy to the audio thread in one step
+    m_snapshots.writeBuffer() = m_pending;
+    m_snapshots.publish();
+    
+    // The FIR is only redesigned while it is in use
+    m_firDirty = true;
+    if (mode() == Mode::LinearPhase) {
+        updateLinearPhaseFir();
+    }
+}
+
+void EqualizerEngine::updateLinearPhaseFir()
+{
+    // Zero-phase target: the cascade's magnitude response on the FIR's grid
+    for (int bin = 0; bin <= FIR_LENGTH / 2; ++bin) {
+        const double* trig = &m_firTrig[bin * 4];
+        double magnitude = 1.0;
+        for (int i = 0; i < m_pending.activeCount; ++i) {
+            const BiquadCoefficients& c = m_pending.coefficients[m_pending.activeBands[i]];
+            magnitude *= c.magnitude(trig[0], trig[1], trig[2], trig[3]);
+        }
+        m_firSpectrum[bin] = magnitude;
+        if (bin > 0 && bin < FIR_LENGTH / 2) {
+            m_firSpectrum[FIR_LENGTH - bin] = magnitude;
+        }
+    }
+    m_firFft.inverse(m_firSpectrum.data());
+    
+    // Rotate the zero-phase response to be causal around FIR_DELAY and apply
+    // a Hann window to taper the truncated tails
+    for (int n = 0; n < FIR_LENGTH; ++n) {
+        const int source = (n - FIR_DELAY + FIR_LENGTH) % FIR_LENGTH;
+        const double window = 0.5 - 0.5 * std::cos(2.0 * M_PI * n / FIR_LENGTH);
+        m_firTaps[n] = m_firSpectrum[source].real() / FIR_LENGTH * window;
     }
+    m_convolver.setImpulseResponse(m_firTaps.data());
+    m_firDirty = false;
 }
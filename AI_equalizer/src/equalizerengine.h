@@ -1,100 +1,248 @@
 #ifndef EQUALIZERENGINE_H
 #define EQUALIZERENGINE_H
 
-#include <QObject>
 #include <QVector>
+#include <atomic>
 #include <cmath>
+#include <complex>
+#include <vector>
+#include "biquadkernel.h"
+#include "coefficienttable.h"
+#include "eqlayout.h"
+#include "fft.h"
+#include "partitionedconvolver.h"
+#include "subbandprocessor.h"
+#include "svfbank.h"
+#include "triplebuffer.h"
 
-// Biquad filter implementation for each band
-class BiquadFilter {
+/**
+ * @class EqualizerEngine
+ * @brief Graphic or parametric EQ, as a minimum-phase biquad cascade or a
+ *        linear-phase FIR
+ *
+ * The band layout (see EqLayout) is chosen at runtime: 10- or 31-band
+ * graphic, or up to MAX_BANDS parametric bands of any FilterType. All types
+ * share the same biquad kernels. Any interleaved channel count up to
+ * MAX_CHANNELS is processed in one pass, each channel with its own state.
+ *
+ * Threading: the setters run on a control thread, processBuffer() on the
+ * audio thread. The control side builds a complete coefficient snapshot and
+ * publishes it through a lock-free triple buffer; the audio thread picks up
+ * the newest snapshot at the start of each processBuffer() call, so a block
+ * never mixes coefficients from two different updates. All design work
+ * (band coefficients, coefficient tables, the linear-phase FIR) happens on
+ * the control side; the audio thread only swaps pointers. A Command carries
+ * any setter call by value, so other threads can hand them to the control
+ * thread (see EngineControl).
+ * Setter calls between beginUpdate() and commitUpdate() are coalesced: each
+ * touched band is redesigned once and one snapshot is published, however
+ * many calls the batch held.
+ *
+ * Flat bands cost nothing: the snapshot carries a compacted list of bands
+ * with non-zero gain, rebuilt only when gains change. A band that leaves the
+ * list keeps running at 0 dB (an exact identity) until its state has rung
+ * out, and is only then dropped with its state cleared, so re-entering bands
+ * always start from rest instead of from stale state.
+ *
+ * Linear-phase mode applies an FIR whose magnitude matches the cascade, via
+ * partitioned FFT convolution. The FIR is redesigned on the control thread
+ * whenever gains change (only while the mode is active) and costs the same
+ * per sample regardless of band count, at the price of latencyFrames() of
+ * delay.
+ *
+ * Multirate mode is the biquad cascade with the low bands (see
+ * isSubbandEligible()) moved into a SubbandProcessor running at a fraction
+ * of the sample rate, for a small fixed delay. It pays off for layouts with
+ * many low bands, such as the 31-band graphic EQ.
+ *
+ * State-variable mode runs the same bands as TPT state-variable filters
+ * (see SvfBank) and glides each gain change over GAIN_RAMP_MS, per sample,
+ * instead of switching coefficients at a block boundary. It has no added
+ * latency and follows the unquantized gains, so continuously automated
+ * gains come out without zipper noise.
+ *
+ * Bypass passes the input through bit for bit, with no per-sample work and
+ * no added latency. It is entered whenever no band is active (a flat curve)
+ * or while forced by setBypass(); both transitions crossfade over
+ * BYPASS_FADE_FRAMES. Filter state is cleared on entry, so on leaving the
+ * processed path first runs for its own latency (muted) and fades in once it
+ * carries signal.
+ */
+class EqualizerEngine
+{
 public:
-    BiquadFilter() : b0(1.0), b1(0.0), b2(0.0), a1(0.0), a2(0.0),
-                     x1(0.0), x2(0.0), y1(0.0), y2(0.0) {}
-    
-    void setPeakingEQ(double frequency, double sampleRate, double gainDB, double Q = 1.0) {
-        double A = std::pow(10.0, gainDB / 40.0);  // A = sqrt(10^(dB/20)) = 10^(dB/40)
-        double omega = 2.0 * M_PI * frequency / sampleRate;
-        double sn = std::sin(omega);
-        double cs = std::cos(omega);
-        double alpha = sn / (2.0 * Q);
-        
-        // Audio EQ Cookbook peaking EQ with constant 0 dB peak gain
-        double b0_temp = 1.0 + alpha * A;
-        double b1_temp = -2.0 * cs;
-        double b2_temp = 1.0 - alpha * A;
-        double a0_temp = 1.0 + alpha / A;
-        double a1_temp = -2.0 * cs;
-        double a2_temp = 1.0 - alpha / A;
-        
-        // Normalize by a0
-        b0 = b0_temp / a0_temp;
-        b1 = b1_temp / a0_temp;
-        b2 = b2_temp / a0_temp;
-        a1 = a1_temp / a0_temp;
-        a2 = a2_temp / a0_temp;
-    }
-    
-    float process(float input) {
-        // Clamp input to prevent denormal numbers
-        if (std::abs(input) < 1e-15f) input = 0.0f;
-        
-        float output = b0 * input + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
-        
-        // Prevent denormal numbers in state variables
-        if (std::abs(output) < 1e-15f) output = 0.0f;
-        
-        // Clamp output to valid audio range [-10.0, 10.0] to prevent clipping
-        output = std::max(-10.0f, std::min(10.0f, output));
+    EqualizerEngine();
+    EqualizerEngine(const EqualizerEngine&) = delete;
+    EqualizerEngine& operator=(const EqualizerEngine&) = delete;
+    
+    static constexpr int MAX_BANDS = EqLayout::MAX_BANDS;
+    // Interleaved channels per frame, up to 7.1
+    static constexpr int MAX_CHANNELS = BiquadBank::MAX_CHANNELS;
+    
+    enum class Mode {
+        MinimumPhase,  // Biquad cascade, no added latency
+        LinearPhase,   // FIR via partitioned convolution
+        Multirate,     // Biquad cascade, low bands at a reduced rate
+        StateVariable  // SVF cascade, gain changes ramped per sample
+    };
+    
+    // Bypass crossfade length
+    static constexpr int BYPASS_FADE_FRAMES = 256;
+    // State-variable mode: time a gain change takes to complete
+    static constexpr double GAIN_RAMP_MS = 20.0;
+    
+    /**
+     * @brief One setter call, by value, for apply()
+     *
+     * Plain data of fixed size, so it can be posted to EngineControl.
+     * Built with the static functions, named after the setters they stand for.
+     */
+    struct Command {
+        enum class Type { BandGain, AllGains, BandConfig, Layout, Mode, Bypass };
         
-        x2 = x1;
-        x1 = input;
-        y2 = y1;
-        y1 = output;
+        Type type{Type::BandGain};
+        int band{0};   // Band index; for Layout, the entries used in bands
+        int count{0};  // Entries used in gains
+        bool enabled{false};
+        Mode mode{Mode::MinimumPhase};
+        EqLayout::Kind kind{EqLayout::Kind::Graphic10};
+        double gains[MAX_BANDS]{};  // gains[0] for BandGain
+        BandConfig bands[MAX_BANDS]{};  // bands[0] for BandConfig
         
-        return output;
-    }
+        static Command setBandGain(int band, double gainDB);
+        static Command setAllGains(const QVector<double>& gains);
+        static Command setBandConfig(int band, const BandConfig& config);
+        static Command setLayout(const EqLayout& layout, const QVector<double>& gains);
+        static Command setMode(Mode mode);
+        static Command setBypass(bool enabled);
+    };
     
-    void reset() {
-        x1 = x2 = y1 = y2 = 0.0;
-    }
+    // Runs the setter a command stands for; control thread only, like the
+    // setters themselves
+    void apply(const Command& command);
     
-private:
-    double b0, b1, b2, a1, a2;
-    double x1, x2, y1, y2;
-};
-
-class EqualizerEngine : public QObject
-{
-    Q_OBJECT
-
-public:
-    explicit EqualizerEngine(QObject *parent = nullptr);
+    // Defers redesign and publishing until the matching
+    // commitUpdate(); batches nest. Setters outside a batch commit at once.
+    void beginUpdate();
+    void commitUpdate();
     
-    // 10 frequency bands (Hz)
-    static constexpr int NUM_BANDS = 10;
-    static constexpr double BAND_FREQUENCIES[NUM_BANDS] = {
-        31.25, 62.5, 125, 250, 500, 1000, 2000, 4000, 8000, 16000
-    };
+    // Linear-phase FIR length and its group delay
+    static constexpr int FIR_LENGTH = PartitionedConvolver::MAX_TAPS;
+    static constexpr int FIR_DELAY = FIR_LENGTH / 2;
     
     void setSampleRate(double rate);
+    
+    // Gains are taken over if they match the new band count, else flat
+    void setLayout(const EqLayout& layout, const QVector<double>& gains = QVector<double>());
+    EqLayout layout() const;
+    int bandCount() const;
+    // Parametric layouts: retune one band, keeping its gain
+    void setBandConfig(int band, const BandConfig& config);
+    
     void setBandGain(int band, double gainDB);
     double getBandGain(int band) const;
     void setAllGains(const QVector<double>& gains);
     QVector<double> getAllGains() const;
     
+    void setMode(Mode mode);
+    Mode mode() const;
+    // Whether a band can run in the reduced-rate stage of Multirate mode:
+    // its effect must lie well inside the stage's passband
+    static bool isSubbandEligible(const BandConfig& band, double sampleRate);
+    // Forces bypass regardless of the curve
+    void setBypass(bool enabled);
+    bool isBypassForced() const;
+    // Whether the audio thread is in bypass, forced or because the curve is flat
+    bool isBypassed() const;
+    
+    // Latency added by the current mode, in frames (0 in bypass)
+    int latencyFrames() const;
+    
+    // Audio thread only: tells the filters the thread has FTZ/DAZ set, so
+    // they can skip their own denormal handling
+    void setFlushToZero(bool enabled);
+    
+    // Audio thread only; buffers with more than MAX_CHANNELS pass unchanged
     void processBuffer(float* buffer, int frameCount, int channels);
+    // Clears filter state; applied by the audio thread before its next block
     void reset();
     
-signals:
-    void bandGainChanged(int band, double gain);
-    
 private:
+    // Everything the audio thread needs for one block
+    struct CoefficientSnapshot {
+        BiquadCoefficients coefficients[MAX_BANDS];
+        bool active[MAX_BANDS];
+        int activeBands[MAX_BANDS];  // Compacted, ascending band order
+        int activeCount;
+        // Multirate mode: bands run by the subband stage, designed for its rate
+        bool subband[MAX_BANDS];
+        BiquadCoefficients subbandCoefficients[MAX_BANDS];
+        // State-variable mode
+        SvfParameters svf[MAX_BANDS];
+        int svfRampFrames;
+    };
+    
+    // Control thread state
     double m_sampleRate;
+    EqLayout m_layout;
     QVector<double> m_bandGains;
-    QVector<BiquadFilter> m_filtersLeft;
-    QVector<BiquadFilter> m_filtersRight;
+    CoefficientTable m_coefficientTable;  // Graphic layouts only
+    CoefficientSnapshot m_pending{};  // Latest full set, patched per band
+    TripleBuffer<CoefficientSnapshot> m_snapshots;
+    std::atomic_bool m_resetRequested{false};
+    std::atomic<int> m_mode{static_cast<int>(Mode::MinimumPhase)};
+    std::atomic_bool m_bypassForced{false};
+    std::atomic_bool m_bypassActive{false};  // Published by the audio thread
+    // Open update batch: bands to redesign at commit
+    int m_updateDepth{0};
+    bool m_bandDirty[MAX_BANDS]{};
+    bool m_snapshotDirty{false};
+    
+    // Linear-phase FIR design scratch (control thread)
+    bool m_firDirty{true};
+    FftPlan m_firFft;
+    std::vector<double> m_firTrig;  // cos w, sin w, cos 2w, sin 2w per bin
+    std::vector<std::complex<double>> m_firSpectrum;
+    std::vector<double> m_firTaps;
+    
+    // Audio thread state
+    BiquadBank m_filters;
+    bool m_bandRunning[MAX_BANDS]{};
+    int m_runningBands[MAX_BANDS]{};  // Active plus still-draining bands
+    int m_runningCount{0};
+    bool m_bandSubband[MAX_BANDS]{};  // Routing the running lists were built with
+    int m_runningSubbands[MAX_BANDS]{};  // Multirate mode: bands in m_subband
+    int m_runningSubbandCount{0};
+    SubbandProcessor m_subband;
+    SvfBank m_svf;
+    int m_runningSvfBands[MAX_BANDS]{};  // State-variable mode: bands not yet at an identity
+    int m_runningSvfCount{0};
+    Mode m_activeMode{Mode::MinimumPhase};
+    PartitionedConvolver m_convolver;
+    // Bypass (audio thread): weight of the processed signal during a
+    // crossfade, in frames of BYPASS_FADE_FRAMES
+    bool m_bypassed{false};
+    int m_wetFrames{BYPASS_FADE_FRAMES};
+    int m_primeFrames{0};     // Processed frames still muted after leaving bypass
+    std::vector<float> m_dry;  // Unprocessed copy of the block being crossfaded
     
+    void applyGains(const double* gains, int count);
+    Mode beginBlock();
+    void processFloat(Mode mode, float* buffer, int frameCount, int channels);
+    void processCrossfade(Mode mode, bool bypass, float* buffer, int frameCount, int channels);
+    void enterBypass();
+    void resetFilterState();
+    int modeLatencyFrames(Mode mode) const;
     void updateFilters();
+    void markBandDirty(int band);
+    void updateBand(int band);
+    void updateSvfTuning(int band);
+    void publishSnapshot();
+    void updateLinearPhaseFir();
+    void rebuildRunningBands();
+    void retireSettledBands(int channels);
+    void retireIdleSvfBands();
+    bool routedToSubband(int band) const;
 };
 
 #endif // EQUALIZERENGINE_H
@@ -0,0 +1,54 @@
+#include "fft.h"
+#include <cmath>
+#include <utility>
+
+FftPlan::FftPlan(int size)
+    : m_size(size), m_bitReverse(size), m_twiddles(size / 2)
+{
+    int bits = 0;
+    while ((1 << bits) < size) {
+        ++bits;
+    }
+    for (int i = 0; i < size; ++i) {
+        int reversed = 0;
+        for (int b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = reversed;
+    }
+    for (int k = 0; k < size / 2; ++k) {
+        const double phase = -2.0 * M_PI * k / size;
+        m_twiddles[k] = std::complex<double>(std::cos(phase), std::sin(phase));
+    }
+}
+
+void FftPlan::transform(std::complex<double>* data, bool inverse) const
+{
+    for (int i = 0; i < m_size; ++i) {
+        const int j = m_bitReverse[i];
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+
+    // Butterflies written out on re/im: std::complex operator* goes through
+    // the slow NaN-checking path without -ffast-math
+    const double sign = inverse ? -1.0 : 1.0;
+    for (int len = 2; len <= m_size; len <<= 1) {
+        const int half = len / 2;
+        const int stride = m_size / len;
+        for (int start = 0; start < m_size; start += len) {
+            for (int k = 0; k < half; ++k) {
+                const std::complex<double>& w = m_twiddles[k * stride];
+                const double wr = w.real();
+                const double wi = sign * w.imag();
+                std::complex<double>& a = data[start + k];
+                std::complex<double>& b = data[start + k + half];
+                const double br = b.real() * wr - b.imag() * wi;
+                const double bi = b.real() * wi + b.imag() * wr;
+                b = std::complex<double>(a.real() - br, a.imag() - bi);
+                a = std::complex<double>(a.real() + br, a.imag() + bi);
+            }
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <complex>
+#include <vector>
+
+/**
+ * @class FftPlan
+ * @brief In-place iterative radix-2 complex FFT with precomputed tables
+ *
+ * All tables are built in the constructor; transforms never allocate and can
+ * run on the audio thread. The inverse is unscaled (divide by size()).
+ */
+class FftPlan {
+public:
+    explicit FftPlan(int size);  // size must be a power of two
+
+    int size() const { return m_size; }
+    void forward(std::complex<double>* data) const { transform(data, false); }
+    void inverse(std::complex<double>* data) const { transform(data, true); }
+
+private:
+    int m_size;
+    std::vector<int> m_bitReverse;
+    std::vector<std::complex<double>> m_twiddles;  // e^(-2*pi*i*k/size), k < size/2
+
+    void transform(std::complex<double>* data, bool inverse) const;
+};
+
+#endif // FFT_H
@@ -0,0 +1,268 @@
+#include "filebackend.h"
+#include <QDebug>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+constexpr int WAV_HEADER_BYTES = 44;
+constexpr uint16_t WAV_FORMAT_PCM = 1;
+constexpr uint16_t WAV_FORMAT_FLOAT = 3;
+constexpr uint16_t WAV_FORMAT_EXTENSIBLE = 0xFFFE;
+
+uint16_t readU16(const char* p)
+{
+    return static_cast<uint16_t>(static_cast<uint8_t>(p[0]) | (static_cast<uint8_t>(p[1]) << 8));
+}
+
+uint32_t readU32(const char* p)
+{
+    return readU16(p) | (static_cast<uint32_t>(readU16(p + 2)) << 16);
+}
+
+void writeU16(char* p, uint16_t value)
+{
+    p[0] = static_cast<char>(value & 0xFF);
+    p[1] = static_cast<char>(value >> 8);
+}
+
+void writeU32(char* p, uint32_t value)
+{
+    writeU16(p, static_cast<uint16_t>(value & 0xFFFF));
+    writeU16(p + 2, static_cast<uint16_t>(value >> 16));
+}
+
+bool isRawPath(const QString& path)
+{
+    return path.endsWith(".raw", Qt::CaseInsensitive);
+}
+
+} // namespace
+
+FileCapture::FileCapture(const QString& path, const AudioStreamFormat& rawFormat, bool realtime)
+    : m_file(path), m_fileFormat(rawFormat), m_raw(isRawPath(path)), m_realtime(realtime)
+{
+}
+
+FileCapture::~FileCapture()
+{
+    stop();
+}
+
+AudioStreamFormat FileCapture::preferredFormat()
+{
+    if (!m_opened) {
+        m_opened = openFile();
+    }
+    return m_fileFormat;
+}
+
+bool FileCapture::openFile()
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        m_lastError = QString("Cannot open %1: %2").arg(m_file.fileName(), m_file.errorString());
+        return false;
+    }
+    if (m_raw) {
+        m_dataBytes = m_file.size();
+        return true;
+    }
+
+    // RIFF header, then chunks until "data"; "fmt " must come first
+    char riff[12];
+    if (m_file.read(riff, sizeof(riff)) != sizeof(riff) || qstrncmp(riff, "RIFF", 4) != 0
+        || qstrncmp(riff + 8, "WAVE", 4) != 0) {
+        m_lastError = QString("%1 is not a WAV file").arg(m_file.fileName());
+        return false;
+    }
+    bool haveFormat = false;
+    char chunk[8];
+    while (m_file.read(chunk, sizeof(chunk)) == sizeof(chunk)) {
+        const uint32_t size = readU32(chunk + 4);
+        if (qstrncmp(chunk, "data", 4) == 0) {
+            if (!haveFormat) {
+                break;
+            }
+            m_dataBytes = std::min<qint64>(size, m_file.size() - m_file.pos());
+            return true;
+        }
+        if (qstrncmp(chunk, "fmt ", 4) == 0 && size >= 16) {
+            const QByteArray fmt = m_file.read(size);
+            if (fmt.size() < 16) {
+                break;
+            }
+            uint16_t tag = readU16(fmt.constData());
+            if (tag == WAV_FORMAT_EXTENSIBLE && fmt.size() >= 26) {
+                tag = readU16(fmt.constData() + 24);  // First bytes of the subformat GUID
+            }
+            m_fileFormat.channels = readU16(fmt.constData() + 2);
+            m_fileFormat.sampleRate = static_cast<int>(readU32(fmt.constData() + 4));
+            const int bits = readU16(fmt.constData() + 14);
+            if (tag == WAV_FORMAT_FLOAT && bits == 32) {
+                m_fileFormat.format = SampleFormat::Float32;
+            } else if (tag == WAV_FORMAT_PCM && bits == 16) {
+                m_fileFormat.format = SampleFormat::S16;
+            } else if (tag == WAV_FORMAT_PCM && bits == 24) {
+                m_fileFormat.format = SampleFormat::S24;
+            } else if (tag == WAV_FORMAT_PCM && bits == 32) {
+                m_fileFormat.format = SampleFormat::S32;
+            } else {
+                m_lastError = QString("%1: unsupported WAV format %2 (%3 bit)")
+                                  .arg(m_file.fileName()).arg(tag).arg(bits);
+                return false;
+            }
+            haveFormat = true;
+            if (size & 1) {
+                m_file.read(1);  // Chunks are padded to even sizes
+            }
+            continue;
+        }
+        if (!m_file.seek(m_file.pos() + size + (size & 1))) {
+            break;
+        }
+    }
+    m_lastError = QString("%1: no audio data").arg(m_file.fileName());
+    return false;
+}
+
+bool FileCapture::start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback)
+{
+    if (m_readThread) {
+        return true;
+    }
+    if (!m_opened && !(m_opened = openFile())) {
+        return false;
+    }
+    if (format.sampleRate != m_fileFormat.sampleRate || format.channels != m_fileFormat.channels
+        || format.format != m_fileFormat.format) {
+        m_lastError = QString("%1 is %2 Hz, %3 ch, %4; the stream wants %5 Hz, %6 ch, %7")
+                          .arg(m_file.fileName()).arg(m_fileFormat.sampleRate).arg(m_fileFormat.channels)
+                          .arg(sampleFormatName(m_fileFormat.format)).arg(format.sampleRate)
+                          .arg(format.channels).arg(sampleFormatName(format.format));
+        return false;
+    }
+    m_callback = std::move(callback);
+    m_fragmentFrames = fragmentFrames;
+    m_fragment.resize(static_cast<size_t>(fragmentFrames) * format.bytesPerFrame());
+    m_finished.store(false, std::memory_order_relaxed);
+    m_running.store(true, std::memory_order_relaxed);
+    m_readThread = QThread::create([this]{ readLoop(); });
+    m_readThread->start();
+    qDebug() << "File capture started from" << m_file.fileName() << "|" << m_fileFormat.sampleRate << "Hz"
+             << m_fileFormat.channels << "ch" << sampleFormatName(m_fileFormat.format)
+             << (m_realtime ? "| real time" : "| unpaced");
+    return true;
+}
+
+void FileCapture::stop()
+{
+    m_running.store(false, std::memory_order_relaxed);
+    if (m_readThread) {
+        m_readThread->wait();
+        delete m_readThread;
+        m_readThread = nullptr;
+    }
+}
+
+void FileCapture::readLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    const int frameBytes = m_fileFormat.bytesPerFrame();
+    const auto startTime = Clock::now();
+    qint64 framesRead = 0;
+    while (m_running.load(std::memory_order_relaxed) && m_dataBytes >= frameBytes) {
+        const qint64 wanted = std::min<qint64>(m_fragment.size(), m_dataBytes / frameBytes * frameBytes);
+        const qint64 got = m_file.read(m_fragment.data(), wanted);
+        if (got < frameBytes) {
+            break;
+        }
+        const int frames = static_cast<int>(got / frameBytes);
+        m_dataBytes -= got;
+        m_callback(m_fragment.data(), frames);
+        framesRead += frames;
+        if (m_realtime) {
+            std::this_thread::sleep_until(startTime + std::chrono::microseconds(
+                framesRead * 1000000 / m_fileFormat.sampleRate));
+        }
+    }
+    m_finished.store(true, std::memory_order_release);
+    qDebug() << "File capture finished after" << framesRead << "frames";
+}
+
+FileSink::FileSink(const QString& path, SampleFormat format)
+    : m_file(path), m_sampleFormat(format), m_raw(isRawPath(path))
+{
+}
+
+FileSink::~FileSink()
+{
+    close();
+}
+
+AudioStreamFormat FileSink::preferredFormat()
+{
+    AudioStreamFormat format;
+    format.format = m_sampleFormat;
+    return format;
+}
+
+bool FileSink::open(const AudioStreamFormat& format, int bufferMs)
+{
+    Q_UNUSED(bufferMs);
+    if (m_file.isOpen()) {
+        return true;
+    }
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        m_lastError = QString("Cannot create %1: %2").arg(m_file.fileName(), m_file.errorString());
+        return false;
+    }
+    m_format = format;
+    m_dataBytes = 0;
+    if (!m_raw) {
+        // Sizes are patched in by close()
+        char header[WAV_HEADER_BYTES] = {};
+        m_file.write(header, sizeof(header));
+    }
+    qDebug() << "Writing" << m_file.fileName() << "|" << format.sampleRate << "Hz" << format.channels << "ch"
+             << sampleFormatName(format.format);
+    return true;
+}
+
+bool FileSink::write(const void* frames, int frameCount)
+{
+    const qint64 bytes = static_cast<qint64>(frameCount) * m_format.bytesPerFrame();
+    if (m_file.write(static_cast<const char*>(frames), bytes) != bytes) {
+        m_lastError = QString("Write to %1 failed: %2").arg(m_file.fileName(), m_file.errorString());
+        return false;
+    }
+    m_dataBytes += bytes;
+    return true;
+}
+
+void FileSink::close()
+{
+    if (!m_file.isOpen()) {
+        return;
+    }
+    if (!m_raw) {
+        const int sampleBytes = bytesPerSample(m_format.format);
+        char header[WAV_HEADER_BYTES];
+        std::memcpy(header, "RIFF", 4);
+        writeU32(header + 4, static_cast<uint32_t>(WAV_HEADER_BYTES - 8 + m_dataBytes));
+        std::memcpy(header + 8, "WAVEfmt ", 8);
+        writeU32(header + 16, 16);
+        writeU16(header + 20, m_format.format == SampleFormat::Float32 ? WAV_FORMAT_FLOAT : WAV_FORMAT_PCM);
+        writeU16(header + 22, static_cast<uint16_t>(m_format.channels));
+        writeU32(header + 24, static_cast<uint32_t>(m_format.sampleRate));
+        writeU32(header + 28, static_cast<uint32_t>(m_format.sampleRate * m_format.bytesPerFrame()));
+        writeU16(header + 32, static_cast<uint16_t>(m_format.bytesPerFrame()));
+        writeU16(header + 34, static_cast<uint16_t>(sampleBytes * 8));
+        std::memcpy(header + 36, "data", 4);
+        writeU32(header + 40, static_cast<uint32_t>(m_dataBytes));
+        m_file.seek(0);
+        m_file.write(header, sizeof(header));
+    }
+    m_file.close();
+    qDebug() << "Closed" << m_file.fileName() << "|" << m_dataBytes / m_format.bytesPerFrame() << "frames";
+}
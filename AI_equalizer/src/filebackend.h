@@ -0,0 +1,82 @@
+#ifndef FILEBACKEND_H
+#define FILEBACKEND_H
+
+#include <QFile>
+#include <QThread>
+#include <atomic>
+#include <vector>
+#include "audiobackend.h"
+
+/**
+ * @class FileCapture
+ * @brief Reads a WAV or headerless (".raw") file as the capture stream
+ *
+ * WAV files supply their own rate, channel count and format (16/24/32-bit
+ * PCM or 32-bit float); raw files are described by the format passed in.
+ * Either way the stream must use that format. Frames are delivered as fast
+ * as the callback takes them, or at the file's rate with realtime set;
+ * isFinished() turns true at the end of the data.
+ */
+class FileCapture : public AudioCaptureBackend {
+public:
+    FileCapture(const QString& path, const AudioStreamFormat& rawFormat, bool realtime);
+    ~FileCapture() override;
+
+    const char* name() const override { return "file"; }
+    AudioStreamFormat preferredFormat() override;
+    bool requiresPreferredFormat() const override { return true; }
+    bool isRealtime() const override { return m_realtime; }
+
+    bool start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback) override;
+    void stop() override;
+    bool isFinished() const override { return m_finished.load(std::memory_order_acquire); }
+
+private:
+    QFile m_file;
+    AudioStreamFormat m_fileFormat;
+    bool m_raw;
+    bool m_realtime;
+    bool m_opened{false};
+    qint64 m_dataBytes{0};  // Audio data left to read
+    QThread* m_readThread{nullptr};
+    FrameCallback m_callback;
+    int m_fragmentFrames{0};
+    std::vector<char> m_fragment;
+    std::atomic_bool m_running{false};
+    std::atomic_bool m_finished{false};
+
+    bool openFile();
+    void readLoop();
+};
+
+/**
+ * @class FileSink
+ * @brief Writes the processed stream to a WAV or headerless (".raw") file
+ *
+ * Takes any rate and channel count; samples are stored in the format given
+ * at construction. The WAV header's sizes are filled in by close().
+ */
+class FileSink : public AudioSinkBackend {
+public:
+    FileSink(const QString& path, SampleFormat format);
+    ~FileSink() override;
+
+    const char* name() const override { return "file"; }
+    AudioStreamFormat preferredFormat() override;
+    bool requiresPreferredFormat() const override { return true; }
+    bool isRealtime() const override { return false; }
+
+    bool open(const AudioStreamFormat& format, int bufferMs) override;
+    bool write(const void* frames, int frameCount) override;
+    int64_t bufferedUsec() override { return 0; }
+    void close() override;
+
+private:
+    QFile m_file;
+    SampleFormat m_sampleFormat;
+    bool m_raw;
+    AudioStreamFormat m_format;
+    qint64 m_dataBytes{0};
+};
+
+#endif // FILEBACKEND_H
@@ -0,0 +1,31 @@
+#include "jitterbuffer.h"
+#include <algorithm>
+
+void JitterBuffer::configure(int minFrames, int maxFrames, int sampleRate)
+{
+    m_min = std::max(minFrames, 1);
+    m_max = std::max(maxFrames, m_min);
+    m_target = m_min;
+    m_stableLimit = static_cast<int>(STABLE_SECONDS * sampleRate);
+    m_stableFrames = 0;
+    m_underruns = 0;
+}
+
+void JitterBuffer::onUnderrun()
+{
+    ++m_underruns;
+    m_stableFrames = 0;
+    m_target = std::min(m_max, m_target + std::max(m_target / 2, 1));
+}
+
+void JitterBuffer::onFramesPlayed(int frames)
+{
+    if (m_target <= m_min) {
+        return;
+    }
+    m_stableFrames += frames;
+    if (m_stableFrames >= m_stableLimit) {
+        m_stableFrames = 0;
+        m_target = std::max(m_min, m_target - std::max(m_target / 8, 1));
+    }
+}
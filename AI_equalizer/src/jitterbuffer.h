@@ -0,0 +1,46 @@
+#ifndef JITTERBUFFER_H
+#define JITTERBUFFER_H
+
+/**
+ * @class JitterBuffer
+ * @brief Adaptive fill target for the capture → playback queue
+ *
+ * Holds how many frames the writer keeps queued ahead of playback. The
+ * target starts at the configured minimum; every underrun grows it by half
+ * (up to the maximum), and after STABLE_SECONDS of playback without one it
+ * shrinks by an eighth back toward the minimum. A fixed buffer is the same
+ * thing with minimum == maximum.
+ *
+ * The writer trims the queue back to the target once it holds more than
+ * trimThresholdFrames(), so latency that builds up (e.g. after a stall)
+ * does not persist.
+ *
+ * Used by the writer thread only.
+ */
+class JitterBuffer {
+public:
+    static constexpr double STABLE_SECONDS = 5.0;
+
+    void configure(int minFrames, int maxFrames, int sampleRate);
+
+    int targetFrames() const { return m_target; }
+    int minFrames() const { return m_min; }
+    int maxFrames() const { return m_max; }
+    bool isAdaptive() const { return m_max > m_min; }
+    int trimThresholdFrames() const { return 2 * m_target; }
+
+    void onUnderrun();
+    void onFramesPlayed(int frames);
+
+    int underruns() const { return m_underruns; }
+
+private:
+    int m_min{0};
+    int m_max{0};
+    int m_target{0};
+    int m_stableLimit{0};  // STABLE_SECONDS in frames
+    int m_stableFrames{0};
+    int m_underruns{0};
+};
+
+#endif // JITTERBUFFER_H
@@ -0,0 +1,65 @@
+#include "levelmeter.h"
+#include <algorithm>
+#include <cmath>
+
+LevelMeter::LevelMeter()
+{
+    reset();
+}
+
+void LevelMeter::setSampleRate(int rate)
+{
+    if (rate > 0) {
+        m_sampleRate = rate;
+    }
+}
+
+void LevelMeter::reset()
+{
+    std::fill(m_peak, m_peak + MAX_CHANNELS, 0.0);
+    std::fill(m_meanSquare, m_meanSquare + MAX_CHANNELS, 0.0);
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+        m_peakOut[ch].store(0.0f, std::memory_order_relaxed);
+        m_rmsOut[ch].store(0.0f, std::memory_order_relaxed);
+    }
+    m_channels.store(0, std::memory_order_relaxed);
+}
+
+void LevelMeter::process(const float* samples, int frameCount, int channels)
+{
+    if (frameCount <= 0 || channels <= 0 || channels > MAX_CHANNELS) {
+        return;
+    }
+    float blockPeak[MAX_CHANNELS]{};
+    double blockSum[MAX_CHANNELS]{};
+    for (int frame = 0; frame < frameCount; ++frame) {
+        const float* x = samples + frame * channels;
+        for (int ch = 0; ch < channels; ++ch) {
+            blockPeak[ch] = std::max(blockPeak[ch], std::abs(x[ch]));
+            blockSum[ch] += static_cast<double>(x[ch]) * x[ch];
+        }
+    }
+
+    // Both time constants are applied once per block
+    const double frames = frameCount;
+    const double release = std::exp(-frames * 1000.0 / (m_sampleRate * PEAK_RELEASE_MS));
+    const double smoothing = std::exp(-frames * 1000.0 / (m_sampleRate * RMS_WINDOW_MS));
+    for (int ch = 0; ch < channels; ++ch) {
+        m_peak[ch] = std::max<double>(blockPeak[ch], m_peak[ch] * release);
+        m_meanSquare[ch] = m_meanSquare[ch] * smoothing + (blockSum[ch] / frames) * (1.0 - smoothing);
+        m_peakOut[ch].store(static_cast<float>(m_peak[ch]), std::memory_order_relaxed);
+        m_rmsOut[ch].store(static_cast<float>(std::sqrt(m_meanSquare[ch])), std::memory_order_relaxed);
+    }
+    m_channels.store(channels, std::memory_order_relaxed);
+}
+
+LevelMeter::Levels LevelMeter::levels() const
+{
+    Levels levels;
+    levels.channels = m_channels.load(std::memory_order_relaxed);
+    for (int ch = 0; ch < levels.channels; ++ch) {
+        levels.peak[ch] = m_peakOut[ch].load(std::memory_order_relaxed);
+        levels.rms[ch] = m_rmsOut[ch].load(std::memory_order_relaxed);
+    }
+    return levels;
+}
@@ -0,0 +1,52 @@
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include "biquadkernel.h"
+#include <atomic>
+
+/**
+ * @class LevelMeter
+ * @brief Peak and RMS levels of the EQ output, per channel
+ *
+ * The audio thread feeds it every processed block; any thread may read the
+ * latest levels at any time without locking. Levels are linear (1.0 = full
+ * scale). The peak jumps up at once and falls back over PEAK_RELEASE_MS;
+ * the RMS is averaged over RMS_WINDOW_MS. Both are updated per block, so a
+ * reader that samples less often still sees every peak.
+ */
+class LevelMeter {
+public:
+    static constexpr int MAX_CHANNELS = BiquadBank::MAX_CHANNELS;
+    static constexpr double PEAK_RELEASE_MS = 300.0;
+    static constexpr double RMS_WINDOW_MS = 300.0;
+
+    struct Levels {
+        int channels{0};
+        float peak[MAX_CHANNELS]{};
+        float rms[MAX_CHANNELS]{};
+    };
+
+    LevelMeter();
+
+    // While the audio thread is not feeding the meter
+    void setSampleRate(int rate);
+    void reset();
+
+    // Audio thread: measures interleaved float frames
+    void process(const float* samples, int frameCount, int channels);
+
+    // Any thread
+    Levels levels() const;
+
+private:
+    double m_sampleRate{48000.0};
+    // Audio thread
+    double m_peak[MAX_CHANNELS]{};
+    double m_meanSquare[MAX_CHANNELS]{};
+    // Published copies
+    std::atomic<int> m_channels{0};
+    std::atomic<float> m_peakOut[MAX_CHANNELS];
+    std::atomic<float> m_rmsOut[MAX_CHANNELS];
+};
+
+#endif // LEVELMETER_H
@@ -1,16 +1,54 @@
 #include "EqualizerMainWindow.h"
+#include "EqualizerViewModel.h"
+#include "AudioController.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QDebug>
+#include <cstring>
+
+// Runs the audio pipeline without a window until the input ends, with the
+// backends chosen by AI_EQ_CAPTURE/AI_EQ_SINK (e.g. a WAV file rendered
+// through the EQ into another WAV file, faster than real time)
+static int runHeadless(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    EqualizerViewModel model;
+    if (argc > 2 && !model.setBandGainsJson(QString::fromLocal8Bit(argv[2]))) {
+        qCritical() << "Invalid band gains:" << argv[2];
+        return 2;
+    }
+
+    AudioController audio(&model);
+    int status = 0;
+    QObject::connect(&audio, &AudioController::errorOccurred, &app, [&status](const QString& error) {
+        qCritical() << "Audio error:" << error;
+        status = 1;
+    });
+    QObject::connect(&audio, &AudioController::audioStopped, &app, &QCoreApplication::quit);
+    audio.startAudio();
+    if (!audio.isRunning()) {
+        return 1;
+    }
+    app.exec();
+    return status;
+}
 
 int main(int argc, char *argv[])
 {
+    // AI_equalizer --headless ['[gain0, gain1, ...]']
+    if (argc > 1 && std::strcmp(argv[1], "--headless") == 0) {
+        return runHeadless(argc, argv);
+    }
+
     QApplication app(argc, argv);
-    
+
     app.setApplicationName("AI Equalizer");
     app.setApplicationVersion("1.0.0");
     app.setOrganizationName("AudioTools");
-    
+
     EqualizerMainWindow window;
     window.show();
-    
+
     return app.exec();
 }
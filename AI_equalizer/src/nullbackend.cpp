@@ -0,0 +1,144 @@
+#include "nullbackend.h"
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+GeneratorCapture::GeneratorCapture(Waveform waveform, double frequency, double durationSeconds, bool realtime)
+    : m_waveform(waveform), m_frequency(frequency), m_durationSeconds(durationSeconds), m_realtime(realtime)
+{
+}
+
+GeneratorCapture::~GeneratorCapture()
+{
+    stop();
+}
+
+bool GeneratorCapture::start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback)
+{
+    if (m_thread) {
+        return true;
+    }
+    m_format = format;
+    m_fragmentFrames = fragmentFrames;
+    m_callback = std::move(callback);
+    m_samples.assign(static_cast<size_t>(fragmentFrames) * format.channels, 0.0f);
+    m_fragment.assign(static_cast<size_t>(fragmentFrames) * format.bytesPerFrame(), 0);
+    m_finished.store(false, std::memory_order_relaxed);
+    m_running.store(true, std::memory_order_relaxed);
+    m_thread = QThread::create([this]{ generateLoop(); });
+    m_thread->start();
+    qDebug() << "Generator capture started |" << format.sampleRate << "Hz" << format.channels << "ch"
+             << (m_realtime ? "| real time" : "| unpaced");
+    return true;
+}
+
+void GeneratorCapture::stop()
+{
+    m_running.store(false, std::memory_order_relaxed);
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+void GeneratorCapture::generateLoop()
+{
+    using Clock = std::chrono::steady_clock;
+    const int channels = m_format.channels;
+    const int64_t totalFrames = m_durationSeconds > 0.0
+        ? static_cast<int64_t>(m_durationSeconds * m_format.sampleRate) : -1;
+    const double phaseStep = 2.0 * M_PI * m_frequency / m_format.sampleRate;
+    uint32_t noise = 0x12345678u;  // xorshift32 state
+    const auto startTime = Clock::now();
+    int64_t frame = 0;
+    while (m_running.load(std::memory_order_relaxed) && (totalFrames < 0 || frame < totalFrames)) {
+        const int frames = totalFrames < 0 ? m_fragmentFrames
+                                           : static_cast<int>(std::min<int64_t>(m_fragmentFrames, totalFrames - frame));
+        for (int i = 0; i < frames; ++i) {
+            float value = 0.0f;
+            if (m_waveform == Waveform::Sine) {
+                // Phase from the absolute frame index, so it never drifts
+                value = static_cast<float>(AMPLITUDE * std::sin(phaseStep * static_cast<double>(frame + i)));
+            } else if (m_waveform == Waveform::Noise) {
+                noise ^= noise << 13;
+                noise ^= noise >> 17;
+                noise ^= noise << 5;
+                value = static_cast<float>(AMPLITUDE * (noise / 2147483648.0 - 1.0));
+            }
+            for (int ch = 0; ch < channels; ++ch) {
+                m_samples[i * channels + ch] = value;
+            }
+        }
+        convertSamples(m_samples.data(), m_fragment.data(), m_format.format, frames * channels);
+        m_callback(m_fragment.data(), frames);
+        frame += frames;
+        if (m_realtime) {
+            std::this_thread::sleep_until(startTime + std::chrono::microseconds(
+                frame * 1000000 / m_format.sampleRate));
+        }
+    }
+    m_finished.store(true, std::memory_order_release);
+}
+
+NullSink::NullSink(bool realtime)
+    : m_realtime(realtime)
+{
+}
+
+bool NullSink::open(const AudioStreamFormat& format, int bufferMs)
+{
+    m_format = format;
+    m_buffer = std::chrono::milliseconds(bufferMs);
+    m_framesWritten = 0;
+    m_startTime = Clock::now();
+    m_open = true;
+    return true;
+}
+
+std::chrono::microseconds NullSink::writtenDuration() const
+{
+    return std::chrono::microseconds(m_framesWritten * 1000000 / m_format.sampleRate);
+}
+
+bool NullSink::write(const void* frames, int frameCount)
+{
+    Q_UNUSED(frames);
+    if (m_realtime) {
+        restartIfDrained();
+    }
+    m_framesWritten += frameCount;
+    if (m_realtime) {
+        // Block while more than the device buffer is ahead of the clock
+        std::this_thread::sleep_until(m_startTime + writtenDuration() - m_buffer);
+    }
+    return true;
+}
+
+int64_t NullSink::bufferedUsec()
+{
+    if (!m_realtime) {
+        return 0;
+    }
+    restartIfDrained();
+    const auto played = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - m_startTime);
+    return std::max<int64_t>(0, (writtenDuration() - played).count());
+}
+
+void NullSink::restartIfDrained()
+{
+    // An emulated device that ran dry resumes from now, like a real one
+    const auto now = Clock::now();
+    if (now - m_startTime > writtenDuration()) {
+        m_startTime = now - writtenDuration();
+    }
+}
+
+void NullSink::close()
+{
+    if (m_open) {
+        qDebug() << "Null sink discarded" << m_framesWritten << "frames";
+        m_open = false;
+    }
+}
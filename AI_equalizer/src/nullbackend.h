@@ -0,0 +1,86 @@
+#ifndef NULLBACKEND_H
+#define NULLBACKEND_H
+
+#include <QThread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include "audiobackend.h"
+
+/**
+ * @class GeneratorCapture
+ * @brief Synthetic capture stream: silence, a sine or white noise
+ *
+ * Produces frames in whatever format the stream asks for, as fast as the
+ * callback takes them (or paced at the sample rate with realtime set), for
+ * durationSeconds or without end if that is 0. Noise comes from a fixed
+ * seed, so every run produces the same samples.
+ */
+class GeneratorCapture : public AudioCaptureBackend {
+public:
+    enum class Waveform { Silence, Sine, Noise };
+
+    static constexpr double AMPLITUDE = 0.5;  // -6 dBFS
+
+    GeneratorCapture(Waveform waveform, double frequency, double durationSeconds, bool realtime);
+    ~GeneratorCapture() override;
+
+    const char* name() const override { return "generator"; }
+    bool isRealtime() const override { return m_realtime; }
+
+    bool start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback) override;
+    void stop() override;
+    bool isFinished() const override { return m_finished.load(std::memory_order_acquire); }
+
+private:
+    Waveform m_waveform;
+    double m_frequency;
+    double m_durationSeconds;
+    bool m_realtime;
+    AudioStreamFormat m_format;
+    int m_fragmentFrames{0};
+    FrameCallback m_callback;
+    std::vector<float> m_samples;
+    std::vector<uint8_t> m_fragment;  // m_samples in the stream's format
+    QThread* m_thread{nullptr};
+    std::atomic_bool m_running{false};
+    std::atomic_bool m_finished{false};
+
+    void generateLoop();
+};
+
+/**
+ * @class NullSink
+ * @brief Discards the processed stream, counting what it was given
+ *
+ * Unpaced by default, so the pipeline runs as fast as the CPU allows. With
+ * realtime set it emulates a device: writes are accepted up to bufferMs
+ * ahead of a clock running at the sample rate, and block beyond that.
+ */
+class NullSink : public AudioSinkBackend {
+public:
+    explicit NullSink(bool realtime);
+
+    const char* name() const override { return "null"; }
+    bool isRealtime() const override { return m_realtime; }
+
+    bool open(const AudioStreamFormat& format, int bufferMs) override;
+    bool write(const void* frames, int frameCount) override;
+    int64_t bufferedUsec() override;
+    void close() override;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    bool m_realtime;
+    bool m_open{false};
+    AudioStreamFormat m_format;
+    std::chrono::microseconds m_buffer{0};
+    Clock::time_point m_startTime;
+    int64_t m_framesWritten{0};
+
+    std::chrono::microseconds writtenDuration() const;
+    void restartIfDrained();
+};
+
+#endif // NULLBACKEND_H
@@ -0,0 +1,113 @@
+#include "pareccapture.h"
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+
+ParecCapture::ParecCapture(const QString& sourceName)
+    : m_sourceName(sourceName)
+{
+}
+
+ParecCapture::~ParecCapture()
+{
+    stop();
+}
+
+bool ParecCapture::start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback)
+{
+    if (m_process) {
+        return true;
+    }
+    qDebug() << "\nLaunching parec capture process...";
+    qDebug() << "Monitor source:" << m_sourceName;
+    
+    m_lastError.clear();
+    m_callback = std::move(callback);
+    m_frameBytes = format.bytesPerFrame();
+    m_fragmentMs = fragmentFrames * 1000.0 / format.sampleRate;
+    m_readBuffer.assign(static_cast<size_t>(std::max(fragmentFrames, 1)) * READ_FRAGMENTS * m_frameBytes, 0);
+    m_finished.store(false, std::memory_order_relaxed);
+    m_process = new QProcess();
+    
+    // Build parec command arguments
+    QStringList args;
+    args << QString("--device=%1").arg(m_sourceName)
+         << QString("--format=%1").arg(sampleFormatName(format.format))
+         << QString("--rate=%1").arg(format.sampleRate)
+         << QString("--channels=%1").arg(format.channels);
+    
+    qDebug() << "Command: parec" << args.join(" ");
+    
+    // Not waited for: the reader sees the process come up, or reports why
+    // it did not through isFinished()/lastError()
+    m_process->start("parec", args);
+    m_startTimer.start();
+    
+    qDebug() << "parec process launched";
+    m_running.store(true, std::memory_order_relaxed);
+    m_readThread = QThread::create([this]{ readLoop(); });
+    m_readThread->start();
+    return true;
+}
+
+void ParecCapture::stop()
+{
+    if (!m_process) {
+        return;
+    }
+    m_running.store(false, std::memory_order_relaxed);
+    if (m_readThread) {
+        m_readThread->wait();
+        delete m_readThread;
+        m_readThread = nullptr;
+    }
+    
+    // parec has nothing to flush: SIGKILL ends it at once, where waiting
+    // for a SIGTERM could stall the caller
+    m_process->kill();
+    m_process->waitForFinished();
+    qDebug() << "parec process terminated";
+    delete m_process;
+    m_process = nullptr;
+}
+
+void ParecCapture::readLoop()
+{
+    qDebug() << "Read thread started";
+    // Reads land in one preallocated buffer; a frame split across reads
+    // stays at its front for the next one
+    char* buffer = m_readBuffer.data();
+    const qint64 capacity = static_cast<qint64>(m_readBuffer.size());
+    qint64 pending = 0;
+    while (m_running.load(std::memory_order_relaxed)) {
+        const QProcess::ProcessState state = m_process->state();
+        if (state == QProcess::Starting && m_startTimer.elapsed() < STARTUP_TIMEOUT_MS) {
+            QThread::msleep(5);
+            continue;
+        }
+        if (state != QProcess::Running) {
+            const QByteArray stderr = m_process->readAllStandardError();
+            m_lastError = stderr.isEmpty()
+                ? QString("parec did not start: %1 (is pulseaudio-utils installed?)").arg(m_process->errorString())
+                : QString("parec exited: %1").arg(QString::fromUtf8(stderr).trimmed());
+            qWarning() << m_lastError;
+            m_finished.store(true, std::memory_order_release);  // Publishes m_lastError
+            break;
+        }
+        const qint64 got = m_process->read(buffer + pending, capacity - pending);
+        if (got <= 0) {
+            QThread::msleep(5);
+            continue;
+        }
+        const qint64 bytes = pending + got;
+        const int frameCount = static_cast<int>(bytes / m_frameBytes);
+        if (frameCount > 0) {
+            m_callback(buffer, frameCount);
+        }
+        pending = bytes - static_cast<qint64>(frameCount) * m_frameBytes;
+        if (pending > 0) {
+            std::memmove(buffer, buffer + bytes - pending, static_cast<size_t>(pending));
+        }
+    }
+    qDebug() << "Read thread exiting";
+}
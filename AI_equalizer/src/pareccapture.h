@@ -0,0 +1,50 @@
+#ifndef PARECCAPTURE_H
+#define PARECCAPTURE_H
+
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QThread>
+#include <atomic>
+#include <vector>
+#include "audiobackend.h"
+
+/**
+ * @class ParecCapture
+ * @brief Capture through a 'parec' subprocess, read by a polling thread
+ *
+ * Fallback for setups where PulseCapture cannot open its record stream.
+ * parec writes raw frames to a pipe; the reader thread hands whole frames to
+ * the callback and reports the process failing to start or exiting through
+ * isFinished(). start() and stop() return without waiting on the process.
+ */
+class ParecCapture : public AudioCaptureBackend {
+public:
+    static constexpr int STARTUP_TIMEOUT_MS = 2000; // Before a launch that never ran counts as failed
+    static constexpr int READ_FRAGMENTS = 4;        // Read buffer size, in capture fragments
+
+    explicit ParecCapture(const QString& sourceName);
+    ~ParecCapture() override;
+
+    const char* name() const override { return "parec"; }
+    bool start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback) override;
+    void stop() override;
+    bool isFinished() const override { return m_finished.load(std::memory_order_acquire); }
+    // The pipe's buffering is not visible; one nominal fragment
+    double latencyMs() override { return m_fragmentMs; }
+
+private:
+    QString m_sourceName;
+    QProcess* m_process{nullptr};
+    QThread* m_readThread{nullptr};
+    QElapsedTimer m_startTimer;
+    FrameCallback m_callback;
+    int m_frameBytes{0};
+    std::vector<char> m_readBuffer;  // Allocated by start(); reused by every read
+    double m_fragmentMs{0.0};
+    std::atomic_bool m_running{false};
+    std::atomic_bool m_finished{false};
+
+    void readLoop();
+};
+
+#endif // PARECCAPTURE_H
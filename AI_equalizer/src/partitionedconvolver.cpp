@@ -0,0 +1,124 @@
+#include "partitionedconvolver.h"
+#include <algorithm>
+
+PartitionedConvolver::PartitionedConvolver()
+    : m_fft(FFT_SIZE),
+      m_spectra(Spectra{std::vector<Complex>(NUM_PARTITIONS * FFT_SIZE)}),
+      m_designWork(FFT_SIZE),
+      m_fdl(MAX_PAIRS * NUM_PARTITIONS * FFT_SIZE),
+      m_overlap(MAX_PAIRS * PARTITION_FRAMES),
+      m_input(MAX_PAIRS * PARTITION_FRAMES),
+      m_output(MAX_PAIRS * PARTITION_FRAMES),
+      m_accum(FFT_SIZE)
+{
+}
+
+void PartitionedConvolver::setImpulseResponse(const double* taps)
+{
+    Spectra& spectra = m_spectra.writeBuffer();
+    for (int part = 0; part < NUM_PARTITIONS; ++part) {
+        // Partition zero-padded to the FFT size for overlap-save
+        const double* partTaps = taps + part * PARTITION_FRAMES;
+        for (int n = 0; n < PARTITION_FRAMES; ++n) {
+            m_designWork[n] = Complex(partTaps[n], 0.0);
+            m_designWork[n + PARTITION_FRAMES] = Complex(0.0, 0.0);
+        }
+        m_fft.forward(m_designWork.data());
+        std::copy(m_designWork.begin(), m_designWork.end(),
+                  spectra.bins.begin() + part * FFT_SIZE);
+    }
+    m_spectra.publish();
+}
+
+void PartitionedConvolver::reset()
+{
+    std::fill(m_fdl.begin(), m_fdl.end(), Complex());
+    std::fill(m_overlap.begin(), m_overlap.end(), Complex());
+    std::fill(m_input.begin(), m_input.end(), Complex());
+    std::fill(m_output.begin(), m_output.end(), Complex());
+    m_position = 0;
+    m_fdlHead = 0;
+}
+
+void PartitionedConvolver::process(float* buffer, int frameCount, int channels)
+{
+    if (channels <= 0 || channels > MAX_CHANNELS) {
+        return;
+    }
+    const int pairs = (channels + 1) / 2;
+
+    for (int frame = 0; frame < frameCount; ++frame) {
+        float* sample = buffer + frame * channels;
+        for (int pair = 0; pair < pairs; ++pair) {
+            const int ch = pair * 2;
+            const bool hasSecond = ch + 1 < channels;
+            const int index = pair * PARTITION_FRAMES + m_position;
+
+            m_input[index] = Complex(sample[ch], hasSecond ? sample[ch + 1] : 0.0f);
+            const Complex out = m_output[index];
+            sample[ch] = static_cast<float>(out.real());
+            if (hasSecond) {
+                sample[ch + 1] = static_cast<float>(out.imag());
+            }
+        }
+        if (++m_position == PARTITION_FRAMES) {
+            runPartition(pairs);
+            m_position = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::runPartition(int pairs)
+{
+    constexpr double scale = 1.0 / FFT_SIZE;
+
+    // Transform [previous block | current block] into the newest FDL slot
+    for (int pair = 0; pair < pairs; ++pair) {
+        Complex* slot = &m_fdl[(pair * NUM_PARTITIONS + m_fdlHead) * FFT_SIZE];
+        Complex* overlap = &m_overlap[pair * PARTITION_FRAMES];
+        const Complex* input = &m_input[pair * PARTITION_FRAMES];
+        std::copy(overlap, overlap + PARTITION_FRAMES, slot);
+        std::copy(input, input + PARTITION_FRAMES, slot + PARTITION_FRAMES);
+        std::copy(input, input + PARTITION_FRAMES, overlap);
+        m_fft.forward(slot);
+    }
+
+    for (int pair = 0; pair < pairs; ++pair) {
+        convolve(m_spectra.readBuffer(), pair, m_accum.data());
+        Complex* output = &m_output[pair * PARTITION_FRAMES];
+        for (int n = 0; n < PARTITION_FRAMES; ++n) {
+            output[n] = m_accum[PARTITION_FRAMES + n] * scale;
+        }
+    }
+
+    // New response: run this block through it as well and crossfade
+    if (m_spectra.update()) {
+        for (int pair = 0; pair < pairs; ++pair) {
+            convolve(m_spectra.readBuffer(), pair, m_accum.data());
+            Complex* output = &m_output[pair * PARTITION_FRAMES];
+            for (int n = 0; n < PARTITION_FRAMES; ++n) {
+                const double fade = (n + 1.0) / PARTITION_FRAMES;
+                output[n] = output[n] * (1.0 - fade) + m_accum[PARTITION_FRAMES + n] * (scale * fade);
+            }
+        }
+    }
+
+    m_fdlHead = (m_fdlHead + 1) % NUM_PARTITIONS;
+}
+
+void PartitionedConvolver::convolve(const Spectra& spectra, int pair, Complex* out)
+{
+    std::fill(out, out + FFT_SIZE, Complex());
+    for (int part = 0; part < NUM_PARTITIONS; ++part) {
+        const int slot = (m_fdlHead - part + NUM_PARTITIONS) % NUM_PARTITIONS;
+        const Complex* x = &m_fdl[(pair * NUM_PARTITIONS + slot) * FFT_SIZE];
+        const Complex* h = &spectra.bins[part * FFT_SIZE];
+        // Complex multiply-accumulate on re/im, see FftPlan::transform
+        for (int bin = 0; bin < FFT_SIZE; ++bin) {
+            const double re = x[bin].real() * h[bin].real() - x[bin].imag() * h[bin].imag();
+            const double im = x[bin].real() * h[bin].imag() + x[bin].imag() * h[bin].real();
+            out[bin] = Complex(out[bin].real() + re, out[bin].imag() + im);
+        }
+    }
+    m_fft.inverse(out);
+}
@@ -0,0 +1,238 @@
+#include "pulsecapture.h"
+#include "pareccapture.h"
+#include "pulsedevices.h"
+#include <QDebug>
+
+PulseCapture::PulseCapture(const QString& sourceName)
+    : m_sourceName(sourceName.toUtf8())
+{
+}
+
+PulseCapture::~PulseCapture()
+{
+    stop();
+}
+
+AudioStreamFormat PulseCapture::preferredFormat()
+{
+    AudioStreamFormat format;
+    PulseDeviceSpec source;
+    PulseDeviceSpec sink;
+    QString error;
+    if (!PulseDevices::query(m_sourceName.constData(), nullptr, &source, &sink, &error)) {
+        qWarning() << "PulseCapture:" << error;
+    } else if (source.found) {
+        format.sampleRate = source.sampleRate;
+        format.format = source.format;
+    }
+    return format;
+}
+
+bool PulseCapture::start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback)
+{
+    if (m_mainloop) {
+        return true;
+    }
+    const char* sourceName = m_sourceName.constData();
+    m_lastError.clear();
+    m_failed.store(false, std::memory_order_relaxed);
+    m_latencyMs.store(0.0, std::memory_order_relaxed);
+    m_callback = std::move(callback);
+    m_frameBytes = static_cast<size_t>(format.bytesPerFrame());
+
+    m_mainloop = pa_threaded_mainloop_new();
+    if (!m_mainloop) {
+        fail("Failed to create PulseAudio mainloop");
+        return false;
+    }
+    m_context = pa_context_new(pa_threaded_mainloop_get_api(m_mainloop), "AI_Equalizer capture");
+    if (!m_context) {
+        fail("Failed to create PulseAudio context");
+        return false;
+    }
+    pa_context_set_state_callback(m_context, &PulseCapture::contextStateCallback, this);
+
+    pa_threaded_mainloop_lock(m_mainloop);
+    if (pa_threaded_mainloop_start(m_mainloop) < 0) {
+        pa_threaded_mainloop_unlock(m_mainloop);
+        fail("Failed to start PulseAudio mainloop");
+        return false;
+    }
+    if (pa_context_connect(m_context, nullptr, PA_CONTEXT_NOFLAGS, nullptr) < 0 || !waitForContext()) {
+        const QString error = QString("PulseAudio connection failed: %1").arg(pa_strerror(pa_context_errno(m_context)));
+        pa_threaded_mainloop_unlock(m_mainloop);
+        fail(error);
+        return false;
+    }
+
+    pa_sample_spec spec;
+    spec.format = PulseDevices::toPulseFormat(format.format);
+    spec.rate = static_cast<uint32_t>(format.sampleRate);
+    spec.channels = static_cast<uint8_t>(format.channels);
+
+    m_stream = pa_stream_new(m_context, "Equalizer capture", &spec, nullptr);
+    if (!m_stream) {
+        const QString error = QString("Failed to create record stream: %1").arg(pa_strerror(pa_context_errno(m_context)));
+        pa_threaded_mainloop_unlock(m_mainloop);
+        fail(error);
+        return false;
+    }
+    pa_stream_set_state_callback(m_stream, &PulseCapture::streamStateCallback, this);
+    pa_stream_set_read_callback(m_stream, &PulseCapture::streamReadCallback, this);
+
+    // fragsize drives how often the server delivers data; ADJUST_LATENCY
+    // makes it also size the source's own buffering to match
+    pa_buffer_attr attr;
+    attr.maxlength = static_cast<uint32_t>(-1);
+    attr.tlength = static_cast<uint32_t>(-1);
+    attr.prebuf = static_cast<uint32_t>(-1);
+    attr.minreq = static_cast<uint32_t>(-1);
+    attr.fragsize = static_cast<uint32_t>(fragmentFrames * pa_frame_size(&spec));
+
+    const pa_stream_flags_t flags = static_cast<pa_stream_flags_t>(
+        PA_STREAM_ADJUST_LATENCY | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_INTERPOLATE_TIMING);
+    if (pa_stream_connect_record(m_stream, sourceName, &attr, flags) < 0 || !waitForStream()) {
+        const QString error = QString("Failed to record from %1: %2")
+                                  .arg(sourceName, pa_strerror(pa_context_errno(m_context)));
+        pa_threaded_mainloop_unlock(m_mainloop);
+        fail(error);
+        return false;
+    }
+
+    const pa_buffer_attr* actual = pa_stream_get_buffer_attr(m_stream);
+    pa_threaded_mainloop_unlock(m_mainloop);
+
+    qDebug() << "Native capture started from" << sourceName << "|" << sampleFormatName(format.format)
+             << "| fragment:" << (actual ? actual->fragsize / pa_frame_size(&spec) : 0) << "frames";
+    return true;
+}
+
+void PulseCapture::stop()
+{
+    if (!m_mainloop) {
+        return;
+    }
+
+    pa_threaded_mainloop_lock(m_mainloop);
+    if (m_stream) {
+        pa_stream_set_read_callback(m_stream, nullptr, nullptr);
+        pa_stream_set_state_callback(m_stream, nullptr, nullptr);
+        pa_stream_disconnect(m_stream);
+        pa_stream_unref(m_stream);
+        m_stream = nullptr;
+    }
+    if (m_context) {
+        pa_context_set_state_callback(m_context, nullptr, nullptr);
+        pa_context_disconnect(m_context);
+        pa_context_unref(m_context);
+        m_context = nullptr;
+    }
+    pa_threaded_mainloop_unlock(m_mainloop);
+
+    // Joins the mainloop thread: no callback runs after this
+    pa_threaded_mainloop_stop(m_mainloop);
+    pa_threaded_mainloop_free(m_mainloop);
+    m_mainloop = nullptr;
+}
+
+void PulseCapture::setPaused(bool paused)
+{
+    if (!m_mainloop || !m_stream) {
+        return;
+    }
+    // Asynchronous: fragments already delivered may still reach the callback
+    pa_threaded_mainloop_lock(m_mainloop);
+    pa_operation* operation = pa_stream_cork(m_stream, paused ? 1 : 0, nullptr, nullptr);
+    if (operation) {
+        pa_operation_unref(operation);
+    }
+    pa_threaded_mainloop_unlock(m_mainloop);
+}
+
+std::unique_ptr<AudioCaptureBackend> PulseCapture::createFallback() const
+{
+    return std::make_unique<ParecCapture>(QString::fromUtf8(m_sourceName));
+}
+
+bool PulseCapture::waitForContext()
+{
+    // Mainloop lock held; woken by contextStateCallback
+    for (;;) {
+        const pa_context_state_t state = pa_context_get_state(m_context);
+        if (state == PA_CONTEXT_READY) {
+            return true;
+        }
+        if (!PA_CONTEXT_IS_GOOD(state)) {
+            return false;
+        }
+        pa_threaded_mainloop_wait(m_mainloop);
+    }
+}
+
+bool PulseCapture::waitForStream()
+{
+    for (;;) {
+        const pa_stream_state_t state = pa_stream_get_state(m_stream);
+        if (state == PA_STREAM_READY) {
+            return true;
+        }
+        if (!PA_STREAM_IS_GOOD(state)) {
+            return false;
+        }
+        pa_threaded_mainloop_wait(m_mainloop);
+    }
+}
+
+void PulseCapture::fail(const QString& message)
+{
+    m_lastError = message;
+    qWarning() << "PulseCapture:" << message;
+    stop();
+}
+
+void PulseCapture::contextStateCallback(pa_context* context, void* userdata)
+{
+    Q_UNUSED(context);
+    auto* self = static_cast<PulseCapture*>(userdata);
+    pa_threaded_mainloop_signal(self->m_mainloop, 0);
+}
+
+void PulseCapture::streamStateCallback(pa_stream* stream, void* userdata)
+{
+    auto* self = static_cast<PulseCapture*>(userdata);
+    if (pa_stream_get_state(stream) == PA_STREAM_FAILED) {
+        self->m_failed.store(true, std::memory_order_relaxed);
+        qWarning() << "PulseCapture: record stream failed:"
+                   << pa_strerror(pa_context_errno(pa_stream_get_context(stream)));
+    }
+    pa_threaded_mainloop_signal(self->m_mainloop, 0);
+}
+
+void PulseCapture::streamReadCallback(pa_stream* stream, size_t bytes, void* userdata)
+{
+    Q_UNUSED(bytes);
+    auto* self = static_cast<PulseCapture*>(userdata);
+
+    // Drain everything readable; peek returns one server chunk at a time
+    while (pa_stream_readable_size(stream) > 0) {
+        const void* data = nullptr;
+        size_t size = 0;
+        if (pa_stream_peek(stream, &data, &size) < 0 || size == 0) {
+            return;
+        }
+        // A hole (data == nullptr) is dropped; the sink side sees an underrun
+        const int frames = static_cast<int>(size / self->m_frameBytes);
+        if (data && frames > 0) {
+            self->m_callback(data, frames);
+        }
+        pa_stream_drop(stream);
+    }
+
+    // Interpolated from the automatic timing updates, so no round trip;
+    // published for latencyMs(), which must not take the mainloop lock
+    pa_usec_t latency = 0;
+    int negative = 0;
+    if (pa_stream_get_latency(stream, &latency, &negative) >= 0) {
+        self->m_latencyMs.store(negative ? 0.0 : latency / 1000.0, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,70 @@
+#ifndef PULSECAPTURE_H
+#define PULSECAPTURE_H
+
+#include <QByteArray>
+#include <atomic>
+#include <pulse/pulseaudio.h>
+#include "audiobackend.h"
+
+/**
+ * @class PulseCapture
+ * @brief Asynchronous PulseAudio record stream on a threaded mainloop
+ *
+ * Captures interleaved audio in any SampleFormat (ideally the source's own,
+ * so the server does not convert) from a source (typically a sink monitor)
+ * and hands every fragment to a callback on PulseAudio's mainloop thread, as
+ * soon as the server delivers it. The server is asked for fragments of
+ * fragmentFrames, so the callback cadence sets the capture latency. No
+ * subprocess, pipe or polling is involved.
+ *
+ * The callback reads the stream's own memory, with no copy in between; it
+ * stays valid until the callback returns, which must not block.
+ */
+class PulseCapture : public AudioCaptureBackend {
+public:
+    static constexpr const char* DEFAULT_SOURCE = "Equalizer_Input.monitor";
+
+    explicit PulseCapture(const QString& sourceName = DEFAULT_SOURCE);
+    ~PulseCapture() override;
+
+    PulseCapture(const PulseCapture&) = delete;
+    PulseCapture& operator=(const PulseCapture&) = delete;
+
+    const char* name() const override { return "pulse"; }
+    // The source's rate and format; PulseAudio remixes any channel count
+    AudioStreamFormat preferredFormat() override;
+
+    // Blocks until the stream is recording or has failed (see lastError())
+    bool start(const AudioStreamFormat& format, int fragmentFrames, FrameCallback callback) override;
+    void stop() override;
+    // Corks the stream: the source stops sending, the connection stays up
+    void setPaused(bool paused) override;
+    bool isFinished() const override { return m_failed.load(std::memory_order_relaxed); }
+
+    bool isRunning() const { return m_stream != nullptr; }
+    // Source-to-callback delay reported by the server, as of the last
+    // fragment; 0 if unknown
+    double latencyMs() override { return m_latencyMs.load(std::memory_order_relaxed); }
+    // parec on the same source
+    std::unique_ptr<AudioCaptureBackend> createFallback() const override;
+
+private:
+    QByteArray m_sourceName;
+    pa_threaded_mainloop* m_mainloop{nullptr};
+    pa_context* m_context{nullptr};
+    pa_stream* m_stream{nullptr};
+    FrameCallback m_callback;
+    size_t m_frameBytes{0};
+    std::atomic_bool m_failed{false};
+    std::atomic<double> m_latencyMs{0.0};  // Written by streamReadCallback
+
+    bool waitForContext();
+    bool waitForStream();
+    void fail(const QString& message);
+
+    static void contextStateCallback(pa_context* context, void* userdata);
+    static void streamStateCallback(pa_stream* stream, void* userdata);
+    static void streamReadCallback(pa_stream* stream, size_t bytes, void* userdata);
+};
+
+#endif // PULSECAPTURE_H
@@ -0,0 +1,143 @@
+#include "pulsedevices.h"
+
+namespace {
+
+struct QueryState {
+    PulseDeviceSpec* source;
+    PulseDeviceSpec* sink;
+    int pending;
+};
+
+void fillSpec(PulseDeviceSpec* spec, const pa_sample_spec& sampleSpec)
+{
+    spec->found = true;
+    spec->sampleRate = static_cast<int>(sampleSpec.rate);
+    spec->channels = sampleSpec.channels;
+    spec->nativeFormat = PulseDevices::fromPulseFormat(sampleSpec.format, &spec->format);
+    if (!spec->nativeFormat) {
+        spec->format = SampleFormat::Float32;
+    }
+}
+
+// Called once per match, then once more with eol set (negative on error)
+void sourceInfoCallback(pa_context* context, const pa_source_info* info, int eol, void* userdata)
+{
+    Q_UNUSED(context);
+    auto* state = static_cast<QueryState*>(userdata);
+    if (eol != 0) {
+        --state->pending;
+    } else if (info) {
+        fillSpec(state->source, info->sample_spec);
+    }
+}
+
+void sinkInfoCallback(pa_context* context, const pa_sink_info* info, int eol, void* userdata)
+{
+    Q_UNUSED(context);
+    auto* state = static_cast<QueryState*>(userdata);
+    if (eol != 0) {
+        --state->pending;
+    } else if (info) {
+        fillSpec(state->sink, info->sample_spec);
+    }
+}
+
+} // namespace
+
+bool PulseDevices::query(const char* sourceName, const char* sinkName, PulseDeviceSpec* source,
+                         PulseDeviceSpec* sink, QString* error)
+{
+    *source = PulseDeviceSpec();
+    *sink = PulseDeviceSpec();
+
+    pa_mainloop* mainloop = pa_mainloop_new();
+    if (!mainloop) {
+        if (error) {
+            *error = "Failed to create PulseAudio mainloop";
+        }
+        return false;
+    }
+    pa_context* context = pa_context_new(pa_mainloop_get_api(mainloop), "AI_Equalizer probe");
+    bool ok = context && pa_context_connect(context, nullptr, PA_CONTEXT_NOFLAGS, nullptr) >= 0;
+    while (ok) {
+        const pa_context_state_t state = pa_context_get_state(context);
+        if (state == PA_CONTEXT_READY) {
+            break;
+        }
+        if (!PA_CONTEXT_IS_GOOD(state) || pa_mainloop_iterate(mainloop, 1, nullptr) < 0) {
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        // Both lookups go out together and share the round trip
+        QueryState state{source, sink, 0};
+        pa_operation* operations[2] = {nullptr, nullptr};
+        if (sourceName) {
+            operations[0] = pa_context_get_source_info_by_name(context, sourceName, &sourceInfoCallback, &state);
+        }
+        if (sinkName) {
+            operations[1] = pa_context_get_sink_info_by_name(context, sinkName, &sinkInfoCallback, &state);
+        }
+        for (pa_operation* operation : operations) {
+            state.pending += operation ? 1 : 0;
+        }
+        while (state.pending > 0) {
+            if (pa_mainloop_iterate(mainloop, 1, nullptr) < 0) {
+                ok = false;
+                break;
+            }
+        }
+        for (pa_operation* operation : operations) {
+            if (operation) {
+                pa_operation_unref(operation);
+            }
+        }
+    }
+    if (!ok && error) {
+        *error = QString("PulseAudio introspection failed: %1")
+                     .arg(context ? pa_strerror(pa_context_errno(context)) : "no context");
+    }
+
+    if (context) {
+        pa_context_disconnect(context);
+        pa_context_unref(context);
+    }
+    pa_mainloop_free(mainloop);
+    return ok;
+}
+
+bool PulseDevices::fromPulseFormat(pa_sample_format_t pulseFormat, SampleFormat* format)
+{
+    switch (pulseFormat) {
+    case PA_SAMPLE_FLOAT32LE:
+        *format = SampleFormat::Float32;
+        return true;
+    case PA_SAMPLE_S16LE:
+        *format = SampleFormat::S16;
+        return true;
+    case PA_SAMPLE_S24LE:
+        *format = SampleFormat::S24;
+        return true;
+    case PA_SAMPLE_S32LE:
+        *format = SampleFormat::S32;
+        return true;
+    default:
+        return false;
+    }
+}
+
+pa_sample_format_t PulseDevices::toPulseFormat(SampleFormat format)
+{
+    switch (format) {
+    case SampleFormat::S16:
+        return PA_SAMPLE_S16LE;
+    case SampleFormat::S24:
+        return PA_SAMPLE_S24LE;
+    case SampleFormat::S32:
+        return PA_SAMPLE_S32LE;
+    case SampleFormat::Float32:
+        break;
+    }
+    return PA_SAMPLE_FLOAT32LE;
+}
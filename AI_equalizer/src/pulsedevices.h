@@ -0,0 +1,38 @@
+#ifndef PULSEDEVICES_H
+#define PULSEDEVICES_H
+
+#include <QString>
+#include <pulse/pulseaudio.h>
+#include "sampleformat.h"
+
+// Sample spec of one PulseAudio source or sink
+struct PulseDeviceSpec {
+    bool found{false};
+    int sampleRate{0};
+    int channels{0};
+    SampleFormat format{SampleFormat::Float32};
+    bool nativeFormat{false};  // format is the device's own, not a fallback
+};
+
+/**
+ * @class PulseDevices
+ * @brief Looks up the native sample spec of the capture source and playback sink
+ *
+ * Streams opened at a device's own rate and format are passed through by the
+ * server; anything else is resampled or converted on the way. query() asks
+ * the server directly over a short-lived connection, without enumerating
+ * every device.
+ */
+class PulseDevices {
+public:
+    // Blocks for one server round trip. Either name may be null; a device
+    // that does not exist is left with found == false.
+    static bool query(const char* sourceName, const char* sinkName, PulseDeviceSpec* source,
+                      PulseDeviceSpec* sink, QString* error = nullptr);
+
+    // Formats the audio path handles natively; others map to nothing
+    static bool fromPulseFormat(pa_sample_format_t pulseFormat, SampleFormat* format);
+    static pa_sample_format_t toPulseFormat(SampleFormat format);
+};
+
+#endif // PULSEDEVICES_H
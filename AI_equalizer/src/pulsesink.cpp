@@ -0,0 +1,122 @@
+#include "pulsesink.h"
+#include "pulsedevices.h"
+#include <QDebug>
+#include <pulse/error.h>
+
+PulseSink::PulseSink(const QString& sinkName)
+    : m_sinkName(sinkName.toUtf8())
+{
+}
+
+PulseSink::~PulseSink()
+{
+    close();
+}
+
+AudioStreamFormat PulseSink::preferredFormat()
+{
+    // One introspection round trip resolves the sink and its sample spec
+    AudioStreamFormat format;
+    PulseDeviceSpec source;
+    PulseDeviceSpec sink;
+    QString error;
+    m_resolved = PulseDevices::query(nullptr, m_sinkName.constData(), &source, &sink, &error);
+    m_sinkFound = sink.found;
+    if (!m_resolved) {
+        qWarning() << "PulseSink:" << error;
+    } else if (sink.found) {
+        format.sampleRate = sink.sampleRate;
+        format.format = sink.format;
+    }
+    return format;
+}
+
+bool PulseSink::open(const AudioStreamFormat& format, int bufferMs)
+{
+    if (m_stream) {
+        return true;
+    }
+    m_lastError.clear();
+    if (!m_resolved) {
+        preferredFormat();
+    }
+    // A missing sink falls back to the server's default one
+    const char* sinkName = m_sinkName.constData();
+    if (m_resolved && !m_sinkFound) {
+        qWarning() << "Sink" << sinkName << "not found, using the default sink";
+        sinkName = nullptr;
+    }
+    
+    qDebug() << "\nInitializing PulseAudio output...";
+    qDebug() << "Output sink:" << (sinkName ? sinkName : "(default)");
+    
+    pa_sample_spec ss;
+    ss.format = PulseDevices::toPulseFormat(format.format);
+    ss.rate = static_cast<uint32_t>(format.sampleRate);
+    ss.channels = static_cast<uint8_t>(format.channels);
+    
+    pa_buffer_attr bufattr;
+    bufattr.maxlength = (uint32_t) -1;
+    bufattr.tlength = pa_usec_to_bytes(bufferMs * PA_USEC_PER_MSEC, &ss);
+    bufattr.prebuf = (uint32_t) -1;
+    bufattr.minreq = (uint32_t) -1;
+    
+    int error;
+    m_stream = pa_simple_new(
+        nullptr,                    // Default server
+        "AI_Equalizer",            // Application name
+        PA_STREAM_PLAYBACK,        // Playback stream
+        sinkName,                  // Sink name
+        "Equalized Audio",         // Stream description
+        &ss,                       // Sample format
+        nullptr,                   // Default channel map
+        &bufattr,                  // Buffer attributes
+        &error                     // Error code
+    );
+    
+    if (!m_stream) {
+        m_lastError = QString("Failed to create PulseAudio output: %1").arg(pa_strerror(error));
+        return false;
+    }
+    m_frameBytes = format.bytesPerFrame();
+    
+    qDebug() << "PulseAudio output initialized successfully";
+    qDebug() << "Format:" << sampleFormatName(format.format) << "," << format.channels << "ch,"
+             << format.sampleRate << "Hz";
+    return true;
+}
+
+bool PulseSink::write(const void* frames, int frameCount)
+{
+    int error;
+    if (pa_simple_write(m_stream, frames, static_cast<size_t>(frameCount) * m_frameBytes, &error) < 0) {
+        m_lastError = QString("PulseAudio write error: %1").arg(pa_strerror(error));
+        return false;
+    }
+    return true;
+}
+
+int64_t PulseSink::bufferedUsec()
+{
+    int error;
+    const pa_usec_t latency = pa_simple_get_latency(m_stream, &error);
+    return latency == static_cast<pa_usec_t>(-1) ? -1 : static_cast<int64_t>(latency);
+}
+
+void PulseSink::drain()
+{
+    if (m_stream) {
+        pa_simple_drain(m_stream, nullptr);
+    }
+}
+
+void PulseSink::close()
+{
+    if (!m_stream) {
+        return;
+    }
+    // Freeing the stream drops whatever the server still buffers, at once
+    pa_simple_free(m_stream);
+    m_stream = nullptr;
+    qDebug() << "PulseAudio output closed";
+}
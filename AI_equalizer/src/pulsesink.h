@@ -0,0 +1,40 @@
+#ifndef PULSESINK_H
+#define PULSESINK_H
+
+#include <QByteArray>
+#include <pulse/simple.h>
+#include "audiobackend.h"
+
+/**
+ * @class PulseSink
+ * @brief PulseAudio playback through the simple API
+ *
+ * A blocking playback stream: write() returns once the server has room,
+ * which paces the writer thread at the sink's clock.
+ */
+class PulseSink : public AudioSinkBackend {
+public:
+    static constexpr const char* DEFAULT_SINK = "Equalizer_Output";
+
+    explicit PulseSink(const QString& sinkName = DEFAULT_SINK);
+    ~PulseSink() override;
+
+    const char* name() const override { return "pulse"; }
+    // The sink's rate and format; PulseAudio remixes any channel count
+    AudioStreamFormat preferredFormat() override;
+
+    bool open(const AudioStreamFormat& format, int bufferMs) override;
+    bool write(const void* frames, int frameCount) override;
+    int64_t bufferedUsec() override;
+    void drain() override;
+    void close() override;
+
+private:
+    QByteArray m_sinkName;
+    pa_simple* m_stream{nullptr};
+    bool m_resolved{false};   // Introspection reached the server
+    bool m_sinkFound{false};
+    int m_frameBytes{0};
+};
+
+#endif // PULSESINK_H
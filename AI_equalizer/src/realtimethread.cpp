@@ -0,0 +1,176 @@
+#include "realtimethread.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifdef AI_EQ_HAVE_RTKIT
+#include <QDBusConnection>
+#include <QDBusInterface>
+#include <QDBusReply>
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+RealtimeThread::Result RealtimeThread::enter(const RealtimeConfig& config, bool scheduling)
+{
+    Result result;
+    if (!config.enabled) {
+        return result;
+    }
+    QString error;
+
+    if (scheduling) {
+        result.scheduled = setFifo(config.priority, &error) || requestRtkit(config.priority, &error);
+        if (!result.scheduled) {
+            qWarning() << "Real-time scheduling unavailable:" << error;
+        }
+    }
+    if (config.cpu >= 0) {
+        result.pinned = pinToCpu(config.cpu, &error);
+        if (!result.pinned) {
+            qWarning() << "Cannot pin the audio thread to CPU" << config.cpu << ":" << error;
+        }
+    }
+    prefaultStack();
+    result.memoryLocked = lockMemory(&error);
+    if (!result.memoryLocked) {
+        qWarning() << "Cannot lock memory:" << error << "(raise the memlock limit, e.g. ulimit -l)";
+    }
+    result.flushToZero = setFlushToZero(true);
+
+    qDebug() << "Real-time audio thread:" << (result.scheduled ? "SCHED_FIFO" : "normal scheduling")
+             << config.priority << "| CPU:" << (result.pinned ? QString::number(config.cpu) : QString("any"))
+             << "| memory locked:" << result.memoryLocked << "| FTZ/DAZ:" << result.flushToZero;
+    return result;
+}
+
+void RealtimeThread::leave(const Result& result)
+{
+    if (result.memoryLocked) {
+        munlockall();
+    }
+}
+
+bool RealtimeThread::setFlushToZero(bool enabled)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    // MXCSR bit 15: flush-to-zero, bit 6: denormals-are-zero
+    constexpr unsigned int FTZ_DAZ = 0x8040;
+    const unsigned int csr = _mm_getcsr();
+    _mm_setcsr(enabled ? (csr | FTZ_DAZ) : (csr & ~FTZ_DAZ));
+    return true;
+#elif defined(__aarch64__)
+    // FPCR bit 24 (FZ) covers both inputs and results
+    constexpr uint64_t FZ = uint64_t(1) << 24;
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    fpcr = enabled ? (fpcr | FZ) : (fpcr & ~FZ);
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+    return true;
+#else
+    (void)enabled;
+    return false;
+#endif
+}
+
+bool RealtimeThread::setFifo(int priority, QString* error)
+{
+    sched_param param{};
+    param.sched_priority = priority;
+    const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (result != 0) {
+        *error = QString("SCHED_FIFO: %1").arg(std::strerror(result));
+        return false;
+    }
+    return true;
+}
+
+bool RealtimeThread::requestRtkit(int priority, QString* error)
+{
+#ifdef AI_EQ_HAVE_RTKIT
+    rlimit limit{};
+    limit.rlim_cur = limit.rlim_max = RTTIME_LIMIT_USEC;
+    if (setrlimit(RLIMIT_RTTIME, &limit) != 0) {
+        *error += QString(", RLIMIT_RTTIME: %1").arg(std::strerror(errno));
+        return false;
+    }
+
+    QDBusInterface rtkit("org.freedesktop.RealtimeKit1", "/org/freedesktop/RealtimeKit1",
+                         "org.freedesktop.RealtimeKit1", QDBusConnection::systemBus());
+    if (!rtkit.isValid()) {
+        *error += ", rtkit not available";
+        return false;
+    }
+    const QVariant maxPriority = rtkit.property("MaxRealtimePriority");
+    if (maxPriority.isValid() && priority > maxPriority.toInt()) {
+        priority = maxPriority.toInt();
+    }
+    const quint64 thread = static_cast<quint64>(syscall(SYS_gettid));
+    const QDBusReply<void> reply = rtkit.call("MakeThreadRealtime", thread, static_cast<quint32>(priority));
+    if (!reply.isValid()) {
+        *error += QString(", rtkit: %1").arg(reply.error().message());
+        return false;
+    }
+    return true;
+#else
+    (void)priority;
+    *error += ", built without rtkit support";
+    return false;
+#endif
+}
+
+bool RealtimeThread::pinToCpu(int cpu, QString* error)
+{
+    if (cpu >= CPU_SETSIZE) {
+        *error = "no such CPU";
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    const int result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0) {
+        *error = std::strerror(result);
+        return false;
+    }
+    return true;
+}
+
+bool RealtimeThread::lockMemory(QString* error)
+{
+    // The audio buffers are allocated and touched before the thread starts;
+    // with MCL_ONFAULT the rest of the address space (other threads' stacks,
+    // unused library pages) is not pulled in just to be locked
+#ifdef MCL_ONFAULT
+    if (mlockall(MCL_CURRENT | MCL_ONFAULT) == 0) {
+        return true;
+    }
+    if (errno != EINVAL) {
+        *error = std::strerror(errno);
+        return false;
+    }
+#endif
+    if (mlockall(MCL_CURRENT) != 0) {
+        *error = std::strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+void RealtimeThread::prefaultStack()
+{
+    // Touch the stack the audio loop may grow into, so it never faults later
+    char stack[STACK_PREFAULT_BYTES];
+    std::memset(stack, 0, sizeof(stack));
+    // Keeps the stores from being optimized away
+    __asm__ __volatile__("" : : "r"(stack) : "memory");
+}
@@ -0,0 +1,60 @@
+#ifndef REALTIMETHREAD_H
+#define REALTIMETHREAD_H
+
+#include <QString>
+
+// Opt-in real-time settings for the audio thread
+struct RealtimeConfig {
+    bool enabled{false};
+    int priority{20};  // SCHED_FIFO priority, 1-99 (rtkit allows up to 20 by default)
+    int cpu{-1};       // Core to pin the thread to, or -1 for any
+};
+
+/**
+ * @class RealtimeThread
+ * @brief Makes the calling thread a real-time audio thread, best effort
+ *
+ * enter() applies, in order:
+ * - SCHED_FIFO at the configured priority, directly when the process may
+ *   (CAP_SYS_NICE or an RLIMIT_RTPRIO allowance), else through rtkit on the
+ *   system bus when built with Qt D-Bus
+ * - CPU affinity to the configured core
+ * - Memory locking: the thread's stack is prefaulted and everything mapped
+ *   so far is locked (pages are only locked once resident where the kernel
+ *   supports it), which needs a memlock limit above the process size
+ * - FTZ/DAZ (x86-64 MXCSR, AArch64 FPCR), so no floating-point operation on
+ *   the thread ever produces or reads a denormal
+ *
+ * Each step that fails is logged and skipped; the result says which took
+ * effect. Scheduling and FP mode belong to the thread and end with it;
+ * leave() releases the process-wide memory lock.
+ */
+class RealtimeThread {
+public:
+    struct Result {
+        bool scheduled{false};
+        bool pinned{false};
+        bool memoryLocked{false};
+        bool flushToZero{false};
+    };
+
+    // scheduling: false skips SCHED_FIFO, e.g. for a thread that never blocks
+    static Result enter(const RealtimeConfig& config, bool scheduling = true);
+    static void leave(const Result& result);
+
+    // FTZ/DAZ for the calling thread; false where not supported
+    static bool setFlushToZero(bool enabled);
+
+private:
+    static constexpr int STACK_PREFAULT_BYTES = 256 * 1024;
+    // rtkit only grants real-time to threads with a CPU time limit
+    static constexpr long RTTIME_LIMIT_USEC = 200000;
+
+    static bool setFifo(int priority, QString* error);
+    static bool requestRtkit(int priority, QString* error);
+    static bool pinToCpu(int cpu, QString* error);
+    static bool lockMemory(QString* error);
+    static void prefaultStack();
+};
+
+#endif // REALTIMETHREAD_H
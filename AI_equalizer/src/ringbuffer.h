@@ -0,0 +1,266 @@
+#ifndef RINGBUFFER_H
+#define RINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+/**
+ * @class RingBuffer
+ * @brief Lock-free single-producer/single-consumer ring of interleaved frames
+ *
+ * Storage is allocated once by reset() and never grows, so memory use is
+ * capped and neither side locks or allocates while streaming. The indices
+ * count frames monotonically and live on separate cache lines, each side
+ * keeping to its own line except when the other is checked for space/data.
+ *
+ * When the producer finds the ring full, the overflow policy decides:
+ * - DropOldest: the oldest queued frames are discarded to make room, which
+ *   keeps the queued audio (and so the latency) bounded. The producer moves
+ *   the read index with a CAS; the consumer commits its reads with a CAS
+ *   too and simply re-reads if frames were dropped under it.
+ * - DropNewest: the frames that do not fit are discarded.
+ * - Block: the producer sleeps until the consumer makes room or close() is
+ *   called. Only for producers that may stall (never a real-time callback).
+ * Each event is counted in stats().
+ *
+ * prepareWrite()/commitWrite() let the producer generate frames straight
+ * into the ring (zero-copy); write() is the copying form of the same. The
+ * consumer always copies out: under DropOldest the producer may reclaim
+ * frames the consumer is still looking at, which read() detects and
+ * retries, but in-place processing could not undo.
+ */
+class RingBuffer {
+public:
+    enum class OverflowPolicy {
+        DropOldest,
+        DropNewest,
+        Block
+    };
+
+    struct Stats {
+        uint64_t droppedOldest;  // Queued frames discarded to make room
+        uint64_t droppedNewest;  // Incoming frames that did not fit
+        uint64_t blockedWrites;  // Writes that had to wait for space
+    };
+
+    // Writable frames, split in two where the ring wraps
+    struct WriteRegion {
+        float* first;
+        int firstFrames;
+        float* second;
+        int secondFrames;
+
+        int frames() const { return firstFrames + secondFrames; }
+    };
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    RingBuffer() = default;
+    RingBuffer(int capacityFrames, int channels, OverflowPolicy policy)
+    {
+        reset(capacityFrames, channels, policy);
+    }
+
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    // Not thread-safe: call while neither side is running. The capacity is
+    // rounded up to a power of two.
+    void reset(int capacityFrames, int channels, OverflowPolicy policy)
+    {
+        size_t capacity = 1;
+        while (capacity < static_cast<size_t>(std::max(capacityFrames, 1))) {
+            capacity <<= 1;
+        }
+        m_capacity = capacity;
+        m_mask = capacity - 1;
+        m_channels = std::max(channels, 1);
+        m_policy = policy;
+        m_data.assign(m_capacity * m_channels, 0.0f);
+        m_writeIndex.store(0, std::memory_order_relaxed);
+        m_readIndex.store(0, std::memory_order_relaxed);
+        m_droppedOldest.store(0, std::memory_order_relaxed);
+        m_droppedNewest.store(0, std::memory_order_relaxed);
+        m_blockedWrites.store(0, std::memory_order_relaxed);
+        m_closed.store(false, std::memory_order_release);
+    }
+
+    // Releases a producer blocked on a full ring; later writes never block
+    void close() { m_closed.store(true, std::memory_order_release); }
+
+    int capacityFrames() const { return static_cast<int>(m_capacity); }
+    int channels() const { return m_channels; }
+    OverflowPolicy policy() const { return m_policy; }
+
+    // Any thread. The read index is loaded first, like read() does: the write
+    // index only grows, so it cannot fall behind it. A drop-oldest write
+    // between the loads can still make the difference exceed the capacity.
+    int availableFrames() const
+    {
+        const uint64_t read = m_readIndex.load(std::memory_order_acquire);
+        const uint64_t write = m_writeIndex.load(std::memory_order_acquire);
+        if (write <= read) {
+            return 0;
+        }
+        return static_cast<int>(std::min(write - read, static_cast<uint64_t>(m_capacity)));
+    }
+
+    Stats stats() const
+    {
+        return {m_droppedOldest.load(std::memory_order_relaxed),
+                m_droppedNewest.load(std::memory_order_relaxed),
+                m_blockedWrites.load(std::memory_order_relaxed)};
+    }
+
+    // Producer side: returns the number of frames queued
+    int write(const float* frames, int frameCount)
+    {
+        if (frameCount <= 0 || m_capacity == 0) {
+            return 0;
+        }
+        size_t count = static_cast<size_t>(frameCount);
+        if (m_policy == OverflowPolicy::DropOldest && count > m_capacity) {
+            // Only the newest capacity frames can ever be kept
+            const size_t skipped = count - m_capacity;
+            frames += skipped * m_channels;
+            count = m_capacity;
+            m_droppedOldest.fetch_add(skipped, std::memory_order_relaxed);
+        }
+        const WriteRegion region = prepareWrite(static_cast<int>(count));
+        std::memcpy(region.first, frames, static_cast<size_t>(region.firstFrames) * m_channels * sizeof(float));
+        std::memcpy(region.second, frames + static_cast<size_t>(region.firstFrames) * m_channels,
+                    static_cast<size_t>(region.secondFrames) * m_channels * sizeof(float));
+        commitWrite(region.frames());
+        return region.frames();
+    }
+
+    // Producer side, zero-copy: makes room for frameCount frames under the
+    // overflow policy and returns where they go. Fewer frames are granted
+    // under DropNewest, on a closed ring, or beyond capacityFrames(). Nothing
+    // is visible to the consumer until commitWrite().
+    WriteRegion prepareWrite(int frameCount)
+    {
+        const uint64_t write = m_writeIndex.load(std::memory_order_relaxed);
+        size_t count = std::min(static_cast<size_t>(std::max(frameCount, 0)), m_capacity);
+        m_droppedNewest.fetch_add(std::max(frameCount, 0) - count, std::memory_order_relaxed);
+        bool waited = false;
+
+        while (count > 0) {
+            uint64_t read = m_readIndex.load(std::memory_order_acquire);
+            const size_t space = m_capacity - static_cast<size_t>(write - read);
+            if (space >= count) {
+                break;
+            }
+            if (m_policy == OverflowPolicy::DropOldest) {
+                const size_t needed = count - space;
+                if (m_readIndex.compare_exchange_weak(read, read + needed, std::memory_order_acq_rel,
+                                                      std::memory_order_acquire)) {
+                    m_droppedOldest.fetch_add(needed, std::memory_order_relaxed);
+                    break;
+                }
+                continue;  // The consumer moved; recompute the space
+            }
+            if (m_policy == OverflowPolicy::Block && !m_closed.load(std::memory_order_acquire)) {
+                if (!waited) {
+                    m_blockedWrites.fetch_add(1, std::memory_order_relaxed);
+                    waited = true;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                continue;
+            }
+            // DropNewest, or a closed ring under Block
+            m_droppedNewest.fetch_add(count - space, std::memory_order_relaxed);
+            count = space;
+            break;
+        }
+
+        const size_t start = static_cast<size_t>(write) & m_mask;
+        const size_t first = std::min(count, m_capacity - start);
+        float* base = m_data.data();
+        return {base + start * m_channels, static_cast<int>(first), base, static_cast<int>(count - first)};
+    }
+
+    // Producer side: publishes frameCount frames of the last prepareWrite()
+    void commitWrite(int frameCount)
+    {
+        const uint64_t write = m_writeIndex.load(std::memory_order_relaxed);
+        m_writeIndex.store(write + static_cast<uint64_t>(std::max(frameCount, 0)), std::memory_order_release);
+    }
+
+    // Consumer side: returns the number of frames read, up to maxFrames
+    int read(float* frames, int maxFrames)
+    {
+        for (;;) {
+            uint64_t read = m_readIndex.load(std::memory_order_acquire);
+            const uint64_t write = m_writeIndex.load(std::memory_order_acquire);
+            const size_t count = std::min(static_cast<size_t>(write - read),
+                                          static_cast<size_t>(std::max(maxFrames, 0)));
+            if (count == 0) {
+                return 0;
+            }
+            copyOut(read, frames, count);
+            if (m_policy != OverflowPolicy::DropOldest) {
+                m_readIndex.store(read + count, std::memory_order_release);
+                return static_cast<int>(count);
+            }
+            // A failed commit means the producer dropped frames we were
+            // copying, which it may already be overwriting
+            if (m_readIndex.compare_exchange_strong(read, read + count, std::memory_order_acq_rel,
+                                                    std::memory_order_acquire)) {
+                return static_cast<int>(count);
+            }
+        }
+    }
+
+    // Consumer side: drops up to maxFrames of the oldest queued frames
+    int discard(int maxFrames)
+    {
+        uint64_t read = m_readIndex.load(std::memory_order_acquire);
+        for (;;) {
+            const uint64_t write = m_writeIndex.load(std::memory_order_acquire);
+            const size_t count = std::min(static_cast<size_t>(write - read),
+                                          static_cast<size_t>(std::max(maxFrames, 0)));
+            if (count == 0) {
+                return 0;
+            }
+            if (m_readIndex.compare_exchange_weak(read, read + count, std::memory_order_acq_rel,
+                                                  std::memory_order_acquire)) {
+                return static_cast<int>(count);
+            }
+        }
+    }
+
+private:
+    void copyOut(uint64_t index, float* frames, size_t count) const
+    {
+        const size_t start = static_cast<size_t>(index) & m_mask;
+        const size_t first = std::min(count, m_capacity - start);
+        std::memcpy(frames, &m_data[start * m_channels], first * m_channels * sizeof(float));
+        std::memcpy(frames + first * m_channels, &m_data[0], (count - first) * m_channels * sizeof(float));
+    }
+
+    // Shared configuration, written only by reset()
+    std::vector<float> m_data;
+    size_t m_capacity{0};
+    size_t m_mask{0};
+    int m_channels{1};
+    OverflowPolicy m_policy{OverflowPolicy::DropOldest};
+
+    // Producer line
+    alignas(CACHE_LINE) std::atomic<uint64_t> m_writeIndex{0};
+    std::atomic<uint64_t> m_droppedOldest{0};
+    std::atomic<uint64_t> m_droppedNewest{0};
+    std::atomic<uint64_t> m_blockedWrites{0};
+    std::atomic<bool> m_closed{false};
+
+    // Consumer line
+    alignas(CACHE_LINE) std::atomic<uint64_t> m_readIndex{0};
+    char m_padding[CACHE_LINE - sizeof(std::atomic<uint64_t>)];
+};
+
+#endif // RINGBUFFER_H
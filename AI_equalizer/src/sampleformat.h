@@ -0,0 +1,178 @@
+#ifndef SAMPLEFORMAT_H
+#define SAMPLEFORMAT_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Interleaved little-endian PCM formats the audio path can run natively
+// (PulseAudio's float32le, s16le, s24le and s32le). Integer full scale maps
+// to [-1, 1); conversion to integers rounds and saturates.
+enum class SampleFormat {
+    Float32,
+    S16,
+    S24,  // Packed, 3 bytes per sample
+    S32
+};
+
+inline int bytesPerSample(SampleFormat format)
+{
+    switch (format) {
+    case SampleFormat::S16:
+        return 2;
+    case SampleFormat::S24:
+        return 3;
+    case SampleFormat::Float32:
+    case SampleFormat::S32:
+        break;
+    }
+    return 4;
+}
+
+inline const char* sampleFormatName(SampleFormat format)
+{
+    switch (format) {
+    case SampleFormat::S16:
+        return "s16le";
+    case SampleFormat::S24:
+        return "s24le";
+    case SampleFormat::S32:
+        return "s32le";
+    case SampleFormat::Float32:
+        break;
+    }
+    return "float32le";
+}
+
+// Per-sample load/store, resolved at compile time inside conversion loops.
+// Assumes a little-endian host, like the rest of the audio path.
+template <SampleFormat F>
+struct SampleCodec;
+
+template <>
+struct SampleCodec<SampleFormat::Float32> {
+    static double load(const uint8_t* p)
+    {
+        float value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+    static void store(uint8_t* p, double value)
+    {
+        const float sample = static_cast<float>(value);
+        std::memcpy(p, &sample, sizeof(sample));
+    }
+};
+
+template <>
+struct SampleCodec<SampleFormat::S16> {
+    static double load(const uint8_t* p)
+    {
+        int16_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value * (1.0 / 32768.0);
+    }
+    static void store(uint8_t* p, double value)
+    {
+        const int16_t sample = static_cast<int16_t>(std::lrint(std::clamp(value * 32768.0, -32768.0, 32767.0)));
+        std::memcpy(p, &sample, sizeof(sample));
+    }
+};
+
+template <>
+struct SampleCodec<SampleFormat::S24> {
+    static double load(const uint8_t* p)
+    {
+        const int32_t value = static_cast<int32_t>(p[0]) | (static_cast<int32_t>(p[1]) << 8)
+                              | (static_cast<int32_t>(static_cast<int8_t>(p[2])) * 65536);
+        return value * (1.0 / 8388608.0);
+    }
+    static void store(uint8_t* p, double value)
+    {
+        const int32_t sample = static_cast<int32_t>(std::lrint(std::clamp(value * 8388608.0, -8388608.0, 8388607.0)));
+        p[0] = static_cast<uint8_t>(sample);
+        p[1] = static_cast<uint8_t>(sample >> 8);
+        p[2] = static_cast<uint8_t>(sample >> 16);
+    }
+};
+
+template <>
+struct SampleCodec<SampleFormat::S32> {
+    static double load(const uint8_t* p)
+    {
+        int32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value * (1.0 / 2147483648.0);
+    }
+    static void store(uint8_t* p, double value)
+    {
+        const int32_t sample = static_cast<int32_t>(
+            std::llrint(std::clamp(value * 2147483648.0, -2147483648.0, 2147483647.0)));
+        std::memcpy(p, &sample, sizeof(sample));
+    }
+};
+
+template <SampleFormat F>
+void convertSamplesTo(const void* input, float* output, int count)
+{
+    const uint8_t* in = static_cast<const uint8_t*>(input);
+    const int stride = bytesPerSample(F);
+    for (int i = 0; i < count; ++i) {
+        output[i] = static_cast<float>(SampleCodec<F>::load(in + i * stride));
+    }
+}
+
+template <SampleFormat F>
+void convertSamplesFrom(const float* input, void* output, int count)
+{
+    uint8_t* out = static_cast<uint8_t*>(output);
+    const int stride = bytesPerSample(F);
+    for (int i = 0; i < count; ++i) {
+        SampleCodec<F>::store(out + i * stride, input[i]);
+    }
+}
+
+// count samples of any format to float
+inline void convertSamples(const void* input, SampleFormat inputFormat, float* output, int count)
+{
+    switch (inputFormat) {
+    case SampleFormat::Float32:
+        if (output != input) {
+            std::memcpy(output, input, count * sizeof(float));
+        }
+        break;
+    case SampleFormat::S16:
+        convertSamplesTo<SampleFormat::S16>(input, output, count);
+        break;
+    case SampleFormat::S24:
+        convertSamplesTo<SampleFormat::S24>(input, output, count);
+        break;
+    case SampleFormat::S32:
+        convertSamplesTo<SampleFormat::S32>(input, output, count);
+        break;
+    }
+}
+
+// count float samples to any format
+inline void convertSamples(const float* input, void* output, SampleFormat outputFormat, int count)
+{
+    switch (outputFormat) {
+    case SampleFormat::Float32:
+        if (output != input) {
+            std::memcpy(output, input, count * sizeof(float));
+        }
+        break;
+    case SampleFormat::S16:
+        convertSamplesFrom<SampleFormat::S16>(input, output, count);
+        break;
+    case SampleFormat::S24:
+        convertSamplesFrom<SampleFormat::S24>(input, output, count);
+        break;
+    case SampleFormat::S32:
+        convertSamplesFrom<SampleFormat::S32>(input, output, count);
+        break;
+    }
+}
+
+#endif // SAMPLEFORMAT_H
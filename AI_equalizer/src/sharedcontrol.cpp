@@ -0,0 +1,285 @@
+#include "sharedcontrol.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <new>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+// Seqlock write: odd while the data is being changed
+template <typename T>
+void seqlockWrite(std::atomic<uint32_t>& sequence, uint32_t start, T& target, const T& value)
+{
+    sequence.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&target, &value, sizeof(T));
+    sequence.store(start + 2, std::memory_order_release);
+}
+
+// Seqlock read: a copy taken while the counter stayed even and unchanged
+template <typename T>
+bool seqlockRead(const std::atomic<uint32_t>& sequence, const T& source, T* value, uint32_t* seen, int attempts)
+{
+    for (int attempt = 0; attempt < attempts; ++attempt) {
+        const uint32_t before = sequence.load(std::memory_order_acquire);
+        if (before & 1u) {
+            continue;
+        }
+        std::memcpy(value, &source, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence.load(std::memory_order_relaxed) == before) {
+            if (seen) {
+                *seen = before;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+// Shared (not FUTEX_PRIVATE) operations: the word lives in a mapping that
+// other processes wait on and wake too
+uint32_t* futexWord(std::atomic<uint32_t>& word)
+{
+    return reinterpret_cast<uint32_t*>(&word);
+}
+
+void futexWait(std::atomic<uint32_t>& word, uint32_t expected, int timeoutMs)
+{
+    timespec timeout{timeoutMs / 1000, (timeoutMs % 1000) * 1000000L};
+    syscall(SYS_futex, futexWord(word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>& word)
+{
+    syscall(SYS_futex, futexWord(word), FUTEX_WAKE, INT32_MAX, nullptr, nullptr, 0);
+}
+
+} // namespace
+
+SharedControl::~SharedControl()
+{
+    close();
+}
+
+bool SharedControl::create(const char* name)
+{
+    return map(name, true);
+}
+
+bool SharedControl::open(const char* name)
+{
+    return map(name, false);
+}
+
+bool SharedControl::map(const char* name, bool create)
+{
+    close();
+    int fd = create ? shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600) : shm_open(name, O_RDWR, 0);
+    if (create && fd < 0 && errno == EEXIST) {
+        if (!isStale(name)) {
+            m_lastError = QString("%1 is in use by another running equalizer").arg(name);
+            return false;
+        }
+        shm_unlink(name);
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if (fd < 0) {
+        m_lastError = QString("shm_open %1: %2").arg(name, strerror(errno));
+        return false;
+    }
+    if (create && ftruncate(fd, sizeof(Block)) != 0) {
+        m_lastError = QString("ftruncate %1: %2").arg(name, strerror(errno));
+        ::close(fd);
+        shm_unlink(name);
+        return false;
+    }
+    struct stat info {};
+    if (!create && (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(Block)))) {
+        m_lastError = QString("%1 is not an equalizer control block").arg(name);
+        ::close(fd);
+        return false;
+    }
+    void* memory = mmap(nullptr, sizeof(Block), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        m_lastError = QString("mmap %1: %2").arg(name, strerror(errno));
+        if (create) {
+            shm_unlink(name);
+        }
+        return false;
+    }
+
+    Block* block = static_cast<Block*>(memory);
+    if (create) {
+        // Fresh pages are zero: both counters start even and empty
+        block = new (memory) Block{};
+        block->header.version = VERSION;
+        block->header.size = sizeof(Block);
+        block->header.ownerPid = static_cast<uint32_t>(getpid());
+        std::atomic_thread_fence(std::memory_order_release);
+        block->header.magic = MAGIC;
+    } else if (block->header.magic != MAGIC || block->header.version != VERSION) {
+        m_lastError = QString("%1 has an unsupported layout").arg(name);
+        munmap(memory, sizeof(Block));
+        return false;
+    }
+    m_block = block;
+    m_name = QString::fromLocal8Bit(name);
+    m_owner = create;
+    m_takenSequence = block->requestSequence.load(std::memory_order_acquire);
+    m_lastError.clear();
+    return true;
+}
+
+bool SharedControl::isStale(const char* name)
+{
+    const int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        // Gone meanwhile: nothing to take over
+        return errno == ENOENT;
+    }
+    struct stat info {};
+    const bool sized = fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(Block));
+    void* memory = sized ? mmap(nullptr, sizeof(Block), PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (memory == MAP_FAILED) {
+        // Truncated or unreadable: not a block anyone can use
+        return true;
+    }
+    const Block::Header& header = static_cast<const Block*>(memory)->header;
+    bool stale = header.magic != MAGIC || header.version != VERSION || header.ownerPid == 0;
+    if (!stale) {
+        // Our own pid: left by an earlier run that had it (e.g. as pid 1 in a
+        // container). EPERM: alive, but another user's.
+        const pid_t owner = static_cast<pid_t>(header.ownerPid);
+        stale = owner == getpid() || (kill(owner, 0) != 0 && errno == ESRCH);
+    }
+    munmap(memory, sizeof(Block));
+    return stale;
+}
+
+void SharedControl::close()
+{
+    if (!m_block) {
+        return;
+    }
+    munmap(m_block, sizeof(Block));
+    m_block = nullptr;
+    if (m_owner) {
+        shm_unlink(m_name.toLocal8Bit().constData());
+        m_owner = false;
+    }
+}
+
+void SharedControl::publishState(const SharedState& state)
+{
+    if (!m_block) {
+        return;
+    }
+    // Single writer: the counter is ours
+    const uint32_t start = m_block->stateSequence.load(std::memory_order_relaxed);
+    seqlockWrite(m_block->stateSequence, start, m_block->state, state);
+}
+
+bool SharedControl::takeRequest(SharedRequest* request, uint32_t* sequence)
+{
+    if (!m_block || m_block->requestSequence.load(std::memory_order_acquire) == m_takenSequence) {
+        return false;
+    }
+    uint32_t seen = 0;
+    if (!seqlockRead(m_block->requestSequence, m_block->request, request, &seen, READ_ATTEMPTS)) {
+        return false;
+    }
+    m_takenSequence = seen;
+    if (sequence) {
+        *sequence = seen;
+    }
+    return true;
+}
+
+uint32_t SharedControl::wakeCount() const
+{
+    return m_block ? m_block->header.wake.load(std::memory_order_acquire) : 0;
+}
+
+bool SharedControl::waitForRequest(uint32_t since, int timeoutMs)
+{
+    if (!m_block) {
+        return false;
+    }
+    // The kernel only sleeps while the word still holds `since`, so a wake()
+    // between wakeCount() and here is never lost. An odd counter is a write
+    // in progress: its writer wakes us when done, so it is no reason to skip
+    // the wait.
+    const uint32_t sequence = m_block->requestSequence.load(std::memory_order_acquire);
+    if (sequence & 1u) {
+        releaseStuckWrite(sequence);
+    }
+    if ((sequence & 1u) || sequence == m_takenSequence) {
+        futexWait(m_block->header.wake, since, timeoutMs);
+    }
+    const uint32_t current = m_block->requestSequence.load(std::memory_order_acquire);
+    return !(current & 1u) && current != m_takenSequence;
+}
+
+void SharedControl::releaseStuckWrite(uint32_t sequence)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if (sequence != m_oddSequence) {
+        m_oddSequence = sequence;
+        m_oddSince = now;
+        return;
+    }
+    if (now - m_oddSince < std::chrono::milliseconds(STUCK_WRITE_MS)) {
+        return;
+    }
+    // Its writer is gone: move the counter on, without taking what it left
+    uint32_t expected = sequence;
+    if (m_block->requestSequence.compare_exchange_strong(expected, sequence + 1, std::memory_order_acq_rel,
+                                                         std::memory_order_relaxed)) {
+        m_takenSequence = sequence + 1;
+        qWarning() << "SharedControl: dropped a request abandoned mid-write";
+    }
+    m_oddSequence = 0;
+}
+
+void SharedControl::wake()
+{
+    if (!m_block) {
+        return;
+    }
+    m_block->header.wake.fetch_add(1, std::memory_order_acq_rel);
+    futexWakeAll(m_block->header.wake);
+}
+
+uint32_t SharedControl::writeRequest(const SharedRequest& request)
+{
+    if (!m_block) {
+        return 0;
+    }
+    // Claim the counter: even to odd, so concurrent writers take turns
+    uint32_t start = m_block->requestSequence.load(std::memory_order_relaxed);
+    while ((start & 1u) || !m_block->requestSequence.compare_exchange_weak(start, start + 1, std::memory_order_acquire,
+                                                                           std::memory_order_relaxed)) {
+        start = m_block->requestSequence.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&m_block->request, &request, sizeof(SharedRequest));
+    m_block->requestSequence.store(start + 2, std::memory_order_release);
+    wake();
+    return start + 2;
+}
+
+bool SharedControl::readState(SharedState* state) const
+{
+    return m_block && seqlockRead(m_block->stateSequence, m_block->state, state, nullptr, READ_ATTEMPTS);
+}
@@ -0,0 +1,148 @@
+#ifndef SHAREDCONTROL_H
+#define SHAREDCONTROL_H
+
+#include "biquadkernel.h"
+#include <QString>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+// Engine state as published in the shared block
+struct SharedState {
+    uint32_t applied;    // Sequence of the last request taken (see SharedRequest)
+    uint32_t bandCount;
+    uint32_t bypass;     // 0 or 1
+    uint32_t running;    // Audio processing, 0 or 1
+    uint32_t channels;   // Entries of peak and rms in use
+    float latencyMs;
+    float gains[BiquadBank::MAX_BANDS];        // dB, bandCount in use
+    float peak[BiquadBank::MAX_CHANNELS];      // Linear, 1.0 = full scale
+    float rms[BiquadBank::MAX_CHANNELS];
+};
+
+// A controller's request; only the fields named in flags are applied
+struct SharedRequest {
+    enum Flags : uint32_t {
+        Gains = 1u << 0,
+        Bypass = 1u << 1
+    };
+
+    uint32_t flags;
+    uint32_t bandCount;  // The layout's band count, or 10 to be mapped
+    uint32_t bypass;
+    float gains[BiquadBank::MAX_BANDS];
+};
+
+/**
+ * @class SharedControl
+ * @brief Seqlock-protected shared-memory block for co-located controllers
+ *
+ * The block is a POSIX shared memory object (/dev/shm/<name> on Linux) with
+ * two halves, each behind its own sequence counter on its own cache line:
+ * the state, published by the equalizer, and the request, written by a
+ * controller. Readers never block writers: a writer makes the counter odd,
+ * writes and makes it even again, and a reader copies the half and retries
+ * if the counter was odd or moved meanwhile. Reading the meters is a few
+ * hundred bytes of memory traffic, with no system call and no connection.
+ *
+ * The equalizer sleeps on the header's wake counter, a futex word: a
+ * writer bumps it and issues one FUTEX_WAKE after writing its request, so
+ * the request is taken at once. The latest request wins, and state.applied
+ * echoes its sequence once it has reached the model. Concurrent requests
+ * are safe between clients that use writeRequest(), which claims the
+ * counter with a compare-and-swap; other writers (e.g. scripts) have to
+ * take turns, and wake the equalizer the same way. A writer that dies
+ * mid-write leaves the counter odd; once it has not moved for
+ * STUCK_WRITE_MS, the equalizer makes it even again and drops the
+ * half-written request.
+ *
+ * Layout (little-endian, offsets in bytes; see the static_asserts):
+ *   0    uint32 magic ('AIEQ'), uint32 version, uint32 size, uint32 wake,
+ *        uint32 owner pid
+ *   64   uint32 state sequence, then SharedState
+ *   320  uint32 request sequence, then SharedRequest
+ */
+class SharedControl {
+public:
+    static constexpr const char* DEFAULT_NAME = "/ai_equalizer";
+    static constexpr uint32_t MAGIC = 0x51454941;  // "AIEQ"
+    static constexpr uint32_t VERSION = 2;
+
+    struct alignas(64) Block {
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t size;
+            std::atomic<uint32_t> wake;  // Futex word, bumped by wake()
+            uint32_t ownerPid;           // The equalizer that created the block
+        };
+        alignas(64) Header header;
+        alignas(64) std::atomic<uint32_t> stateSequence;
+        SharedState state;
+        alignas(64) std::atomic<uint32_t> requestSequence;
+        SharedRequest request;
+    };
+
+    SharedControl() = default;
+    ~SharedControl();
+    SharedControl(const SharedControl&) = delete;
+    SharedControl& operator=(const SharedControl&) = delete;
+
+    // Equalizer side: creates the block. One left by an equalizer that is no
+    // longer running, or with another layout, is replaced; a live one is
+    // left alone and this fails.
+    bool create(const char* name = DEFAULT_NAME);
+    // Controller side: maps an existing block
+    bool open(const char* name = DEFAULT_NAME);
+    // Unmaps, and removes the block if this side created it
+    void close();
+    bool isOpen() const { return m_block != nullptr; }
+    QString lastError() const { return m_lastError; }
+
+    // Equalizer side (one thread)
+    void publishState(const SharedState& state);
+    // A request not taken yet, with its sequence; false if none or if a
+    // writer held the block throughout
+    bool takeRequest(SharedRequest* request, uint32_t* sequence);
+    // Sleeps until a request is pending, wake() was called since wakeCount()
+    // returned `since`, or timeoutMs passed; true if a request is pending.
+    // A write in progress does not count as pending.
+    uint32_t wakeCount() const;
+    bool waitForRequest(uint32_t since, int timeoutMs);
+
+    // Either side, any thread: ends the equalizer's waitForRequest()
+    void wake();
+
+    // Controller side, wakes the equalizer; returns the request's sequence
+    uint32_t writeRequest(const SharedRequest& request);
+    bool readState(SharedState* state) const;
+
+private:
+    static constexpr int READ_ATTEMPTS = 64;
+    // How long the request counter may stay odd before its writer is taken
+    // to be gone
+    static constexpr int STUCK_WRITE_MS = 1000;
+
+    Block* m_block{nullptr};
+    QString m_name;
+    bool m_owner{false};
+    uint32_t m_takenSequence{0};
+    // Odd request sequence last seen by waitForRequest(), and since when
+    uint32_t m_oddSequence{0};
+    std::chrono::steady_clock::time_point m_oddSince;
+    QString m_lastError;
+
+    bool map(const char* name, bool create);
+    void releaseStuckWrite(uint32_t sequence);
+    static bool isStale(const char* name);
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared counters must be lock-free");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "shared counters must be plain words");
+static_assert(sizeof(SharedState) == 24 + 4 * (BiquadBank::MAX_BANDS + 2 * BiquadBank::MAX_CHANNELS),
+              "SharedState must have no padding");
+static_assert(sizeof(SharedRequest) == 12 + 4 * BiquadBank::MAX_BANDS, "SharedRequest must have no padding");
+static_assert(sizeof(SharedControl::Block) == 512, "shared layout changed: bump VERSION and the offsets");
+
+#endif // SHAREDCONTROL_H
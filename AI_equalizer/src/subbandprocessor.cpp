@@ -0,0 +1,143 @@
+#include "subbandprocessor.h"
+#include <algorithm>
+#include <cmath>
+
+SubbandProcessor::SubbandProcessor()
+    : m_history(MAX_CHANNELS * 2 * HISTORY_FRAMES), m_deviation(MAX_CHANNELS * 2 * PHASE_TAPS)
+{
+    // Blackman-windowed sinc at the reduced rate's Nyquist frequency
+    const double cutoff = 0.5 / DECIMATION;
+    const double center = (FIR_TAPS - 1) / 2.0;
+    double taps[FIR_TAPS];
+    double sum = 0.0;
+    for (int k = 0; k < FIR_TAPS; ++k) {
+        const double t = k - center;
+        const double sinc = 2.0 * cutoff * std::sin(2.0 * M_PI * cutoff * t) / (2.0 * M_PI * cutoff * t);
+        const double phase = 2.0 * M_PI * k / (FIR_TAPS - 1);
+        const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        taps[k] = sinc * window;
+        sum += taps[k];
+    }
+
+    // Oldest sample first: tap k applies to the input k frames back
+    for (int k = 0; k < FIR_TAPS; ++k) {
+        m_decimationTaps[FIR_TAPS - 1 - k] = taps[k] / sum;
+    }
+    // Phase p uses taps p, p + D, p + 2D, ... on the newest low-rate samples
+    for (int p = 0; p < DECIMATION; ++p) {
+        for (int m = 0; m < PHASE_TAPS; ++m) {
+            m_interpolationTaps[p][PHASE_TAPS - 1 - m] = DECIMATION * taps[p + m * DECIMATION] / sum;
+        }
+    }
+}
+
+void SubbandProcessor::reset()
+{
+    m_bank.reset();
+    std::fill(m_history.begin(), m_history.end(), 0.0);
+    std::fill(m_deviation.begin(), m_deviation.end(), 0.0);
+    m_historyPos = 0;
+    m_deviationPos = 0;
+    m_phase = 0;
+    m_deviationIdle = true;
+}
+
+double SubbandProcessor::dot(const double* a, const double* b, int count)
+{
+    // Independent partial sums; a single accumulator is add-latency bound
+    double s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+    for (int i = 0; i < count; i += 4) {
+        s0 += a[i] * b[i];
+        s1 += a[i + 1] * b[i + 1];
+        s2 += a[i + 2] * b[i + 2];
+        s3 += a[i + 3] * b[i + 3];
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+void SubbandProcessor::process(const int* bands, int bandCount, float* buffer, int frameCount, int channels)
+{
+    if (channels <= 0 || channels > MAX_CHANNELS) {
+        return;
+    }
+    for (int offset = 0; offset < frameCount; offset += CHUNK_FRAMES) {
+        const int frames = std::min(CHUNK_FRAMES, frameCount - offset);
+        processChunk(bands, bandCount, buffer + offset * channels, frames, channels);
+    }
+}
+
+void SubbandProcessor::processChunk(const int* bands, int bandCount, float* buffer, int frameCount, int channels)
+{
+    // Pass 1: append the input to the history and decimate it
+    int lowFrames = 0;
+    int phase = m_phase;
+    for (int frame = 0; frame < frameCount; ++frame) {
+        const int pos = (m_historyPos + frame) & HISTORY_MASK;
+        for (int ch = 0; ch < channels; ++ch) {
+            double* history = &m_history[ch * 2 * HISTORY_FRAMES];
+            history[pos] = history[pos + HISTORY_FRAMES] = buffer[frame * channels + ch];
+        }
+        if (phase == 0 && bandCount > 0) {
+            // Window of the last FIR_TAPS inputs, ending at this frame
+            const int start = pos + HISTORY_FRAMES - (FIR_TAPS - 1);
+            for (int ch = 0; ch < channels; ++ch) {
+                const double* history = &m_history[ch * 2 * HISTORY_FRAMES];
+                m_lowInput[lowFrames * channels + ch] =
+                    static_cast<float>(dot(m_decimationTaps, history + start, FIR_TAPS));
+            }
+            ++lowFrames;
+        }
+        phase = (phase + 1) % DECIMATION;
+    }
+
+    // Nothing running through this stage: the deviation has already rung
+    // out to below the output resolution, only the delay is left
+    if (bandCount == 0) {
+        if (!m_deviationIdle) {
+            std::fill(m_deviation.begin(), m_deviation.end(), 0.0);
+            m_deviationIdle = true;
+        }
+        for (int frame = 0; frame < frameCount; ++frame) {
+            const int delayed = (m_historyPos + frame - LATENCY_FRAMES) & HISTORY_MASK;
+            for (int ch = 0; ch < channels; ++ch) {
+                buffer[frame * channels + ch] = static_cast<float>(m_history[ch * 2 * HISTORY_FRAMES + delayed]);
+            }
+        }
+        m_historyPos = (m_historyPos + frameCount) & HISTORY_MASK;
+        m_phase = phase;
+        return;
+    }
+    m_deviationIdle = false;
+
+    // Pass 2: the low bands at the reduced rate
+    std::copy(m_lowInput, m_lowInput + lowFrames * channels, m_lowOutput);
+    m_bank.process(bands, bandCount, m_lowOutput, lowFrames, channels);
+
+    // Pass 3: interpolate the deviation and add it to the delayed input
+    int lowFrame = 0;
+    phase = m_phase;
+    for (int frame = 0; frame < frameCount; ++frame) {
+        if (phase == 0) {
+            m_deviationPos = (m_deviationPos + 1) % PHASE_TAPS;
+            for (int ch = 0; ch < channels; ++ch) {
+                const int index = lowFrame * channels + ch;
+                double* deviation = &m_deviation[ch * 2 * PHASE_TAPS];
+                deviation[m_deviationPos] = deviation[m_deviationPos + PHASE_TAPS] =
+                    static_cast<double>(m_lowOutput[index]) - m_lowInput[index];
+            }
+            ++lowFrame;
+        }
+        const int delayed = (m_historyPos + frame - LATENCY_FRAMES) & HISTORY_MASK;
+        const int start = m_deviationPos + 1;  // Oldest of the PHASE_TAPS newest
+        for (int ch = 0; ch < channels; ++ch) {
+            const double* deviation = &m_deviation[ch * 2 * PHASE_TAPS];
+            const double direct = m_history[ch * 2 * HISTORY_FRAMES + delayed];
+            const double low = dot(m_interpolationTaps[phase], deviation + start, PHASE_TAPS);
+            buffer[frame * channels + ch] = static_cast<float>(direct + low);
+        }
+        phase = (phase + 1) % DECIMATION;
+    }
+
+    m_historyPos = (m_historyPos + frameCount) & HISTORY_MASK;
+    m_phase = phase;
+}
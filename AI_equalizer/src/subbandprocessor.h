@@ -0,0 +1,75 @@
+#ifndef SUBBANDPROCESSOR_H
+#define SUBBANDPROCESSOR_H
+
+#include <vector>
+#include "biquadkernel.h"
+
+/**
+ * @class SubbandProcessor
+ * @brief Runs low-frequency bands at 1/DECIMATION of the sample rate
+ *
+ * Each low band only changes the signal near its own frequency, so the
+ * cascade is applied as a deviation: the input is lowpassed and decimated,
+ * the low bands run at the reduced rate, and the difference they make
+ * (output minus input) is interpolated back up and added to the input,
+ * delayed to line up with the filter delay. A flat low cascade leaves the
+ * input bit-exact apart from the delay.
+ *
+ * At the reduced rate the low bands' poles sit much further from the unit
+ * circle and cost 1/DECIMATION per sample. The polyphase decimation and
+ * interpolation filters cost FIR_TAPS / DECIMATION multiplies each per
+ * sample, so the stage pays off once several bands run through it.
+ *
+ * The deviation is band-limited by the interpolation filter (flat to about
+ * 0.15 * rate / DECIMATION), so bands given to this stage must have their
+ * effect concentrated well below that: peaks, low shelves and high-passes
+ * far below the crossover (see EqualizerEngine::isSubbandEligible).
+ *
+ * The sections of bank() are designed for sampleRate / DECIMATION.
+ */
+class SubbandProcessor {
+public:
+    static constexpr int DECIMATION = 8;
+    static constexpr int FIR_TAPS = 64;  // Multiple of DECIMATION
+    static constexpr int MAX_CHANNELS = BiquadBank::MAX_CHANNELS;
+    // Decimation plus interpolation filter delay
+    static constexpr int LATENCY_FRAMES = FIR_TAPS - 1;
+
+    SubbandProcessor();
+
+    BiquadBank& bank() { return m_bank; }
+    const BiquadBank& bank() const { return m_bank; }
+
+    // Audio thread: run the listed bank() bands over interleaved frames, in place
+    void process(const int* bands, int bandCount, float* buffer, int frameCount, int channels);
+    void reset();
+
+private:
+    static constexpr int PHASE_TAPS = FIR_TAPS / DECIMATION;
+    static constexpr int CHUNK_FRAMES = BiquadBank::BLOCK_FRAMES;
+    static constexpr int MAX_LOW_FRAMES = CHUNK_FRAMES / DECIMATION + 1;
+    // Input history ring, long enough for the filter plus one chunk
+    static constexpr int HISTORY_FRAMES = 512;
+    static constexpr int HISTORY_MASK = HISTORY_FRAMES - 1;
+
+    // Windowed-sinc lowpass with unity DC gain, stored reversed so that both
+    // filters are forward dot products over contiguous history
+    double m_decimationTaps[FIR_TAPS];
+    double m_interpolationTaps[DECIMATION][PHASE_TAPS];  // Per phase, times DECIMATION
+
+    BiquadBank m_bank;
+    // Rings are stored twice over so every filter window is contiguous
+    std::vector<double> m_history;    // [channel][2 * HISTORY_FRAMES]
+    std::vector<double> m_deviation;  // [channel][2 * PHASE_TAPS] low-rate ring
+    float m_lowInput[MAX_LOW_FRAMES * MAX_CHANNELS];
+    float m_lowOutput[MAX_LOW_FRAMES * MAX_CHANNELS];
+    int m_historyPos{0};  // Slot of the next input frame
+    int m_deviationPos{0};
+    int m_phase{0};       // Frames since the last decimation instant, mod DECIMATION
+    bool m_deviationIdle{true};
+
+    static double dot(const double* a, const double* b, int count);
+    void processChunk(const int* bands, int bandCount, float* buffer, int frameCount, int channels);
+};
+
+#endif // SUBBANDPROCESSOR_H
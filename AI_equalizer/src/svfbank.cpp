@@ -0,0 +1,275 @@
+#include "svfbank.h"
+#include <algorithm>
+
+namespace {
+
+// Output range of the cascade, as for BiquadBank
+constexpr double OUTPUT_LIMIT = 10.0;
+constexpr double DENORMAL_THRESHOLD = 1e-15;
+
+struct Mix {
+    double a1, a2, a3, m0, m1, m2;
+};
+
+// Simper's coefficients for one value of sqrt(A). Inlined into the block
+// loops, where the type is fixed, so those vectorize.
+template <FilterType T>
+inline Mix mix(double g0, double k0, double root)
+{
+    const double A = root * root;
+    double g = g0;
+    double k = k0;
+    Mix m{0.0, 0.0, 0.0, 1.0, 0.0, 0.0};
+    switch (T) {
+    case FilterType::Peaking:
+        k = k0 / A;
+        m.m1 = k * (A * A - 1.0);
+        break;
+    case FilterType::LowShelf:
+        g = g0 / root;
+        m.m1 = k0 * (A - 1.0);
+        m.m2 = A * A - 1.0;
+        break;
+    case FilterType::HighShelf:
+        g = g0 * root;
+        m.m0 = A * A;
+        m.m1 = k0 * (1.0 - A) * A;
+        m.m2 = 1.0 - A * A;
+        break;
+    case FilterType::HighPass:
+        m.m1 = -k0;
+        m.m2 = -1.0;
+        break;
+    case FilterType::LowPass:
+        m.m0 = 0.0;
+        m.m2 = 1.0;
+        break;
+    }
+    m.a1 = 1.0 / (1.0 + g * (g + k));
+    m.a2 = g * m.a1;
+    m.a3 = g * m.a2;
+    return m;
+}
+
+// One band over the block, all channel lanes per sample
+template <int LANES>
+void runBand(double* ic1, double* ic2, const double* a1, const double* a2, const double* a3,
+             const double* m0, const double* m1, const double* m2, double* block, int frames)
+{
+    double s1[LANES];
+    double s2[LANES];
+    for (int lane = 0; lane < LANES; ++lane) {
+        s1[lane] = ic1[lane];
+        s2[lane] = ic2[lane];
+    }
+    for (int n = 0; n < frames; ++n) {
+        double* x = block + n * LANES;
+        for (int lane = 0; lane < LANES; ++lane) {
+            const double v0 = x[lane];
+            const double v3 = v0 - s2[lane];
+            const double v1 = a1[n] * s1[lane] + a2[n] * v3;
+            const double v2 = s2[lane] + a2[n] * s1[lane] + a3[n] * v3;
+            s1[lane] = 2.0 * v1 - s1[lane];
+            s2[lane] = 2.0 * v2 - s2[lane];
+            x[lane] = m0[n] * v0 + m1[n] * v1 + m2[n] * v2;
+        }
+    }
+    for (int lane = 0; lane < LANES; ++lane) {
+        ic1[lane] = s1[lane];
+        ic2[lane] = s2[lane];
+    }
+}
+
+// Lanes per frame in the block: channel counts are padded to 1, 2, 4 or 8
+int laneCount(int channels)
+{
+    if (channels <= 2) {
+        return channels;
+    }
+    return channels <= 4 ? 4 : 8;
+}
+
+} // namespace
+
+SvfBank::SvfBank()
+{
+    reset();
+}
+
+void SvfBank::setRampFrames(int frames)
+{
+    m_rampFrames = std::max(frames, 1);
+}
+
+void SvfBank::setParameters(int band, const SvfParameters& p)
+{
+    Band& b = m_bands[band];
+    b.params = p;
+    const bool pass = p.type == FilterType::HighPass || p.type == FilterType::LowPass;
+    const double target = pass ? 1.0 : std::pow(10.0, p.gainDB / 80.0);
+    if (target == b.targetRoot) {
+        return;
+    }
+    b.targetRoot = target;
+    if (pass || m_rampFrames <= 1) {
+        b.root = target;
+        b.remaining = 0;
+        return;
+    }
+    // A retarget mid-ramp glides on from where the band is
+    b.step = std::pow(target / b.root, 1.0 / m_rampFrames);
+    b.remaining = m_rampFrames;
+}
+
+bool SvfBank::isActive(int band) const
+{
+    const Band& b = m_bands[band];
+    return b.remaining > 0 || b.root != 1.0 || b.params.isActive();
+}
+
+void SvfBank::reset()
+{
+    for (int band = 0; band < MAX_BANDS; ++band) {
+        resetBand(band);
+    }
+}
+
+void SvfBank::resetBand(int band)
+{
+    Band& b = m_bands[band];
+    std::fill(b.ic1, b.ic1 + MAX_CHANNELS, 0.0);
+    std::fill(b.ic2, b.ic2 + MAX_CHANNELS, 0.0);
+    b.root = b.targetRoot;
+    b.remaining = 0;
+}
+
+void SvfBank::process(const int* bands, int bandCount, float* buffer, int frameCount, int channels)
+{
+    if (bandCount == 0 || channels <= 0 || channels > MAX_CHANNELS) {
+        return;
+    }
+    const int lanes = laneCount(channels);
+    const Coefficients& c = m_coefficients;
+
+    for (int offset = 0; offset < frameCount; offset += BLOCK_FRAMES) {
+        const int frames = std::min(BLOCK_FRAMES, frameCount - offset);
+        float* samples = buffer + offset * channels;
+        // Padding lanes stay silent, so their state stays at rest
+        std::fill(m_block, m_block + frames * lanes, 0.0);
+        for (int frame = 0; frame < frames; ++frame) {
+            for (int ch = 0; ch < channels; ++ch) {
+                m_block[frame * lanes + ch] = samples[frame * channels + ch];
+            }
+        }
+
+        // Band-outer: coefficients for the block, then the filter over it
+        for (int i = 0; i < bandCount; ++i) {
+            Band& band = m_bands[bands[i]];
+            prepareCoefficients(band, frames);
+            switch (lanes) {
+            case 1:
+                runBand<1>(band.ic1, band.ic2, c.a1, c.a2, c.a3, c.m0, c.m1, c.m2, m_block, frames);
+                break;
+            case 2:
+                runBand<2>(band.ic1, band.ic2, c.a1, c.a2, c.a3, c.m0, c.m1, c.m2, m_block, frames);
+                break;
+            case 4:
+                runBand<4>(band.ic1, band.ic2, c.a1, c.a2, c.a3, c.m0, c.m1, c.m2, m_block, frames);
+                break;
+            default:
+                runBand<8>(band.ic1, band.ic2, c.a1, c.a2, c.a3, c.m0, c.m1, c.m2, m_block, frames);
+                break;
+            }
+        }
+
+        for (int frame = 0; frame < frames; ++frame) {
+            for (int ch = 0; ch < channels; ++ch) {
+                samples[frame * channels + ch] = static_cast<float>(
+                    std::clamp(m_block[frame * lanes + ch], -OUTPUT_LIMIT, OUTPUT_LIMIT));
+            }
+        }
+    }
+
+    if (!m_hardwareFlushToZero) {
+        flushDenormals(bands, bandCount, channels);
+    }
+}
+
+template <FilterType T>
+void SvfBank::fillCoefficients(Coefficients& c, const double* roots, bool ramping, double g0, double k0,
+                               double root, int frames)
+{
+    if (!ramping) {
+        const Mix m = mix<T>(g0, k0, root);
+        std::fill(c.a1, c.a1 + frames, m.a1);
+        std::fill(c.a2, c.a2 + frames, m.a2);
+        std::fill(c.a3, c.a3 + frames, m.a3);
+        std::fill(c.m0, c.m0 + frames, m.m0);
+        std::fill(c.m1, c.m1 + frames, m.m1);
+        std::fill(c.m2, c.m2 + frames, m.m2);
+        return;
+    }
+    // No dependency between samples: this is the vectorized part
+    for (int n = 0; n < frames; ++n) {
+        const Mix m = mix<T>(g0, k0, roots[n]);
+        c.a1[n] = m.a1;
+        c.a2[n] = m.a2;
+        c.a3[n] = m.a3;
+        c.m0[n] = m.m0;
+        c.m1[n] = m.m1;
+        c.m2[n] = m.m2;
+    }
+}
+
+void SvfBank::prepareCoefficients(Band& band, int frames)
+{
+    const bool ramping = band.remaining > 0;
+    if (ramping) {
+        // The ramp itself is one multiply per sample; it ends exactly on
+        // the target and holds it for the rest of the block
+        const int ramp = std::min(band.remaining, frames);
+        double root = band.root;
+        for (int n = 0; n < ramp; ++n) {
+            root *= band.step;
+            m_roots[n] = root;
+        }
+        band.remaining -= ramp;
+        if (band.remaining == 0) {
+            root = band.targetRoot;
+            m_roots[ramp - 1] = root;
+        }
+        std::fill(m_roots + ramp, m_roots + frames, root);
+        band.root = root;
+    }
+
+    const SvfParameters& p = band.params;
+    switch (p.type) {
+    case FilterType::Peaking:
+        fillCoefficients<FilterType::Peaking>(m_coefficients, m_roots, ramping, p.g, p.k, band.root, frames);
+        break;
+    case FilterType::LowShelf:
+        fillCoefficients<FilterType::LowShelf>(m_coefficients, m_roots, ramping, p.g, p.k, band.root, frames);
+        break;
+    case FilterType::HighShelf:
+        fillCoefficients<FilterType::HighShelf>(m_coefficients, m_roots, ramping, p.g, p.k, band.root, frames);
+        break;
+    case FilterType::HighPass:
+        fillCoefficients<FilterType::HighPass>(m_coefficients, m_roots, false, p.g, p.k, band.root, frames);
+        break;
+    case FilterType::LowPass:
+        fillCoefficients<FilterType::LowPass>(m_coefficients, m_roots, false, p.g, p.k, band.root, frames);
+        break;
+    }
+}
+
+void SvfBank::flushDenormals(const int* bands, int bandCount, int channels)
+{
+    // Once per buffer, as in BiquadBank
+    for (int i = 0; i < bandCount; ++i) {
+        Band& b = m_bands[bands[i]];
+        for (int ch = 0; ch < channels; ++ch) {
+            if (std::abs(b.ic1[ch]) < DENORMAL_THRESHOLD) b.ic1[ch] = 0.0;
+            if (std::abs(b.ic2[ch]) < DENORMAL_THRESHOLD) b.ic2[ch] = 0.0;
+        }
+    }
+}
@@ -0,0 +1,114 @@
+#ifndef SVFBANK_H
+#define SVFBANK_H
+
+#include "biquadkernel.h"
+
+// Frequency part of a state-variable band plus its gain target. g and k
+// hold all the trig; the gain is kept apart so it can move per sample.
+struct SvfParameters {
+    FilterType type{FilterType::Peaking};
+    double g{0.0};       // tan(pi * frequency / sampleRate)
+    double k{1.0};       // 1 / Q
+    double gainDB{0.0};  // Ignored by the pass types
+
+    static SvfParameters design(FilterType type, double frequency, double sampleRate,
+                                double gainDB, double Q) {
+        SvfParameters p;
+        p.type = type;
+        p.g = std::tan(M_PI * frequency / sampleRate);
+        p.k = 1.0 / Q;
+        p.gainDB = gainDB;
+        return p;
+    }
+
+    // Whether the band differs from an identity at its target
+    bool isActive() const {
+        return gainDB != 0.0 || type == FilterType::HighPass || type == FilterType::LowPass;
+    }
+};
+
+/**
+ * @class SvfBank
+ * @brief Cascade of trapezoidal (TPT) state-variable filters whose gains
+ *        glide per sample
+ *
+ * Same responses as the cookbook biquads (see Andrew Simper, "Linear
+ * Trapezoidal Integrated SVF"), but the state is two integrators whose
+ * meaning does not depend on the coefficients, so the coefficients may
+ * change on every sample without the transients a direct-form filter
+ * produces.
+ *
+ * A new gain target starts a geometric ramp of sqrt(A) = 10^(dB/80), i.e. a
+ * straight line in dB, over the ramp length: one multiply per sample, and
+ * one pow per target change. The per-sample coefficients of a ramping band
+ * are derived from it for the whole block in loops without dependencies
+ * between samples (a divide and a few multiplies, no trig), which the
+ * compiler vectorizes; the filter then runs over the block with all
+ * channels in parallel lanes. Frequency and Q changes take effect at the
+ * next block, which the topology also tolerates.
+ *
+ * Shelves and peaks are exact identities at 0 dB. A band is only run while
+ * isActive(); a band that glides to 0 dB drops out when its ramp ends, and
+ * one that comes back starts from rest at 0 dB, so its start-up transient
+ * is faded in by its own ramp.
+ */
+class SvfBank {
+public:
+    static constexpr int MAX_BANDS = BiquadBank::MAX_BANDS;
+    static constexpr int MAX_CHANNELS = BiquadBank::MAX_CHANNELS;
+    static constexpr int BLOCK_FRAMES = BiquadBank::BLOCK_FRAMES;
+
+    SvfBank();
+
+    // Length of a gain ramp; takes effect with the next target
+    void setRampFrames(int frames);
+    // Adopts a band's parameters; a changed gain starts a ramp from the
+    // current one
+    void setParameters(int band, const SvfParameters& p);
+    // Running, ramping or away from an identity
+    bool isActive(int band) const;
+    // Clears all state and completes all ramps
+    void reset();
+    void resetBand(int band);
+
+    void setHardwareFlushToZero(bool enabled) { m_hardwareFlushToZero = enabled; }
+
+    // Run the listed bands in cascade over interleaved float frames, in place
+    void process(const int* bands, int bandCount, float* buffer, int frameCount, int channels);
+
+private:
+    struct alignas(32) Band {
+        double ic1[MAX_CHANNELS]{};
+        double ic2[MAX_CHANNELS]{};
+        SvfParameters params;
+        double root{1.0};        // sqrt(A) the band is at
+        double targetRoot{1.0};
+        double step{1.0};        // Per-sample ratio while ramping
+        int remaining{0};        // Frames left in the ramp
+    };
+
+    // Per-sample coefficients of one band over a block
+    struct alignas(32) Coefficients {
+        double a1[BLOCK_FRAMES];
+        double a2[BLOCK_FRAMES];
+        double a3[BLOCK_FRAMES];
+        double m0[BLOCK_FRAMES];
+        double m1[BLOCK_FRAMES];
+        double m2[BLOCK_FRAMES];
+    };
+
+    Band m_bands[MAX_BANDS];
+    Coefficients m_coefficients;
+    alignas(32) double m_roots[BLOCK_FRAMES];
+    alignas(32) double m_block[BLOCK_FRAMES * MAX_CHANNELS];
+    int m_rampFrames{1024};
+    bool m_hardwareFlushToZero{false};
+
+    void prepareCoefficients(Band& band, int frames);
+    template <FilterType T>
+    static void fillCoefficients(Coefficients& c, const double* roots, bool ramping, double g0, double k0,
+                                 double root, int frames);
+    void flushDenormals(const int* bands, int bandCount, int channels);
+};
+
+#endif // SVFBANK_H
@@ -0,0 +1,55 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+
+/**
+ * @class TripleBuffer
+ * @brief Lock-free single-producer/single-consumer snapshot exchange
+ *
+ * The producer fills writeBuffer() and calls publish(); the consumer calls
+ * update() at a safe point (e.g. a block boundary) and then reads
+ * readBuffer(). Three slots mean neither side ever waits or allocates: the
+ * producer always owns one slot, the consumer another, and the third holds
+ * the latest published value. The consumer only ever sees complete snapshots.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    // Seeds all three slots, e.g. to preallocate snapshots holding containers
+    explicit TripleBuffer(const T& initial) : m_buffers{initial, initial, initial} {}
+
+    // Producer side
+    T& writeBuffer() { return m_buffers[m_write]; }
+
+    void publish()
+    {
+        const int previous = m_middle.exchange(m_write | FRESH_BIT, std::memory_order_acq_rel);
+        m_write = previous & INDEX_MASK;
+    }
+
+    // Consumer side: returns true if a newer snapshot was picked up
+    bool update()
+    {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH_BIT)) {
+            return false;
+        }
+        const int previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+        m_read = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return m_buffers[m_read]; }
+
+private:
+    static constexpr int FRESH_BIT = 0x4;
+    static constexpr int INDEX_MASK = 0x3;
+
+    T m_buffers[3]{};
+    std::atomic<int> m_middle{2};
+    int m_write{0};  // Producer-owned
+    int m_read{1};   // Consumer-owned
+};
+
+#endif // TRIPLEBUFFER_H
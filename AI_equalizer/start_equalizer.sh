@@ -26,7 +26,7 @@ if sink_exists "Equalizer_Input"; then
     echo "✓ Equalizer_Input sink already exists"
 else
     echo "Creating Equalizer_Input sink..."
-    pactl load-module module-null-sink sink_name=Equalizer_Input sink_properties=device.description="Equalizer_Input" rate=44100 channels=2
+    pactl load-module module-null-sink sink_name=Equalizer_Input sink_properties=device.description="Equalizer_Input" channels=2
     echo "✓ Equalizer_Input sink created"
 fi
 
@@ -35,7 +35,7 @@ if sink_exists "Equalizer_Output"; then
     echo "✓ Equalizer_Output sink already exists"
 else
     echo "Creating Equalizer_Output sink..."
-    pactl load-module module-null-sink sink_name=Equalizer_Output sink_properties=device.description="Equalizer_Output" rate=44100 channels=2
+    pactl load-module module-null-sink sink_name=Equalizer_Output sink_properties=device.description="Equalizer_Output" channels=2
     echo "✓ Equalizer_Output sink created"
 fi
 
@@ -1,9 +1,14 @@
 from google.adk.agents.llm_agent import Agent
 from google.adk.tools import FunctionTool
-import subprocess
+import json
 import os
 from datetime import datetime
 
+try:
+    from .eq_client import EqualizerClient, PRESETS, read_shared_state
+except ImportError:  # Loaded as a top-level module by chat_agent.py
+    from eq_client import EqualizerClient, PRESETS, read_shared_state
+
 # Simple log helper to see when the tool runs
 LOG_PATH = os.path.join(os.path.dirname(__file__), "set_gains_tool.log")
 
@@ -18,7 +23,11 @@ def _log_tool(message: str) -> None:
 # API key can be passed via environment variable GOOGLE_API_KEY
 # If not set, the agent will fail at runtime when trying to call the model
 
-# --- Define the Agent's Tool ---
+# --- Define the Agent's Tools ---
+
+# One connection for the whole session instead of a process per tool call
+_client = EqualizerClient()
+
 def set_equalizer_gains(gains: str) -> str:
     """
     Set equalizer band gains.
@@ -31,9 +40,8 @@ def set_equalizer_gains(gains: str) -> str:
     _log_tool(f"invoked with gains='{gains}'")
     try:
         # Check if it's a preset
-        presets = ["flat", "bass", "treble", "vshape"]
-        if gains.lower() in presets:
-            cmd = ["python3", "test_set_gains.py", "--preset", gains.lower()]
+        if gains.lower() in PRESETS:
+            gain_list = PRESETS[gains.lower()]
         else:
             # Parse as individual gains
             gain_list = gains.split()
@@ -41,26 +49,40 @@ def set_equalizer_gains(gains: str) -> str:
                 msg = "ERROR: Need exactly 10 gains or a preset name (flat/bass/treble/vshape)"
                 _log_tool(msg)
                 return msg
-            cmd = ["python3", "test_set_gains.py"] + gain_list
-        
-        result = subprocess.run(cmd, cwd="/home/minhnb/Equalizer_Agent/agent", capture_output=True, text=True, timeout=5)
-        if result.returncode == 0:
-            msg = f"✓ Gains set successfully. {result.stdout.strip()}"
-            _log_tool(msg)
-            return msg
+            gain_list = [float(g) for g in gain_list]
+
+        reply = _client.set_gains(gain_list)
+        if reply == "OK":
+            msg = f"✓ Gains set successfully. Server response: {reply}"
         else:
-            msg = f"✗ Error: {result.stderr.strip()}"
-            _log_tool(msg)
-            return msg
+            msg = f"✗ Error: server rejected gains ({reply})"
+        _log_tool(msg)
+        return msg
     except Exception as e:
         msg = f"Error: {str(e)}"
         _log_tool(msg)
         return msg
 
+def get_equalizer_state() -> str:
+    """
+    Read the equalizer's current state.
+    Returns:
+        JSON with the band gains in dB, bypass, whether audio is running,
+        latency and the output peak/RMS levels in dBFS per channel
+    """
+    state = read_shared_state()
+    if state is None:
+        try:
+            state = _client.get("gains")
+        except Exception as e:
+            return f"Error: equalizer not reachable ({e})"
+    return json.dumps(state)
+
 # --- Initialize Agent ---
 
 # Tools for the agent
 set_gains_tool = FunctionTool(set_equalizer_gains)
+state_tool = FunctionTool(get_equalizer_state)
 
 # Main agent
 root_agent = Agent(
@@ -89,6 +111,8 @@ Examples of when to use the tool:
 - User says "increase 31hz" → Use set_equalizer_gains with custom values starting with higher first value
 - User says "tune something random" → Create random but reasonable values and apply them
 
+To see the current settings or how loud the output is, call get_equalizer_state.
+
 Always explain (very shortly) what you're doing BEFORE calling the tool, then confirm the changes after.''',
-    tools=[set_gains_tool]
+    tools=[set_gains_tool, state_tool]
 )
@@ -4,13 +4,12 @@
 import asyncio
 import json
 import logging
-import socket
-import threading
 from pathlib import Path
 
 from dotenv import load_dotenv
 
 from agent import root_agent
+from google.adk.agents.run_config import RunConfig, StreamingMode
 from google.adk.apps.app import App
 from google.adk.artifacts.in_memory_artifact_service import InMemoryArtifactService
 from google.adk.auth.credential_service.in_memory_credential_service import InMemoryCredentialService
@@ -31,22 +30,25 @@ log = logging.getLogger("chat_agent")
 
 
 class ChatAgent:
+    """Serves chat turns as JSON lines: {"message"} in, {"delta"}... {"response"} out."""
+
     def __init__(self, host: str = 'localhost', port: int = 5555) -> None:
         self.host = host
         self.port = port
-        self.server = None
-        self.running = True
         self.session_service = None
         self.session = None
         self.runner = None
+        # One session: turns from several clients take their turn
+        self.turn_lock = None
 
-    async def _invoke_agent_async(self, user_input: str) -> str:
-        """Invoke the agent via Runner so session history persists."""
+    async def _invoke_agent_async(self, user_input: str, send_delta) -> str:
+        """Invoke the agent via Runner so session history persists, streaming text as it comes."""
         log.info("[agent] Invoking with user_input='%s'", user_input)
 
         content = genai_types.Content(role='user', parts=[genai_types.Part(text=user_input)])
 
         full_response = ""
+        streamed = ""  # Partial text of the model turn in progress
         event_count = 0
 
         async with Aclosing(
@@ -54,68 +56,82 @@ class ChatAgent:
                 user_id=self.session.user_id,
                 session_id=self.session.id,
                 new_message=content,
+                run_config=RunConfig(streaming_mode=StreamingMode.SSE),
             )
         ) as agen:
             async for event in agen:
                 event_count += 1
-                if event.content and event.content.parts:
-                    for part in event.content.parts:
-                        if getattr(part, "text", None):
-                            full_response += part.text
+                if not (event.content and event.content.parts):
+                    continue
+                text = "".join(part.text for part in event.content.parts if getattr(part, "text", None))
+                if not text:
+                    continue
+                if event.partial:
+                    streamed += text
+                    await send_delta(text)
+                else:
+                    # The whole turn: what was just streamed, or a turn that was not
+                    if not streamed:
+                        await send_delta(text)
+                    full_response += text
+                    streamed = ""
+        full_response += streamed
 
         log.info("Total events: %s, Response length: %s", event_count, len(full_response))
         return full_response if full_response else "I couldn't generate a response."
 
-    async def process_message_async(self, user_input: str) -> str:
+    async def process_message_async(self, user_input: str, send_delta) -> str:
         """Invoke the AI agent for one user turn."""
         try:
-            return await self._invoke_agent_async(user_input)
+            async with self.turn_lock:
+                return await self._invoke_agent_async(user_input, send_delta)
         except Exception as e:
             log.exception("Agent error: %s", e)
             return f"Error: {str(e)[:200]}"
 
-    def process_message(self, user_input: str) -> str:
-        """Sync wrapper for agent invocation (per client thread)."""
-        loop = asyncio.new_event_loop()
-        try:
-            asyncio.set_event_loop(loop)
-            return loop.run_until_complete(self.process_message_async(user_input))
-        finally:
-            loop.close()
-
-    def handle_client(self, conn, addr) -> None:
-        """Handle one TCP client connection."""
+    async def handle_client(self, reader: asyncio.StreamReader, writer: asyncio.StreamWriter) -> None:
+        """Handle one client connection: one JSON message per line, answered in order."""
+        addr = writer.get_extra_info('peername')
         log.info("Client connected: %s", addr)
+
+        async def send(obj) -> None:
+            writer.write((json.dumps(obj) + "\n").encode('utf-8'))
+            await writer.drain()
+
+        async def send_delta(text: str) -> None:
+            await send({"delta": text})
+
         try:
-            while self.running:
-                data = conn.recv(1024)
-                if not data:
+            while True:
+                line = await reader.readline()
+                if not line:
                     break
-
-                message = data.decode('utf-8').strip()
+                raw = line.decode('utf-8', errors='replace').strip()
+                if not raw:
+                    continue
+                try:
+                    message = json.loads(raw).get("message", "")
+                except (ValueError, AttributeError):
+                    message = raw  # Plain text from a simple client
                 if not message:
                     continue
                 log.info("[%s] Received: %s", addr, message)
 
-                response = self.process_message(message)
+                response = await self.process_message_async(message, send_delta)
                 log.info("[%s] Responding: %s...", addr, response[:100])
-
-                conn.sendall(json.dumps({"response": response}).encode('utf-8'))
+                await send({"response": response})
+        except (ConnectionError, asyncio.IncompleteReadError) as e:
+            log.info("Client %s dropped: %s", addr, e)
         except Exception as e:
             log.exception("Client error: %s", e)
         finally:
-            conn.close()
+            writer.close()
             log.info("Client disconnected: %s", addr)
 
-    def start(self) -> None:
-        """Start the TCP server and initialize session with initial greeting."""
-        loop = asyncio.new_event_loop()
-        asyncio.set_event_loop(loop)
-        
+    async def serve(self) -> None:
+        """Initialize the session, then serve clients until cancelled."""
         self.session_service = InMemorySessionService()
-        self.session = loop.run_until_complete(
-            self.session_service.create_session(app_name='EQ_Chat', user_id='chat_user')
-        )
+        self.session = await self.session_service.create_session(app_name='EQ_Chat', user_id='chat_user')
 
         app = App(name='EQ_Chat', root_agent=root_agent)
         self.runner = Runner(
@@ -125,27 +141,23 @@ class ChatAgent:
             memory_service=InMemoryMemoryService(),
             credential_service=InMemoryCredentialService(),
         )
+        self.turn_lock = asyncio.Lock()
 
-        loop.close()
-
-        self.server = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
-        self.server.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
-        self.server.bind((self.host, self.port))
-        self.server.listen(5)
+        server = await asyncio.start_server(self.handle_client, self.host, self.port, reuse_address=True)
 
         log.info("Chat Agent listening on %s:%s", self.host, self.port)
         log.info("AI Agent ready with SetEqualizerGains tool!")
 
+        async with server:
+            await server.serve_forever()
+
+    def start(self) -> None:
+        """Run the server until interrupted."""
         try:
-            while self.running:
-                conn, addr = self.server.accept()
-                thread = threading.Thread(target=self.handle_client, args=(conn, addr), daemon=True)
-                thread.start()
+            asyncio.run(self.serve())
         except KeyboardInterrupt:
             log.info("Shutting down...")
-        finally:
-            self.server.close()
 
 
 if __name__ == '__main__':
-    ChatAgent().start()
\ No newline at end of file
+    ChatAgent().start()
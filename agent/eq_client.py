@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Client for the equalizer's local control endpoints.
+
+Requests go over the Unix domain socket on one persistent connection (TCP on
+127.0.0.1:5560 when the socket is not there). The gains, bypass flag and
+output meters are read straight from the shared-memory block, with no round
+trip at all. See "Control Protocol" in AI_equalizer/README.md.
+"""
+import json
+import math
+import mmap
+import os
+import socket
+import struct
+import tempfile
+import threading
+
+DEFAULT_PORT = 5560
+SOCKET_NAME = "ai_equalizer.sock"
+SHM_PATH = "/dev/shm/ai_equalizer"
+
+PRESETS = {
+    "flat":   [0, 0, 0, 0, 0, 0, 0, 0, 0, 0],
+    "bass":   [4, 3, 2, 1, 0, 0, -1, -2, -3, -4],
+    "treble": [-4, -3, -2, -1, 0, 0, 1, 2, 3, 4],
+    "vshape": [3, 2, 1, 0, -1, -2, 1, 2, 3, 4],
+}
+
+# Shared block layout (sharedcontrol.h)
+_MAGIC = 0x51454941
+_VERSION = 2
+_BLOCK_SIZE = 512
+_STATE_SEQUENCE = 64
+_STATE = struct.Struct("<5If32f8f8f")  # applied, bandCount, bypass, running, channels, latencyMs, gains, peak, rms
+_STATE_OFFSET = 68
+_READ_ATTEMPTS = 64
+
+
+def default_socket_path():
+    directory = os.environ.get("XDG_RUNTIME_DIR") or tempfile.gettempdir()
+    return os.path.join(directory, SOCKET_NAME)
+
+
+def _to_db(level):
+    return round(20.0 * math.log10(level), 1) if level > 0 else None
+
+
+def read_shared_state(path=SHM_PATH):
+    """Returns the equalizer's state as a dict, or None if it is not running."""
+    try:
+        with open(path, "rb") as f:
+            block = mmap.mmap(f.fileno(), _BLOCK_SIZE, prot=mmap.PROT_READ)
+    except (OSError, ValueError):
+        return None
+    try:
+        magic, version = struct.unpack_from("<2I", block, 0)
+        if magic != _MAGIC or version != _VERSION:
+            return None
+        # Seqlock: retry while the equalizer is writing
+        for _ in range(_READ_ATTEMPTS):
+            (before,) = struct.unpack_from("<I", block, _STATE_SEQUENCE)
+            if before & 1:
+                continue
+            fields = _STATE.unpack_from(block, _STATE_OFFSET)
+            (after,) = struct.unpack_from("<I", block, _STATE_SEQUENCE)
+            if before == after:
+                break
+        else:
+            return None
+    finally:
+        block.close()
+
+    applied, band_count, bypass, running, channels, latency_ms = fields[:6]
+    gains = fields[6:38]
+    peak = fields[38:46]
+    rms = fields[46:54]
+    return {
+        "gains": [round(g, 2) for g in gains[:band_count]],
+        "bypass": bool(bypass),
+        "running": bool(running),
+        "latency_ms": round(latency_ms, 1),
+        "peak_db": [_to_db(p) for p in peak[:channels]],
+        "rms_db": [_to_db(r) for r in rms[:channels]],
+        "applied": applied,
+    }
+
+
+class EqualizerClient:
+    """One connection to the equalizer, reopened when it drops. Thread-safe."""
+
+    def __init__(self, socket_path=None, host="127.0.0.1", port=DEFAULT_PORT, timeout=3.0):
+        self.socket_path = socket_path or default_socket_path()
+        self.host = host
+        self.port = port
+        self.timeout = timeout
+        self._sock = None
+        self._reader = None
+        self._lock = threading.Lock()
+
+    def _connect(self):
+        try:
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            sock.settimeout(self.timeout)
+            sock.connect(self.socket_path)
+        except OSError:
+            sock.close()
+            sock = socket.create_connection((self.host, self.port), timeout=self.timeout)
+            sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self._sock = sock
+        self._reader = sock.makefile("rb")
+
+    def close(self):
+        with self._lock:
+            self._close()
+
+    def _close(self):
+        if self._reader:
+            self._reader.close()
+        if self._sock:
+            self._sock.close()
+        self._sock = None
+        self._reader = None
+
+    def request(self, message):
+        """Sends one JSON request and returns the reply line."""
+        line = (json.dumps(message, separators=(",", ":")) + "\n").encode("utf-8")
+        with self._lock:
+            # A connection the equalizer closed is only noticed on use: retry once
+            for attempt in range(2):
+                try:
+                    if self._sock is None:
+                        self._connect()
+                    self._sock.sendall(line)
+                    reply = self._reader.readline()
+                    if not reply:
+                        raise ConnectionError("connection closed by the equalizer")
+                    return reply.decode("utf-8", errors="replace").strip()
+                except OSError:
+                    self._close()
+                    if attempt == 1:
+                        raise
+
+    def set_gains(self, gains):
+        return self.request([float(g) for g in gains])
+
+    def set_bypass(self, enabled):
+        return self.request({"bypass": bool(enabled)})
+
+    def get(self, what):
+        reply = self.request({"get": what})
+        return json.loads(reply) if reply != "ERROR" else None